@@ -18,6 +18,9 @@ typedef enum
 
 #define C_MAX_ERROR_LEN 512
 
+// nodes of at most this number of pointers are recycled by c_context_deallocate_node
+#define C_MAX_RECYCLED_NODE_SIZE 4
+
 typedef struct _c_error_handler
 {
         void(*on_error)(void*, c_error_severity, c_location, const char*);
@@ -26,9 +29,14 @@ typedef struct _c_error_handler
 typedef struct _c_context
 {
         struct stack_alloc alloc;
+        // lists of deallocated nodes for every size in pointers
+        void* free_nodes[C_MAX_RECYCLED_NODE_SIZE];
         tree_context* tree;
         c_source_manager source_manager;
         c_lang_opts lang_opts;
+        // header of -include-pch which is lexed before every source file or NULL,
+        // it is preprocessed text with #define lines, not serialized tokens or trees
+        file_entry* pch;
         c_error_handler* error_handler;
         bool errors_disabled;
 } c_context;
@@ -49,9 +57,34 @@ extern void c_error(
         const char* format,
         ...);
 
+static inline size_t c_context_get_node_size_class(size_t bytes)
+{
+        return bytes ? (bytes - 1) / sizeof(void*) : 0;
+}
+
 static inline void* c_context_allocate_node(c_context* self, size_t bytes)
 {
-        return stack_alloc(&self->alloc, bytes);
+        size_t size_class = c_context_get_node_size_class(bytes);
+        if (size_class >= C_MAX_RECYCLED_NODE_SIZE)
+                return stack_alloc(&self->alloc, bytes);
+
+        void* node = self->free_nodes[size_class];
+        if (!node)
+                return stack_alloc(&self->alloc, (size_class + 1) * sizeof(void*));
+
+        self->free_nodes[size_class] = *(void**)node;
+        return node;
+}
+
+// makes the memory of the node available to subsequent allocations of the same size
+static inline void c_context_deallocate_node(c_context* self, void* node, size_t bytes)
+{
+        size_t size_class = c_context_get_node_size_class(bytes);
+        if (!node || size_class >= C_MAX_RECYCLED_NODE_SIZE)
+                return;
+
+        *(void**)node = self->free_nodes[size_class];
+        self->free_nodes[size_class] = node;
 }
 
 #endif
@@ -7,13 +7,38 @@
 
 typedef struct _c_source_manager c_source_manager;
 typedef struct _c_context c_context;
+typedef struct _c_source_lines c_source_lines;
+
+// line marker of a preprocessed source: # <line> "<file>"
+// the line beginning at loc is the line of the file
+typedef struct
+{
+        tree_location loc;
+        int line;
+        const char* file;
+        // line of the source at loc, 0 until it is looked up
+        int source_line;
+} c_line_marker;
+
+#define VEC c_line_marker_vec
+#define VEC_T c_line_marker
+#include "scc/core/vec.inc"
 
 typedef struct _c_source
 {
         file_entry* file;
         tree_location begin;
         tree_location end;
-        struct u32vec* lines;
+        // locations of line beginnings, built from the file contents
+        // when a line of the source is requested for the first time
+        c_source_lines* lines;
+        // sorted by location
+        struct c_line_marker_vec line_markers;
+        // macro that guards the whole source against multiple inclusion
+        // or TREE_INVALID_ID if the source is not guarded
+        tree_id guard_macro;
+        // the source contains #pragma once
+        bool once;
 } c_source;
 
 extern bool c_source_has(const c_source* self, tree_location loc);
@@ -21,18 +46,27 @@ extern bool c_source_has(const c_source* self, tree_location loc);
 extern int c_source_get_line(const c_source* self, tree_location loc);
 // returns 0 if location is invalid
 extern int c_source_get_col(const c_source* self, tree_location loc);
-// assumes that loc is beginning of a line
-extern void c_source_save_line_loc(c_source* self, tree_location loc);
+// makes lines beginning at loc and after it to be reported as lines of the file
+// starting with the given one
+extern void c_source_add_line_marker(c_source* self, tree_location loc, int line, const char* file);
 extern const char* c_source_get_name(const c_source* self);
 extern file_entry* c_source_get_file(c_source* self);
 extern tree_location c_source_get_loc_begin(const c_source* self);
 extern tree_location c_source_get_loc_end(const c_source* self);
 
+#define STRHTAB c_source_path_map
+#define STRHTAB_V c_source*
+#include "scc/core/strhtab.inc"
+
 typedef struct _c_source_manager
 {
         file_lookup* lookup;
-        struct hashmap file_to_source;
+        // file path -> source
+        struct c_source_path_map file_to_source;
+        // sorted by location
         struct vec sources;
+        // source found by the last c_source_find_by_loc
+        c_source* last_source;
 } c_source_manager;
 
 extern void c_source_manager_init(
@@ -51,6 +85,7 @@ typedef struct _c_location
         const char* file;
 } c_location;
 
+extern c_source* c_source_find_by_loc(const c_source_manager* self, tree_location loc);
 extern errcode c_source_find_loc(const c_source_manager* self, c_location* res, tree_location loc);
 
 #endif
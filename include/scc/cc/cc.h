@@ -4,6 +4,8 @@
 #include "scc/core/file.h"
 #include "scc/core/vec.h"
 
+#define CC_VERSION "0.1"
+
 typedef enum
 {
         CTK_X86_32,
@@ -16,10 +18,13 @@ typedef enum
         COK_EXEC,
         COK_OBJ,
         COK_LEXEMES,
+        // preprocessed C
+        COK_PREPROCESSED,
         COK_C,
         COK_SSA,
         COK_ASM,
         COK_LLVM_IR,
+        COK_PCH,
 } cc_output_kind;
 
 typedef struct
@@ -29,9 +34,13 @@ typedef struct
         struct vec libs;
         struct vec implicit_libs;
         struct vec obj_files;
+        // directories given with -I, they are also in source_lookup
+        struct vec include_dirs;
         file_lookup source_lookup;
         file_lookup lib_lookup;
         file_entry* tm_decls;
+        // precompiled header included before every source or NULL
+        file_entry* pch;
         const char* llc_path;
         const char* lld_path;
         const char* entry;
@@ -43,18 +52,29 @@ typedef struct
         FILE* message;
         FILE* file;
         const char* file_path;
+        // cached objects of input.builtin_sources, set when they are compiled
+        struct vec builtin_obj_files;
 } cc_output;
 
 typedef struct
 {
         cc_target_kind target;
         const char* name;
+        // number of translation units compiled in parallel
+        unsigned num_jobs;
+        // directory of the compilation cache or NULL
+        const char* cache_dir;
+        // pass LLVM IR to llc through a pipe instead of a temporary file
+        bool pipe;
 
         struct
         {
                 bool eliminate_dead_code;
                 bool fold_constants;
                 bool promote_allocas;
+                bool inline_functions;
+                bool propagate_constants;
+                bool eliminate_common_subexpressions;
                 unsigned level;
         } optimization;
 
@@ -79,11 +99,26 @@ typedef struct
         } ext;
 } cc_opts;
 
+// LLVM tools found when they are needed first and reused for the rest of the run
+typedef struct
+{
+        // guards the lookup, translation units are compiled in parallel
+        struct mutex lock;
+        bool llc_detected;
+        bool llc_found;
+        bool llc_is_clang;
+        struct pathbuf llc;
+        // hash of the path and the version of llc, see cc_get_llc_key
+        bool llc_key_detected;
+        uint64_t llc_key;
+} cc_toolchain;
+
 typedef struct _cc_instance
 {
         cc_input input;
         cc_output output;
         cc_opts opts;
+        cc_toolchain toolchain;
 } cc_instance;
 
 extern void cc_init(cc_instance* self, FILE* message);
@@ -95,8 +130,10 @@ extern errcode cc_set_output_file(cc_instance* self, const char* file);
 extern void cc_add_lib_dir(cc_instance* self, const char* dir);
 extern errcode cc_add_lib(cc_instance* self, const char* lib, bool is_implicit);
 extern void cc_add_source_dir(cc_instance* self, const char* dir);
+extern void cc_add_include_dir(cc_instance* self, const char* dir);
 extern errcode cc_add_source_file(cc_instance* self, const char* file, bool builtin);
 extern errcode cc_add_obj_file(cc_instance* self, const char* file);
+extern errcode cc_set_pch(cc_instance* self, const char* file);
 extern errcode cc_emulate_source_file(
         cc_instance* self, const char* file, const char* content, bool builtin, bool add_to_input);
 
@@ -17,7 +17,11 @@ enum
         LLC_X64,
 };
 
+#ifdef _WIN32
 #define LLC_NATIVE_NAME "llc.exe"
+#else
+#define LLC_NATIVE_NAME "llc"
+#endif
 #define LLC_MAX_OPTS 64
 
 struct llc
@@ -25,6 +29,7 @@ struct llc
         struct pathbuf path;
         char opts[LLC_MAX_OPTS];
         int num_opts;
+        // NULL if the module is read from the standard input
         const char* input;
         const char* output;
         int is_clang;
@@ -36,13 +41,23 @@ void llc_add_opt(struct llc* self, int opt);
 void llc_set_input(struct llc* self, const char* in);
 void llc_set_output(struct llc* self, const char* out);
 int llc_run(struct llc* self);
+// starts llc which reads the module from the returned stream instead of the input file
+FILE* llc_open(struct llc* self);
+// waits for llc started by llc_open and returns its exit code
+int llc_close(FILE* input);
+// writes the beginning of the output of llc --version to version
+bool llc_get_version(struct llc* self, char* version, size_t size);
 
 enum
 {
         LLD_DEBUG_FULL,
 };
 
+#ifdef _WIN32
 #define LLD_NATIVE_NAME "lld-link.exe"
+#else
+#define LLD_NATIVE_NAME "lld-link"
+#endif
 #define LLD_MAX_OPTS 64
 
 struct lld
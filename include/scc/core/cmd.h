@@ -2,6 +2,7 @@
 #define CMD_H
 
 #include "common.h"
+#include <stdio.h>
 
 struct arg_handler
 {
@@ -28,5 +29,11 @@ void run_arg_parser(struct arg_parser* self,
         const struct arg_handler* unknown);
 
 int execute(const char* path, int argc, const char** argv);
+// starts the command which reads its standard input from the returned stream, NULL on failure
+FILE* execute_with_input(const char* path, int argc, const char** argv);
+// starts the command whose standard output is read from the returned stream, NULL on failure
+FILE* execute_with_output(const char* path, int argc, const char** argv);
+// closes the input or the output of the command and returns its exit code
+int wait_execute(FILE* input);
 
 #endif
@@ -4,6 +4,7 @@
 #include "buf-io.h"
 #include "common.h"
 #include "hashmap.h"
+#include "thread.h"
 
 #define MAX_PATH_LEN 255
 
@@ -25,20 +26,42 @@ const char* pathext(const char* path);
 
 size_t fs_filesize(const char* path);
 int fs_delfile(const char* file);
+int fs_copyfile(const char* from, const char* to);
+// creates the directory of the current user for temporary files if needed
+int fs_usertmpdir(struct pathbuf* path);
+// a name for a file which is renamed to path once it is complete
+void fs_tmpname(struct pathbuf* tmp, const char* path);
+
+typedef struct _file_lookup file_lookup;
 
 typedef struct _file_entry
 {
+        file_lookup* lookup;
         char* path;
         int is_virtual;
         char* virtual_content;
+        // contents of a non-virtual file, mapped into memory on first use
+        // and kept until the owning file_lookup is disposed
+        char* mapped_content;
+        size_t mapped_size;
 } file_entry;
 
 extern size_t file_size(const file_entry* entry);
+// returns contents of the file as a contiguous range of *size bytes (not
+// null-terminated) or NULL if the file cannot be read
+extern const char* file_map(file_entry* entry, size_t* size);
+
+#define STRHTAB file_path_map
+#define STRHTAB_V file_entry*
+#include "strhtab.inc"
 
+// file_lookup can be shared by translation units compiled on different threads
 typedef struct _file_lookup
 {
-        struct hashmap lookup;
+        // absolute path -> file
+        struct file_path_map lookup;
         struct dirs* dirs;
+        struct mutex lock;
 } file_lookup;
 
 extern void flookup_init(file_lookup* self);
@@ -57,5 +80,7 @@ extern bool file_exists(file_lookup* lookup, const char* path);
 extern file_entry* file_get(file_lookup* lookup, const char* path);
 extern file_entry* file_emulate(
         file_lookup* lookup, const char* path, const char* content);
+// removes a file returned by file_emulate from its lookup and deletes it
+extern void file_drop_emulated(file_entry* entry);
 
 #endif
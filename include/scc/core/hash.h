@@ -67,4 +67,18 @@ static inline uint32_t strhash(const char* s)
         return hash(s, strlen(s) + 1);
 }
 
+#define HASH64_INIT 14695981039346656037ULL
+
+// FNV-1a, data can be hashed in chunks by passing the hash of the previous ones as h
+static inline uint64_t hash64(uint64_t h, const void* data, size_t len)
+{
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < len; i++)
+        {
+                h ^= bytes[i];
+                h *= 1099511628211ULL;
+        }
+        return h;
+}
+
 #endif
@@ -2,7 +2,7 @@
 #define STRPOOL_H
 
 #include "allocator.h"
-#include "hashmap.h"
+#include "vec.h"
 
 struct strentry
 {
@@ -10,9 +10,15 @@ struct strentry
         char data[];
 };
 
+#define STRHTAB strpool_map
+#define STRHTAB_V unsigned
+#include "strhtab.inc"
+
+// refs are 1-based indices of the stored strings, 0 refers to the empty string
 struct strpool
 {
-        struct hashmap map;
+        struct strpool_map map;
+        struct vec entries;
         struct stack_alloc alloc;
 };
 
@@ -0,0 +1,40 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#include "common.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+struct thread
+{
+#ifdef _WIN32
+        void* handle;
+#else
+        pthread_t handle;
+#endif
+        void(*entry)(void*);
+        void* data;
+};
+
+void thread_init(struct thread* self, void(*entry)(void*), void* data);
+int thread_start(struct thread* self);
+void thread_wait(const struct thread* self);
+unsigned num_hardware_threads(void);
+
+struct mutex
+{
+#ifdef _WIN32
+        void* lock; // SRWLOCK
+#else
+        pthread_mutex_t lock;
+#endif
+};
+
+void mutex_init(struct mutex* self);
+void mutex_drop(struct mutex* self);
+void mutex_lock(struct mutex* self);
+void mutex_release(struct mutex* self);
+
+#endif
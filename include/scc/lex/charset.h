@@ -46,6 +46,19 @@ static inline bool c_char_is_space(int c)
         return c_char_is(c, CCK_SPACE);
 }
 
+// The following functions scan the contiguous text in [pos, end) and return the
+// position of the first character which stops the scan, or end.
+// They process the text in 16-byte blocks when SSE2 is available.
+
+// stops at the first character which is neither a letter nor a digit
+extern const char* c_char_skip_identifier(const char* pos, const char* end);
+// stops at the first character other than ' ' and '\t'
+extern const char* c_char_skip_spaces(const char* pos, const char* end);
+// stops at '\n', '\r' or '\\'
+extern const char* c_char_skip_line_comment(const char* pos, const char* end);
+// stops at '*', '\n', '\r' or '\\'
+extern const char* c_char_skip_block_comment(const char* pos, const char* end);
+
 static inline bool c_char_is_escape(int c)
 {
         switch (c)
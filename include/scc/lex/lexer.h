@@ -4,6 +4,7 @@
 #include "preprocessor.h"
 #include "token.h"
 #include "reswords.h"
+#include "scc/core/buf-io.h"
 #include <stdio.h>
 
 typedef struct _file_entry file_entry;
@@ -16,10 +17,26 @@ typedef struct _c_lexer
 
 extern void c_lexer_init(c_lexer* self, c_context* context);
 extern errcode c_lexer_enter_source_file(c_lexer* self, c_source* source);
+// enters c_context::pch, if any, so it is lexed as if it was included
+// at the beginning of the source file entered before
+extern errcode c_lexer_enter_pch(c_lexer* self);
 extern void c_lexer_dispose(c_lexer* self);
 
 extern c_token* c_lex(c_lexer* self);
 
 extern errcode c_lex_source(c_context* context, file_entry* source, FILE* error, struct vec* result);
+// writes preprocessed tokens of the source as C text which can be parsed again,
+// each token is written as soon as it is preprocessed.
+// if line_markers is set, tokens are kept on their lines and line markers
+// (# <line> "<file>") are written where the source or the line changes
+extern errcode c_preprocess_source(
+        c_context* context,
+        file_entry* source,
+        c_pragma_handlers handlers,
+        bool line_markers,
+        struct buf_writer* output);
+// writes preprocessed tokens of the source followed by definitions of all macros
+// which are defined at the end of it, see c_context::pch
+extern errcode c_emit_pch(c_context* context, file_entry* source, struct buf_writer* output);
 
 #endif
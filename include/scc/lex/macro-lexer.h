@@ -6,26 +6,64 @@
 
 typedef struct _c_context c_context;
 typedef struct _c_macro c_macro;
-typedef struct _c_macro_args c_macro_args;
 typedef struct _c_token c_token;
 typedef struct _c_reswords c_reswords;
 
-typedef struct _c_macro_lexer
+typedef struct
+{
+        size_t begin;
+        size_t end;
+} c_macro_arg;
+
+#define VEC c_macro_arg_vec
+#define VEC_T c_macro_arg
+#include "scc/core/vec.inc"
+
+// Arguments of a function-like macro invocation.
+// Tokens of all arguments are stored in one array, the argument i is the span args[i] of it.
+typedef struct _c_macro_args
 {
-        c_token** pos;
         struct vec tokens;
+        struct c_macro_arg_vec args;
+        c_context* context;
+} c_macro_args;
+
+extern void c_macro_args_init(c_macro_args* self, c_context* context);
+extern void c_macro_args_dispose(c_macro_args* self);
+extern void c_macro_args_add(c_macro_args* self, size_t arg, c_token* token);
+extern void c_macro_args_set_empty(c_macro_args* self, size_t arg);
+extern void c_macro_args_get(const c_macro_args* self, size_t arg, c_token*** begin, c_token*** end);
+
+// position in the expansion of a macro
+typedef struct
+{
+        // next token of the macro body
+        size_t pos;
+        // remaining tokens of the argument being substituted
+        c_token** arg_pos;
+        c_token** arg_end;
+} c_macro_cursor;
+
+// Expands the macro by walking its body and the spans of the arguments,
+// which are substituted in place of the parameters without copying them.
+typedef struct _c_macro_lexer
+{
+        c_macro_cursor cursor;
+        c_macro_args args;
         c_context* context;
         c_macro* macro;
         tree_location loc;
 } c_macro_lexer;
 
+// takes ownership of the arguments
 extern void c_macro_lexer_init(
         c_macro_lexer* self,
         c_context* context,
         c_macro* macro,
+        c_macro_args* args,
         tree_location loc);
 
-extern errcode c_macro_lexer_substitute_macro_args(c_macro_lexer* self, c_macro_args* args);
+extern void c_macro_lexer_dispose(c_macro_lexer* self);
 extern c_token* c_macro_lexer_lex_token(c_macro_lexer* self);
 
 #endif
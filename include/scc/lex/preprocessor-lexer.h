@@ -15,6 +15,29 @@ typedef struct
 extern void c_init_cond_directive(
         c_cond_directive* self, c_token* token, bool condition, bool has_body);
 
+// Tracks whether a source has the form
+//      #ifndef MACRO
+//      ...
+//      #endif
+// with nothing but white spaces and comments outside of the conditional.
+typedef enum
+{
+        // only white spaces and comments were read so far
+        CIGS_START,
+        // inside of the top-level #ifndef
+        CIGS_INSIDE,
+        // after the #endif of the top-level #ifndef
+        CIGS_AFTER,
+        // the source is not guarded
+        CIGS_NONE,
+} c_include_guard_state;
+
+typedef struct
+{
+        c_include_guard_state state;
+        tree_id macro;
+} c_include_guard;
+
 typedef enum
 {
         CPLK_TOKEN,
@@ -34,6 +57,7 @@ typedef struct _c_pp_lexer
                 {
                         c_token_lexer token_lexer;
                         struct c_cond_stack cond_stack;
+                        c_include_guard guard;
                 };
                 c_macro_lexer macro_lexer;
         };
@@ -45,6 +69,7 @@ extern void c_init_pp_macro_token_lexer(
         c_pp_lexer* self,
         c_context* context,
         c_macro* macro,
+        c_macro_args* args,
         tree_location loc);
 
 extern void c_dispose_pp_lexer(c_pp_lexer* self);
@@ -81,6 +106,7 @@ extern c_pp_lexer* c_push_macro_lexer(
         c_lexer_stack* self,
         c_context* context,
         c_macro* macro,
+        c_macro_args* args,
         tree_location loc);
 
 #endif
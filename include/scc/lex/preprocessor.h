@@ -12,14 +12,20 @@ typedef struct _c_preprocessor
         size_t token_lexer_depth;
         c_lexer_stack lexer_stack;
         struct hashmap macro_lookup;
-        const c_reswords* reswords;
+        // sources that were entered, by their first location
+        struct hashmap entered_sources;
+        c_reswords* reswords;
         c_context* context;
         c_pragma_handlers pragma_handlers;
+        // the source has been preprocessed already and is not preprocessed again,
+        // see c_preprocess_preprocessed
+        bool preprocessed;
 
         struct
         {
                 tree_id defined;
                 tree_id link;
+                tree_id once;
         } id;
 
         struct
@@ -36,7 +42,7 @@ typedef struct _c_preprocessor
 } c_preprocessor;
 
 extern void c_preprocessor_init(
-        c_preprocessor* self, const c_reswords* reswords, c_context* context);
+        c_preprocessor* self, c_reswords* reswords, c_context* context);
 
 extern void c_preprocessor_dispose(c_preprocessor* self);
 extern errcode c_preprocessor_enter_source(c_preprocessor* self, c_source* source);
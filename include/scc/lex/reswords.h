@@ -1,23 +1,39 @@
 #ifndef C_RESWORDS_H
 #define C_RESWORDS_H
 
-#include "scc/core/hashmap.h"
+#include "scc/core/common.h"
+
+#define VEC c_resword_cache
+#define VEC_T uint8_t
+#include "scc/core/vec.inc"
 
 typedef struct _c_context c_context;
 
+// keywords and preprocessor directive names are kept in a hash table
+// which has no collisions for the current set of reswords
+#define C_RESWORDS_TABLE_SIZE 128
+
+typedef struct
+{
+        const char* string;
+        uint8_t size;
+        uint8_t kind;
+        uint8_t pp_kind;
+} c_resword;
+
 typedef struct _c_reswords
 {
-        struct hashmap reswords;
-        struct hashmap pp_reswords;
+        c_context* context;
+        // the last entry is never occupied and describes non-reswords
+        c_resword table[C_RESWORDS_TABLE_SIZE + 1];
+        // maps ids of identifiers to their table entries + 1, or 0 if the identifier
+        // is not classified yet, so that every identifier is looked up only once
+        struct c_resword_cache cache;
 } c_reswords;
 
 extern void c_reswords_init(c_reswords* self, c_context* context);
 extern void c_reswords_dispose(c_reswords* self);
-extern void c_reswords_add_resword(c_reswords* self, const char* string, int kind);
-extern void c_reswords_add_pp_resword(c_reswords* self, const char* string, int kind);
-extern int c_reswords_get_resword(const c_reswords* self, const char* string, size_t len);
-extern int c_reswords_get_resword_by_ref(const c_reswords* self, unsigned ref);
-extern int c_reswords_get_pp_resword(const c_reswords* self, const char* string, size_t len);
-extern int c_reswords_get_pp_resword_by_ref(const c_reswords* self, unsigned ref);
+extern int c_reswords_get_resword_by_ref(c_reswords* self, unsigned ref);
+extern int c_reswords_get_pp_resword_by_ref(c_reswords* self, unsigned ref);
 
 #endif
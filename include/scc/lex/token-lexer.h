@@ -2,7 +2,6 @@
 #define C_TOKEN_LEXER_H
 
 #include "scc/c-common/limits.h"
-#include "scc/core/buf-io.h"
 #include "scc/tree/common.h"
 
 typedef struct _c_reswords c_reswords;
@@ -17,12 +16,8 @@ typedef struct _c_token_lexer
 
         struct
         {
-                bool is_file;
-                union
-                {
-                        struct buf_reader reader;
-                        const char* str;      
-                };
+                const char* pos;
+                const char* end;
         } input;
 
         bool angle_string_expected;
@@ -34,7 +29,6 @@ typedef struct _c_token_lexer
         c_context* context;
 
         tree_location loc;
-        int line;
         int tab_to_space;
 } c_token_lexer;
 
@@ -144,6 +144,8 @@ typedef struct _c_token
 extern c_token* c_token_new_pp_num(c_context* context, tree_location loc, tree_id ref);
 extern c_token* c_token_copy(c_context* context, c_token* token);
 extern c_token* c_token_copy_with_new_loc(c_context* context, c_token* token, tree_location new_loc);
+// returns the memory of a token which is no longer referenced to the context
+extern void c_token_delete(c_context* context, c_token* token);
 
 #define C_TOKEN_ASSERT(P, K) assert((P) && c_token_is((P), (K)))
 
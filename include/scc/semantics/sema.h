@@ -96,8 +96,11 @@ extern tree_type* c_sema_get_char_type(c_sema* self);
 extern tree_type* c_sema_get_logical_operation_type(c_sema* self);
 extern tree_type* c_sema_get_type_for_string_literal(c_sema* self, tree_id id);
 
+// the types returned by c_sema_get_* functions are shared and must not be modified
 extern tree_type* c_sema_get_builtin_type(
         c_sema* self, tree_type_quals q, tree_builtin_type_kind k);
+extern tree_type* c_sema_get_qualified_type(c_sema* self, tree_type* type, tree_type_quals q);
+extern tree_type* c_sema_get_pointer_type(c_sema* self, tree_type_quals quals, tree_type* target);
 
 extern tree_type* c_sema_new_decl_type(c_sema* self, tree_decl* d, bool referenced);
 extern tree_type* c_sema_new_typedef_name(c_sema* self, tree_location name_loc, tree_id name);
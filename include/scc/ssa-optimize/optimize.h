@@ -8,6 +8,8 @@ extern void ssa_fold_constants(const ssa_pass* pass);
 extern void ssa_eliminate_dead_code(const ssa_pass* pass);
 extern void ssa_promote_allocas(const ssa_pass* pass);
 extern void ssa_inline_functions(const ssa_pass* pass);
+extern void ssa_propagate_constants(const ssa_pass* pass);
+extern void ssa_eliminate_common_subexpressions(const ssa_pass* pass);
 
 typedef struct _ssa_optimizer_opts
 {
@@ -15,6 +17,8 @@ typedef struct _ssa_optimizer_opts
         bool eliminate_dead_code;
         bool promote_allocas;
         bool inline_functions;
+        bool propagate_constants;
+        bool eliminate_common_subexpressions;
 } ssa_optimizer_opts;
 
 extern void ssa_reset_optimizer_opts(ssa_optimizer_opts* self);
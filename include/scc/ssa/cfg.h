@@ -0,0 +1,127 @@
+#ifndef SSA_CFG_H
+#define SSA_CFG_H
+
+#include "common.h"
+#include "scc/core/vec.h"
+
+typedef struct _ssa_block ssa_block;
+typedef struct _ssa_value ssa_value;
+typedef struct _ssa_loop ssa_loop;
+typedef struct _ssa_cfg_node ssa_cfg_node;
+
+#define HTAB ssa_cfg_node_map
+#define HTAB_K const ssa_block*
+#define HTAB_K_EMPTY (const ssa_block*)0
+#define HTAB_K_DEL (const ssa_block*)1
+#define HTAB_K_TO_U32(K) (unsigned)((size_t)(K) ^ ((size_t)(K) >> 4))
+#define HTAB_V ssa_cfg_node*
+#include "scc/core/htab.inc"
+
+// A natural loop: the header and all blocks which reach a back edge to it
+// without passing through the header.
+struct _ssa_loop
+{
+        ssa_cfg_node* header;
+        // the innermost loop containing this one
+        ssa_loop* parent;
+        // 1 for outermost loops
+        unsigned depth;
+};
+
+struct _ssa_cfg_node
+{
+        ssa_block* block;
+        // position in the reverse postorder, the entry is 0
+        unsigned index;
+        // NULL for the entry
+        ssa_cfg_node* idom;
+        // bounds of the node in the preorder walk of the dominator tree
+        unsigned dom_begin;
+        unsigned dom_end;
+        // the innermost loop containing the node, or NULL
+        ssa_loop* loop;
+        struct vec preds;
+        struct vec succs;
+        // nodes dominated immediately by this one
+        struct vec children;
+        struct vec frontier;
+};
+
+// Control flow graph of a function with the dominator tree, dominance frontiers
+// and natural loops. Only blocks reachable from the entry have nodes.
+// The graph is a snapshot: a pass which changes the control flow has to invalidate it,
+// which the pass manager does after each pass that does not preserve it.
+typedef struct _ssa_cfg
+{
+        ssa_value* function;
+        // nodes in the reverse postorder
+        ssa_cfg_node* nodes;
+        size_t num_nodes;
+        struct vec loops;
+        struct ssa_cfg_node_map map;
+} ssa_cfg;
+
+extern ssa_cfg* ssa_new_cfg(ssa_value* function);
+extern void ssa_delete_cfg(ssa_cfg* self);
+
+// returns NULL if the block is unreachable
+extern ssa_cfg_node* ssa_get_cfg_node(const ssa_cfg* self, const ssa_block* block);
+extern bool ssa_cfg_node_dominates(const ssa_cfg_node* self, const ssa_cfg_node* other);
+extern bool ssa_block_dominates(const ssa_cfg* self, const ssa_block* block, const ssa_block* other);
+extern bool ssa_loop_contains(const ssa_loop* self, const ssa_cfg_node* node);
+
+static inline ssa_cfg_node* ssa_get_cfg_entry(const ssa_cfg* self);
+static inline ssa_cfg_node* ssa_get_cfg_nodes_begin(const ssa_cfg* self);
+static inline ssa_cfg_node* ssa_get_cfg_nodes_end(const ssa_cfg* self);
+static inline unsigned ssa_get_cfg_node_loop_depth(const ssa_cfg_node* self);
+
+// returns the cached graph of the function, building it if needed
+extern ssa_cfg* ssa_get_function_cfg(ssa_value* function);
+extern void ssa_invalidate_function_cfg(ssa_value* function);
+
+#define SSA_FOREACH_CFG_NODE(PCFG, ITNAME)\
+        for (ssa_cfg_node* ITNAME = ssa_get_cfg_nodes_begin(PCFG);\
+                ITNAME != ssa_get_cfg_nodes_end(PCFG); ITNAME++)
+
+#define SSA_FOREACH_CFG_NODE_REVERSE(PCFG, ITNAME)\
+        for (ssa_cfg_node* ITNAME = ssa_get_cfg_nodes_end(PCFG);\
+                ITNAME-- != ssa_get_cfg_nodes_begin(PCFG);)
+
+#define SSA_FOREACH_CFG_NODE_PRED(PNODE, ITNAME, ENDNAME)\
+        for (ssa_cfg_node** ITNAME = (ssa_cfg_node**)vec_begin(&(PNODE)->preds),\
+                **ENDNAME = (ssa_cfg_node**)vec_end(&(PNODE)->preds); ITNAME != ENDNAME; ITNAME++)
+
+#define SSA_FOREACH_CFG_NODE_SUCC(PNODE, ITNAME, ENDNAME)\
+        for (ssa_cfg_node** ITNAME = (ssa_cfg_node**)vec_begin(&(PNODE)->succs),\
+                **ENDNAME = (ssa_cfg_node**)vec_end(&(PNODE)->succs); ITNAME != ENDNAME; ITNAME++)
+
+#define SSA_FOREACH_CFG_NODE_CHILD(PNODE, ITNAME, ENDNAME)\
+        for (ssa_cfg_node** ITNAME = (ssa_cfg_node**)vec_begin(&(PNODE)->children),\
+                **ENDNAME = (ssa_cfg_node**)vec_end(&(PNODE)->children); ITNAME != ENDNAME; ITNAME++)
+
+#define SSA_FOREACH_CFG_NODE_FRONTIER(PNODE, ITNAME, ENDNAME)\
+        for (ssa_cfg_node** ITNAME = (ssa_cfg_node**)vec_begin(&(PNODE)->frontier),\
+                **ENDNAME = (ssa_cfg_node**)vec_end(&(PNODE)->frontier); ITNAME != ENDNAME; ITNAME++)
+
+static inline ssa_cfg_node* ssa_get_cfg_entry(const ssa_cfg* self)
+{
+        assert(self->num_nodes);
+        return self->nodes;
+}
+
+static inline ssa_cfg_node* ssa_get_cfg_nodes_begin(const ssa_cfg* self)
+{
+        return self->nodes;
+}
+
+static inline ssa_cfg_node* ssa_get_cfg_nodes_end(const ssa_cfg* self)
+{
+        return self->nodes + self->num_nodes;
+}
+
+static inline unsigned ssa_get_cfg_node_loop_depth(const ssa_cfg_node* self)
+{
+        return self->loop ? self->loop->depth : 0;
+}
+
+#endif
@@ -35,20 +35,41 @@ static inline tree_context* ssa_get_tree(const ssa_context* self)
         return self->tree;
 }
 
-static inline errcode ssa_resize_array(
+static inline errcode ssa_reserve_array(
         ssa_context* self,
         ssa_array* array,
         const size_t object_size,
-        const size_t new_size)
+        const size_t new_capacity)
 {
-        uint8_t* new_data = alloc(object_size * new_size);
+        if (array->capacity >= new_capacity)
+                return EC_NO_ERROR;
+
+        uint8_t* new_data = alloc(object_size * new_capacity);
         if (!new_data)
                 return EC_ERROR;
 
-        size_t num_objects = new_size < array->size ? new_size : array->size;
-        memcpy(new_data, array->data, num_objects * object_size);
+        memcpy(new_data, array->data, array->size * object_size);
         dealloc(array->data);
         array->data = new_data;
+        array->capacity = new_capacity;
+        return EC_NO_ERROR;
+}
+
+static inline errcode ssa_resize_array(
+        ssa_context* self,
+        ssa_array* array,
+        const size_t object_size,
+        const size_t new_size)
+{
+        if (new_size > array->capacity)
+        {
+                // grow geometrically so that appending n objects takes O(n)
+                size_t new_capacity = array->capacity * 2 + 1;
+                if (new_capacity < new_size)
+                        new_capacity = new_size;
+                if (EC_FAILED(ssa_reserve_array(self, array, object_size, new_capacity)))
+                        return EC_ERROR;
+        }
         array->size = new_size;
         return EC_NO_ERROR;
 }
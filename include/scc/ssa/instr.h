@@ -100,6 +100,8 @@ extern void ssa_add_instr_before(ssa_instr* self, ssa_instr* pos);
 extern void ssa_remove_instr(ssa_instr* self);
 extern void ssa_move_instr(ssa_instr* self, ssa_instr* pos, bool after);
 extern void ssa_set_instr_operand_value(ssa_instr* self, size_t i, ssa_value* val);
+// creates an instruction of the same kind and type as self, operands are not copied
+extern ssa_instr* ssa_clone_instr(ssa_context* context, const ssa_instr* self);
 
 static inline struct _ssa_instr_base* _ssa_instr_base(ssa_instr* self);
 static inline const struct _ssa_instr_base* _ssa_instr_cbase(const ssa_instr* self);
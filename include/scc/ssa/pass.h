@@ -2,6 +2,7 @@
 #define SSA_PASS_H
 
 #include "scc/core/list.h"
+#include <stdbool.h>
 
 typedef struct _ssa_pass ssa_pass;
 typedef struct _ssa_module ssa_module;
@@ -25,6 +26,8 @@ typedef struct _ssa_pass
         ssa_value* function;
         ssa_context* context;
         void(*entry)(const ssa_pass*);
+        // the pass does not change the control flow, so the cached graph stays valid
+        bool preserves_cfg;
 } ssa_pass;
 
 extern void ssa_init_pass(ssa_pass* self, ssa_pass_kind kind, void(*entry)(const ssa_pass*));
@@ -3,6 +3,7 @@
 
 #include "block.h"
 #include "builder.h"
+#include "cfg.h"
 #include "common.h"
 #include "context.h"
 #include "instr.h"
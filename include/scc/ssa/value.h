@@ -12,6 +12,7 @@ typedef struct _ssa_value ssa_value;
 typedef struct _ssa_context ssa_context;
 typedef struct _ssa_block ssa_block;
 typedef struct _ssa_const ssa_const;
+typedef struct _ssa_cfg ssa_cfg;
 
 typedef struct _ssa_value_use
 {
@@ -174,6 +175,8 @@ struct _ssa_function
         tree_decl* entity;
         struct list blocks;
         ssa_array params;
+        // cached control flow graph, see cfg.h
+        ssa_cfg* cfg;
 };
 
 extern ssa_value* ssa_new_function(
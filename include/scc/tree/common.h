@@ -2,6 +2,7 @@
 #define TREE_COMMON_H
 
 #include "scc/core/common.h"
+#include "scc/core/hashmap.h"
 #include "scc/core/strpool.h"
 #include "scc/core/hash.h"
 #include "scc/core/list.h"
@@ -41,12 +42,14 @@ typedef struct _tree_array
 {
         uint8_t* data;
         size_t size;
+        size_t capacity;
 } tree_array;
 
 static TREE_INLINE void tree_init_array(tree_array* self)
 {
         self->data = NULL;
         self->size = 0;
+        self->capacity = 0;
 }
 
 #endif // !TREE_COMMON_H
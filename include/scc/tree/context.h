@@ -7,12 +7,34 @@
 
 typedef struct _tree_target_info tree_target_info;
 
+// maps a type to its uniqued derived type(s)
+#define HTAB tree_type_map
+#define HTAB_K const tree_type*
+#define HTAB_K_EMPTY (const tree_type*)0
+#define HTAB_K_DEL (const tree_type*)1
+#define HTAB_K_TO_U32(K) (unsigned)((size_t)(K) ^ ((size_t)(K) >> 4))
+#define HTAB_V void*
+#include "scc/core/htab.inc"
+
+// maps the signature of a canonical function, array or tag type to the type
+#define STRHTAB tree_type_strhtab
+#define STRHTAB_V tree_type*
+#include "scc/core/strhtab.inc"
+
 typedef struct _tree_context
 {
         struct stack_alloc nodes;
         struct strpool strings;
         tree_target_info* target;
         tree_type builtin_types[TBTK_SIZE];
+        // pointee -> pointer type
+        struct tree_type_map pointer_types;
+        // unmodified type -> variants indexed by tree_type_quals,
+        // followed by the transaction-safe variants of a function type
+        struct tree_type_map qualified_types;
+        // type -> its canonical type, see tree_get_canonical_type
+        struct tree_type_map canonical_types;
+        struct tree_type_strhtab derived_types;
 } tree_context;
 
 extern void tree_init(tree_context* self, tree_target_info* target);
@@ -22,6 +44,21 @@ extern tree_type* tree_get_builtin_type(tree_context* self, tree_builtin_type_ki
 extern tree_type* tree_get_size_type(tree_context* self);
 extern tree_type* tree_get_ptrdiff_type(tree_context* self);
 
+// Returns the unique pointer type to 'target'.
+// The result is shared and must not be modified.
+extern tree_type* tree_get_pointer_type(tree_context* self, tree_type* target);
+
+// Returns the unique 'quals'-qualified variant of 'type'.
+// The result is shared and must not be modified.
+extern tree_type* tree_get_qualified_type(
+        tree_context* self, tree_type* type, tree_type_quals quals);
+
+// Returns the canonical type of 'type': typedefs, parentheses and adjustments are
+// removed, qualifiers and attributes are kept at every level, and equal types share
+// a single node, so they can be compared by pointer. Returns NULL if the type chain
+// is not complete yet. The result is shared and must not be modified.
+extern tree_type* tree_get_canonical_type(tree_context* self, const tree_type* type);
+
 static TREE_INLINE void* tree_allocate_node(tree_context* self, size_t bytes)
 {
         return stack_alloc(&self->nodes, bytes);
@@ -51,17 +88,36 @@ static TREE_INLINE tree_id tree_get_id_for_string(tree_context* self, const char
         return tree_get_id_for_string_s(self, string, strlen(string) + 1);
 }
 
-static void tree_resize_array(
+static void tree_reserve_array(
         tree_context* self,
         tree_array* array,
         const size_t object_size,
-        const size_t new_size)
+        const size_t new_capacity)
 {
-        uint8_t* new_data = alloc(object_size * new_size);
-        size_t num_objects = new_size < array->size ? new_size : array->size;
+        if (array->capacity >= new_capacity)
+                return;
+
+        uint8_t* new_data = alloc(object_size * new_capacity);
         memcpy(new_data, array->data, array->size * object_size);
         dealloc(array->data);
         array->data = new_data;
+        array->capacity = new_capacity;
+}
+
+static void tree_resize_array(
+        tree_context* self,
+        tree_array* array,
+        const size_t object_size,
+        const size_t new_size)
+{
+        if (new_size > array->capacity)
+        {
+                // grow geometrically so that appending n objects takes O(n)
+                size_t new_capacity = array->capacity * 2 + 1;
+                if (new_capacity < new_size)
+                        new_capacity = new_size;
+                tree_reserve_array(self, array, object_size, new_capacity);
+        }
         array->size = new_size;
 }
 
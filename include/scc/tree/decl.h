@@ -162,11 +162,20 @@ struct _tree_tag_decl
         bool complete;
 };
 
+// size and alignment of a complete record, computed by tree_get_record_layout
+typedef struct _tree_record_layout
+{
+        size_t size;
+        size_t align;
+        bool computed;
+} tree_record_layout;
+
 struct _tree_record_decl
 {
         struct _tree_tag_decl base;
         tree_decl_scope fields;
         tree_expr* alignment;
+        tree_record_layout layout;
         bool is_union;
 };
 
@@ -212,6 +221,8 @@ struct _tree_field_decl
         struct _tree_value_decl base;
         tree_expr* bit_width;
         uint index;
+        // valid when the layout of the record is computed
+        size_t offset;
 };
 
 struct _tree_indirect_field_decl
@@ -481,6 +492,8 @@ static TREE_INLINE bool tree_tag_decl_is_complete(const tree_decl* self)
 static TREE_INLINE void tree_set_tag_decl_complete(tree_decl* self, bool complete)
 {
         self->tag.complete = complete;
+        if (tree_decl_is(self, TDK_RECORD))
+                self->record.layout.computed = false;
 }
 
 extern tree_decl* tree_new_record_decl(
@@ -551,6 +564,11 @@ static TREE_INLINE void tree_set_record_union(tree_decl* self, bool val)
         self->record.is_union = val;
 }
 
+static TREE_INLINE tree_record_layout* tree_get_record_layout_cache(tree_decl* self)
+{
+        return &self->record.layout;
+}
+
 extern tree_decl* tree_new_enum_decl(
         tree_context* context, tree_decl_scope* scope, tree_xlocation loc, tree_id name);
 
@@ -716,6 +734,16 @@ static TREE_INLINE void tree_set_field_bit_width(tree_decl* self, tree_expr* bit
         self->field.bit_width = bit_width;
 }
 
+static TREE_INLINE size_t tree_get_field_offset(const tree_decl* self)
+{
+        return self->field.offset;
+}
+
+static TREE_INLINE void tree_set_field_offset(tree_decl* self, size_t offset)
+{
+        self->field.offset = offset;
+}
+
 extern tree_decl* tree_new_indirect_field_decl(
         tree_context* context,
         tree_decl_scope* scope,
@@ -36,4 +36,9 @@ extern size_t tree_get_sizeof(const tree_target_info* info, const tree_type* t);
 extern size_t tree_get_alignof(const tree_target_info* info, const tree_type* t);
 extern size_t tree_get_offsetof(const tree_target_info* info, const tree_decl* field);
 
+// Returns the layout of the record and stores the offsets of its fields.
+// The layout of a complete record is computed once.
+extern const tree_record_layout* tree_get_record_layout(
+        const tree_target_info* info, const tree_decl* record);
+
 #endif // !TREE_TARGET_H
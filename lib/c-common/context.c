@@ -11,8 +11,11 @@ extern void c_context_init(
 {
         self->errors_disabled = false;
         self->tree = tree;
+        self->pch = NULL;
         self->error_handler = error_handler;
         init_stack_alloc(&self->alloc);
+        for (int i = 0; i < C_MAX_RECYCLED_NODE_SIZE; i++)
+                self->free_nodes[i] = NULL;
         c_source_manager_init(&self->source_manager, lookup);
         c_lang_opts_init(&self->lang_opts);
 }
@@ -1,21 +1,133 @@
 #include "scc/c-common/source.h"
 #include "scc/c-common/context.h"
 #include "scc/core/file.h"
-#include "scc/core/hash.h"
-#include "scc/core/hashmap.h"
 #include <string.h>
 
-#define VEC u32vec
-#define VEC_T unsigned
+// Line table.
+// Lines are grouped in blocks of up to C_SOURCE_LINE_BLOCK_SIZE lines, each block stores
+// the location of its first line, and every other line is stored as one byte offset from
+// the previous one. A line which is further than 255 locations from the previous one
+// starts a new block.
+#define C_SOURCE_LINE_BLOCK_SIZE 64
+
+typedef struct
+{
+        tree_location loc;
+        // index of the first line of the block
+        unsigned line;
+} c_source_line_block;
+
+#define VEC c_source_line_block_vec
+#define VEC_T c_source_line_block
+#include "scc/core/vec.inc"
+
+#define VEC u8vec
+#define VEC_T uint8_t
 #include "scc/core/vec.inc"
 
+struct _c_source_lines
+{
+        struct c_source_line_block_vec blocks;
+        // offset of the line from the previous one, 0 for the first line of a block
+        struct u8vec offsets;
+        // the line found by the last lookup, lookups are mostly sequential
+        unsigned last_line;
+        tree_location last_begin;
+        tree_location last_end;
+};
+
+static void c_source_lines_add(c_source_lines* self, tree_location loc, tree_location prev)
+{
+        unsigned line = (unsigned)self->offsets.size;
+        if (line % C_SOURCE_LINE_BLOCK_SIZE == 0 || loc - prev > UINT8_MAX)
+        {
+                c_source_line_block b = { loc, line };
+                c_source_line_block_vec_push(&self->blocks, b);
+                u8vec_push(&self->offsets, 0);
+        }
+        else
+                u8vec_push(&self->offsets, (uint8_t)(loc - prev));
+}
+
+// Builds the line table from the contents of the file in one pass.
+// Locations follow the lexer: "\r\n" is a single location, a single '\r' is a new-line,
+// and a new-line preceded by a backslash is a line splice which does not start a line.
+static c_source_lines* c_source_build_lines(const c_source* self)
+{
+        c_source_lines* lines = alloc(sizeof(*lines));
+        c_source_line_block_vec_init(&lines->blocks);
+        u8vec_init(&lines->offsets);
+
+        size_t size;
+        const char* text = file_map(self->file, &size);
+        if (!text)
+        {
+                text = "";
+                size = 0;
+        }
+
+        tree_location begin = c_source_get_loc_begin(self);
+        tree_location prev = begin;
+        c_source_lines_add(lines, begin, prev);
+
+        if (!memchr(text, '\r', size))
+        {
+                // every byte is a location
+                const char* end = text + size;
+                for (const char* p = text; (p = memchr(p, '\n', end - p)); p++)
+                {
+                        if (p != text && p[-1] == '\\')
+                                continue;
+                        tree_location loc = begin + (tree_location)(p - text) + 1;
+                        c_source_lines_add(lines, loc, prev);
+                        prev = loc;
+                }
+        }
+        else
+        {
+                tree_location loc = begin;
+                for (size_t i = 0; i < size; i++, loc++)
+                {
+                        char c = text[i];
+                        if (c != '\n' && c != '\r')
+                                continue;
+
+                        bool splice = i && text[i - 1] == '\\';
+                        if (c == '\r' && i + 1 < size && text[i + 1] == '\n')
+                                i++;
+                        if (splice)
+                                continue;
+
+                        c_source_lines_add(lines, loc + 1, prev);
+                        prev = loc + 1;
+                }
+        }
+
+        lines->last_line = 0;
+        lines->last_begin = begin;
+        lines->last_end = begin;
+        return lines;
+}
+
+static void c_source_lines_delete(c_source_lines* self)
+{
+        if (!self)
+                return;
+        c_source_line_block_vec_drop(&self->blocks);
+        u8vec_drop(&self->offsets);
+        dealloc(self);
+}
+
 static c_source* c_source_new(c_source_manager* manager, file_entry* entry)
 {
         c_source* s = alloc(sizeof(*s));
         s->begin = TREE_INVALID_LOC;
         s->end = TREE_INVALID_LOC;
         s->file = entry;
-        s->lines = u32vec_new();
+        s->lines = NULL;
+        c_line_marker_vec_init(&s->line_markers);
+        s->guard_macro = TREE_INVALID_ID;
+        s->once = false;
         return s;
 }
 
@@ -23,7 +135,8 @@ static void c_source_delete(c_source_manager* manager, c_source* source)
 {
         if (!source)
                 return;
-        u32vec_del(source->lines);
+        c_source_lines_delete(source->lines);
+        c_line_marker_vec_drop(&source->line_markers);
         dealloc(source);
 }
 
@@ -32,39 +145,98 @@ extern bool c_source_has(const c_source* self, tree_location loc)
         return loc >= c_source_get_loc_begin(self) && loc < c_source_get_loc_end(self);
 }
 
-extern int c_source_get_line(const c_source* self, tree_location loc)
+// finds the line containing loc and returns its index, or -1 if loc is outside of the source
+static int c_source_find_line(const c_source* self, tree_location loc, tree_location* line_begin)
 {
-        // todo: log(n) search
-        size_t nlines = self->lines->size;
-        if (!nlines)
-                return 0;
+        if (!c_source_has(self, loc))
+                return -1;
 
-        for (size_t i = 0; i < nlines; i++) {
-                tree_location cur = self->lines->items[i];
-                tree_location next = c_source_get_loc_end(self);
-                if (i + 1 < nlines)
-                        next = self->lines->items[i + 1];
+        c_source_lines* lines = self->lines;
+        if (!lines)
+                lines = ((c_source*)self)->lines = c_source_build_lines(self);
+
+        if (loc >= lines->last_begin && loc < lines->last_end)
+        {
+                *line_begin = lines->last_begin;
+                return (int)lines->last_line;
+        }
 
-                if (loc >= cur && loc < next)
-                        return (int)(i + 1);
+        // find the last block which begins at or before loc
+        const c_source_line_block* blocks = lines->blocks.items;
+        size_t lo = 0;
+        size_t hi = lines->blocks.size;
+        while (hi - lo > 1)
+        {
+                size_t mid = lo + (hi - lo) / 2;
+                if (blocks[mid].loc <= loc)
+                        lo = mid;
+                else
+                        hi = mid;
+        }
+
+        unsigned line = blocks[lo].line;
+        unsigned block_end = lo + 1 < lines->blocks.size
+                ? blocks[lo + 1].line : (unsigned)lines->offsets.size;
+        tree_location begin = blocks[lo].loc;
+        tree_location end = lo + 1 < lines->blocks.size
+                ? blocks[lo + 1].loc : c_source_get_loc_end(self);
+        for (; line + 1 < block_end; line++)
+        {
+                tree_location next = begin + lines->offsets.items[line + 1];
+                if (next > loc)
+                {
+                        end = next;
+                        break;
+                }
+                begin = next;
         }
 
-        return 0;
+        lines->last_line = line;
+        lines->last_begin = begin;
+        lines->last_end = end;
+        *line_begin = begin;
+        return (int)line;
+}
+
+extern int c_source_get_line(const c_source* self, tree_location loc)
+{
+        tree_location begin;
+        return c_source_find_line(self, loc, &begin) + 1;
 }
 
 extern int c_source_get_col(const c_source* self, tree_location loc)
 {
-        int line = c_source_get_line(self, loc);
-        if (line == 0)
+        tree_location begin;
+        if (c_source_find_line(self, loc, &begin) == -1)
                 return 0;
+        return loc - begin + 1;
+}
+
+extern void c_source_add_line_marker(c_source* self, tree_location loc, int line, const char* file)
+{
+        // a source that is entered again reports the same markers
+        if (self->line_markers.size && loc <= c_line_marker_vec_last(&self->line_markers).loc)
+                return;
 
-        tree_location line_loc = self->lines->items[line - 1];
-        return loc - line_loc + 1;
+        c_line_marker m = { loc, line, file, 0 };
+        c_line_marker_vec_push(&self->line_markers, m);
 }
 
-extern void c_source_save_line_loc(c_source* self, tree_location loc)
+// finds the last line marker at or before loc
+static c_line_marker* c_source_find_line_marker(const c_source* self, tree_location loc)
 {
-        u32vec_push(self->lines, loc);
+        c_line_marker* markers = self->line_markers.items;
+        size_t lo = 0;
+        size_t hi = self->line_markers.size;
+        while (lo < hi)
+        {
+                size_t mid = lo + (hi - lo) / 2;
+                if (markers[mid].loc <= loc)
+                        lo = mid + 1;
+                else
+                        hi = mid;
+        }
+        return lo ? markers + lo - 1 : NULL;
 }
 
 extern const char* c_source_get_name(const c_source* self)
@@ -91,15 +263,19 @@ extern void c_source_manager_init(
         c_source_manager* self, file_lookup* lookup)
 {
         self->lookup = lookup;
-        hashmap_init(&self->file_to_source);
+        c_source_path_map_init(&self->file_to_source);
         vec_init(&self->sources);
+        self->last_source = NULL;
 }
 
 extern void c_source_manager_dispose(c_source_manager* self)
 {
-        HASHMAP_FOREACH(&self->file_to_source, it)
+        for (struct c_source_path_map_iter it = c_source_path_map_begin(&self->file_to_source);
+                it.pos != it.end; c_source_path_map_next(&it))
+        {
                 c_source_delete(self, it.pos->value);
-        hashmap_drop(&self->file_to_source);
+        }
+        c_source_path_map_drop(&self->file_to_source);
         vec_drop(&self->sources);
 }
 
@@ -113,8 +289,9 @@ extern c_source* c_source_get_from_file(c_source_manager* self, file_entry* file
         if (!file)
                 return NULL;
 
-        unsigned ref = strhash(file->path);
-        struct hashmap_entry* entry = hashmap_lookup(&self->file_to_source, ref);
+        unsigned path_size = (unsigned)strlen(file->path);
+        struct c_source_path_map_entry* entry = c_source_path_map_lookup(
+                &self->file_to_source, file->path, path_size);
         if (entry)
                 return entry->value;
 
@@ -125,7 +302,7 @@ extern c_source* c_source_get_from_file(c_source_manager* self, file_entry* file
 
         source->end = source->begin + (tree_location)file_size(file) + 1; // space for eof
         vec_push(&self->sources, source);
-        hashmap_insert(&self->file_to_source, ref, source);
+        c_source_path_map_insert(&self->file_to_source, file->path, path_size, source);
         return source;
 }
 
@@ -139,18 +316,56 @@ extern c_source* c_source_emulate(c_source_manager* self, const char* path, cons
         return c_source_get_from_file(self, file_emulate(self->lookup, path, content));
 }
 
+extern c_source* c_source_find_by_loc(const c_source_manager* self, tree_location loc)
+{
+        c_source* last = self->last_source;
+        if (last && c_source_has(last, loc))
+                return last;
+
+        size_t nsources = self->sources.size;
+        if (!nsources)
+                return NULL;
+
+        // sources are allocated consecutive ranges of locations,
+        // find the last one which begins at or before loc
+        size_t lo = 0;
+        size_t hi = nsources;
+        while (hi - lo > 1)
+        {
+                size_t mid = lo + (hi - lo) / 2;
+                if (c_source_get_loc_begin(self->sources.items[mid]) <= loc)
+                        lo = mid;
+                else
+                        hi = mid;
+        }
+
+        c_source* s = self->sources.items[lo];
+        if (!c_source_has(s, loc))
+                return NULL;
+
+        ((c_source_manager*)self)->last_source = s;
+        return s;
+}
+
 extern errcode c_source_find_loc(const c_source_manager* self, c_location* res, tree_location loc)
 {
-        //todo: log(n) search
+        c_source* s = c_source_find_by_loc(self, loc);
+        if (s)
+        {
+                res->file = c_source_get_name(s);
+                tree_location begin;
+                res->line = c_source_find_line(s, loc, &begin) + 1;
+                res->column = loc - begin + 1;
 
-        for (size_t i = 0; i < self->sources.size; i++) {
-                c_source* s = self->sources.items[i];
-                if (c_source_has(s, loc)) {
-                        res->file = c_source_get_name(s);
-                        res->line = c_source_get_line(s, loc);
-                        res->column = c_source_get_col(s, loc);
-                        return EC_NO_ERROR;
+                c_line_marker* m = c_source_find_line_marker(s, loc);
+                if (m)
+                {
+                        if (!m->source_line)
+                                m->source_line = c_source_get_line(s, m->loc);
+                        res->file = m->file;
+                        res->line += m->line - m->source_line;
                 }
+                return EC_NO_ERROR;
         }
 
         res->file = "";
@@ -3,6 +3,8 @@
 #include "scc/cc/llvm.h"
 #include "scc/c-common/context.h"
 #include "scc/core/file.h"
+#include "scc/core/hash.h"
+#include "scc/core/thread.h"
 #include "scc/lex/lexer.h"
 #include "scc/syntax/parser.h"
 #include "scc/syntax/printer.h"
@@ -19,10 +21,34 @@
 #define SSA_EXT "ssa"
 #define OBJ_EXT "obj"
 #define ASM_EXT "s"
+#define PCH_EXT "pch"
 
-static errcode cc_handle_pragma_link(void* cc, const char* lib)
+// Destination of diagnostics and #pragma link libraries of a translation unit.
+// Translation units that are compiled in parallel get their own and are merged
+// into cc_instance in source order afterwards.
+typedef struct
+{
+        // NULL if diagnostics are not reported
+        FILE* message;
+        struct vec* implicit_libs;
+        // the preprocessed text which is compiled instead of the source, see cc_hash_source
+        file_entry* preprocessed;
+        // diagnostics of the preprocessed text were held back, see cc_report_preprocessed
+        bool diagnosed;
+} cc_unit_output;
+
+static void cc_unit_output_init(cc_unit_output* self, cc_instance* cc)
 {
-        return cc_add_lib(cc, lib, true);
+        self->message = cc->output.message;
+        self->implicit_libs = &cc->input.implicit_libs;
+        self->preprocessed = NULL;
+        self->diagnosed = false;
+}
+
+static errcode cc_handle_pragma_link(void* unit, const char* lib)
+{
+        cc_push_lib(((cc_unit_output*)unit)->implicit_libs, lib);
+        return EC_NO_ERROR;
 }
 
 typedef struct
@@ -33,6 +59,7 @@ typedef struct
         c_error_handler eh;
         ssa_context ssa;
         cc_instance* instance;
+        cc_unit_output* unit;
 } cc_context;
 
 static void cc_handle_error(void* eh, c_error_severity severity, c_location loc, const char* err)
@@ -45,8 +72,16 @@ static void cc_handle_error(void* eh, c_error_severity severity, c_location loc,
         };
 
         cc_context* context = (cc_context*)((char*)eh - offsetof(cc_context, eh));
+        if (context->unit->preprocessed)
+        {
+                context->unit->diagnosed = true;
+                return;
+        }
+        if (!context->unit->message)
+                return;
+
         fprintf(
-                context->instance->output.message,
+                context->unit->message,
                 "%s:%d:%d: %s: %s\n",
                 pathfile(loc.file),
                 loc.line,
@@ -55,9 +90,11 @@ static void cc_handle_error(void* eh, c_error_severity severity, c_location loc,
                 err);
 }
 
-static void cc_context_init(cc_context* self, cc_instance* cc, jmp_buf on_fatal_error)
+static void cc_context_init(cc_context* self,
+        cc_instance* cc, cc_unit_output* unit, jmp_buf on_fatal_error)
 {
         self->instance = cc;
+        self->unit = unit;
 
         tree_init_target_info(&self->target,
                 cc->opts.target == CTK_X86_32 ? TTAK_X86_32 : TTAK_X86_64);
@@ -67,6 +104,7 @@ static void cc_context_init(cc_context* self, cc_instance* cc, jmp_buf on_fatal_
         self->eh.on_error = cc_handle_error;
         c_context_init(&self->c, &self->tree, &cc->input.source_lookup, &self->eh, on_fatal_error);
         self->c.lang_opts.ext.tm_enabled = cc->opts.ext.enable_tm;
+        self->c.pch = cc->input.pch;
 
         ssa_init(&self->ssa, &self->tree, on_fatal_error);
 }
@@ -148,13 +186,27 @@ static file_entry** cc_obj_files_end(cc_instance* self)
         for(file_entry** ITNAME = cc_obj_files_begin(PCC),\
                 **ENDNAME = cc_obj_files_end(PCC); ITNAME != ENDNAME; ITNAME++)
 
+static void cc_verror(cc_instance* self, FILE* message, const char* format, va_list args)
+{
+        fprintf(message, "%s: error: ", self->opts.name);
+        vfprintf(message, format, args);
+        fprintf(message, "\n");
+}
+
 extern void cc_error(cc_instance* self, const char* format, ...)
 {
-        fprintf(self->output.message, "%s: error: ", self->opts.name);
         va_list args;
         va_start(args, format);
-        vfprintf(self->output.message, format, args);
-        fprintf(self->output.message, "\n");
+        cc_verror(self, self->output.message, format, args);
+        va_end(args);
+}
+
+static void cc_unit_error(cc_instance* self, cc_unit_output* unit, const char* format, ...)
+{
+        va_list args;
+        va_start(args, format);
+        cc_verror(self, unit->message, format, args);
+        va_end(args);
 }
 
 extern void cc_unable_to_open(cc_instance* self, const char* path)
@@ -207,10 +259,12 @@ extern errcode cc_dump_tokens(cc_instance* self)
 
         errcode result = EC_ERROR;
         jmp_buf fatal;
+        cc_unit_output unit;
         cc_context context;
         struct vec tokens;
 
-        cc_context_init(&context, self, fatal);
+        cc_unit_output_init(&unit, self);
+        cc_context_init(&context, self, &unit, fatal);
         vec_init(&tokens);
 
         if (setjmp(fatal))
@@ -228,6 +282,35 @@ cleanup:
         return result;
 }
 
+// Writes the preprocessed source to output.file or stdout. Tokens are written
+// as soon as they are preprocessed instead of being collected first.
+extern errcode cc_preprocess(cc_instance* self)
+{
+        if (!cc_check_single_input(self))
+                return EC_ERROR;
+
+        errcode result = EC_ERROR;
+        jmp_buf fatal;
+        cc_unit_output unit;
+        cc_context context;
+        struct buf_writer writer;
+
+        cc_unit_output_init(&unit, self);
+        cc_context_init(&context, self, &unit, fatal);
+        init_buf_writer(&writer, self->output.file ? self->output.file : stdout);
+
+        c_pragma_handlers h;
+        c_pragma_handlers_init(&h, NULL);
+        if (setjmp(fatal))
+                goto cleanup;
+        result = c_preprocess_source(&context.c, *cc_sources_begin(self), h, true, &writer);
+
+cleanup:
+        drop_buf_writer(&writer);
+        cc_context_dispose(&context);
+        return result;
+}
+
 static void cc_print_tree_module(cc_instance* self,
         cc_context* context, FILE* output, const tree_module* module)
 {
@@ -240,8 +323,66 @@ static void cc_print_tree_module(cc_instance* self,
 
 static tree_module* cc_parse_file(cc_instance* self, cc_context* context, file_entry* file)
 {
-        c_pragma_handlers h = { .on_link = cc_handle_pragma_link, .data = self };
-        return c_parse_source(&context->c, file, h, self->output.message);
+        c_pragma_handlers h = { .on_link = cc_handle_pragma_link, .data = context->unit };
+        return c_parse_source(&context->c, file, h, context->unit->message);
+}
+
+// Preprocesses the TM runtime declarations once and replaces input.tm_decls
+// with the result, so every translation unit parses plain declarations
+// instead of running the preprocessor over _tm.h and its includes again.
+// Only the preprocessing is shared: each unit still lexes, parses and checks
+// the declarations in its own tree_context.
+extern errcode cc_precompile_tm_decls(cc_instance* self)
+{
+        if (self->input.tm_decls->is_virtual)
+                return EC_NO_ERROR;
+
+        FILE* output = tmpfile();
+        if (!output)
+                return EC_ERROR;
+
+        errcode result = EC_ERROR;
+        char* content = NULL;
+        jmp_buf fatal;
+        cc_unit_output unit;
+        cc_context context;
+        cc_unit_output_init(&unit, self);
+        cc_context_init(&context, self, &unit, fatal);
+        context.c.pch = NULL;
+
+        struct buf_writer writer;
+        init_buf_writer(&writer, output);
+        if (setjmp(fatal))
+                goto cleanup;
+        c_pragma_handlers h;
+        c_pragma_handlers_init(&h, NULL);
+        if (EC_FAILED(c_preprocess_source(&context.c, self->input.tm_decls, h, false, &writer)))
+                goto cleanup;
+        flush_buf_writer(&writer);
+
+        long size = ftell(output);
+        if (size < 0)
+                goto cleanup;
+        content = alloc(size + 1);
+        rewind(output);
+        if (fread(content, 1, size, output) != (size_t)size)
+                goto cleanup;
+        content[size] = '\0';
+
+        struct pathbuf path = pathbuf_from_str(pathfile(self->input.tm_decls->path));
+        strcpy((char*)pathext(path.buf), "i");
+        file_entry* decls = file_emulate(&self->input.source_lookup, path.buf, content);
+        if (!decls)
+                goto cleanup;
+
+        self->input.tm_decls = decls;
+        result = EC_NO_ERROR;
+cleanup:
+        dealloc(content);
+        drop_buf_writer(&writer);
+        cc_context_dispose(&context);
+        fclose(output);
+        return result;
 }
 
 extern errcode cc_dump_tree(cc_instance* self)
@@ -251,8 +392,10 @@ extern errcode cc_dump_tree(cc_instance* self)
 
         errcode result = EC_ERROR;
         jmp_buf fatal;
+        cc_unit_output unit;
         cc_context context;
-        cc_context_init(&context, self, fatal);
+        cc_unit_output_init(&unit, self);
+        cc_context_init(&context, self, &unit, fatal);
 
         if (setjmp(fatal))
                 goto cleanup;
@@ -273,10 +416,11 @@ cleanup:
 extern errcode cc_perform_syntax_analysis(cc_instance* self)
 {
         jmp_buf fatal;
+        cc_unit_output unit;
         cc_context context;
-        c_pragma_handlers h = { .on_link = cc_handle_pragma_link, .data = self };
 
-        cc_context_init(&context, self, fatal);
+        cc_unit_output_init(&unit, self);
+        cc_context_init(&context, self, &unit, fatal);
         if (setjmp(fatal))
         {
                 cc_context_dispose(&context);
@@ -285,7 +429,7 @@ extern errcode cc_perform_syntax_analysis(cc_instance* self)
 
         errcode result = EC_NO_ERROR;
         CC_FOREACH_SOURCE(self, it, end)
-                if (!c_parse_source(&context.c, *it, h, self->output.message))
+                if (!cc_parse_file(self, &context, *it))
                 {
                         result = EC_ERROR;
                         break;
@@ -300,32 +444,49 @@ static void cc_set_ssa_optimizer_opts(cc_instance* self, ssa_optimizer_opts* opt
         opts->eliminate_dead_code = self->opts.optimization.eliminate_dead_code;
         opts->fold_constants = self->opts.optimization.fold_constants;
         opts->promote_allocas = self->opts.optimization.promote_allocas;
+        opts->inline_functions = self->opts.optimization.inline_functions;
+        opts->propagate_constants = self->opts.optimization.propagate_constants;
+        opts->eliminate_common_subexpressions = self->opts.optimization.eliminate_common_subexpressions;
 }
 
-static errcode cc_codegen_file_ex(cc_instance* self, file_entry* file, bool emit_llvm_ir, FILE* output)
+// parses the file and builds its module, returns NULL on failure
+static ssa_module* cc_emit_file(cc_instance* self, cc_context* context, file_entry* file)
 {
-        errcode result = EC_ERROR;
-        jmp_buf fatal;
-        cc_context context;
-
-        cc_context_init(&context, self, fatal);
-        if (setjmp(fatal))
-                goto cleanup;
+        // the precompiled header is expanded in the preprocessed text already
+        if (context->unit->preprocessed)
+        {
+                file = context->unit->preprocessed;
+                context->c.pch = NULL;
+        }
 
-        tree_module* module = cc_parse_file(self, &context, file);
+        tree_module* module = cc_parse_file(self, context, file);
         if (!module)
-                goto cleanup;
+                return NULL;
 
         ssa_implicitl_modules am;
         am.tm = NULL;
+        context->c.pch = NULL;
         if (self->opts.ext.enable_tm)
-                if (!(am.tm = cc_parse_file(self, &context, self->input.tm_decls)))
-                        goto cleanup;
+                if (!(am.tm = cc_parse_file(self, context, self->input.tm_decls)))
+                        return NULL;
 
         ssa_optimizer_opts opts;
         cc_set_ssa_optimizer_opts(self, &opts);
-      
-        ssa_module* sm = ssa_emit_module(&context.ssa, module, &opts, &am);
+        return ssa_emit_module(&context->ssa, module, &opts, &am);
+}
+
+static errcode cc_codegen_file_ex(cc_instance* self,
+        cc_unit_output* unit, file_entry* file, bool emit_llvm_ir, FILE* output)
+{
+        errcode result = EC_ERROR;
+        jmp_buf fatal;
+        cc_context context;
+
+        cc_context_init(&context, self, unit, fatal);
+        if (setjmp(fatal))
+                goto cleanup;
+
+        ssa_module* sm = cc_emit_file(self, &context, file);
         if (!sm)
                 goto cleanup;
 
@@ -348,7 +509,112 @@ static void get_file_as(struct pathbuf* path, const file_entry* file, const char
                 strcpy(ext_pos, ext);
 }
 
-static errcode cc_codegen_file(cc_instance* self, file_entry* file, bool emit_llvm_ir)
+// writes the options which affect the output of a translation unit
+static void cc_get_opts_key(cc_instance* self, char* key, size_t size)
+{
+        snprintf(key, size, "%s %d %u %d %d %d %d %d %d %d",
+                CC_VERSION,
+                (int)self->opts.target,
+                self->opts.optimization.level,
+                (int)self->opts.optimization.eliminate_dead_code,
+                (int)self->opts.optimization.fold_constants,
+                (int)self->opts.optimization.promote_allocas,
+                (int)self->opts.optimization.inline_functions,
+                (int)self->opts.optimization.propagate_constants,
+                (int)self->opts.optimization.eliminate_common_subexpressions,
+                (int)self->opts.ext.enable_tm);
+}
+
+// The first line of a precompiled header records the options it was generated with,
+// since they change the predefined macros and the declarations of builtin headers,
+// and the hash of the -I directories, which the header was preprocessed with.
+// -D is not recorded, since the driver ignores it.
+static void cc_get_pch_header(cc_instance* self, char* header, size_t size)
+{
+        char key[128];
+        cc_get_opts_key(self, key, sizeof(key));
+        uint64_t dirs = HASH64_INIT;
+        VEC_FOREACH(&self->input.include_dirs, it, end)
+                dirs = hash64(dirs, *it, strlen(*it) + 1);
+        snprintf(header, size, "// scc pch %s %016llx\n", key, (unsigned long long)dirs);
+}
+
+// rejects a precompiled header which was generated with other options
+extern errcode cc_check_pch(cc_instance* self)
+{
+        if (!self->input.pch)
+                return EC_NO_ERROR;
+
+        char header[160];
+        cc_get_pch_header(self, header, sizeof(header));
+        size_t len = strlen(header);
+        size_t size;
+        const char* content = file_map(self->input.pch, &size);
+        if (content && size >= len && memcmp(content, header, len) == 0)
+                return EC_NO_ERROR;
+
+        cc_error(self, "precompiled header '%s' was generated with different options",
+                self->input.pch->path);
+        return EC_ERROR;
+}
+
+// Writes the preprocessed header together with its macros to output.file or
+// <source>.pch. The result is lexed before every source when passed to -include-pch,
+// so it saves preprocessing the header and its includes, not lexing or parsing them.
+// The output is deleted on failure, since cc_check_pch accepts it by its first line.
+extern errcode cc_generate_pch(cc_instance* self)
+{
+        if (!cc_check_single_input(self))
+                return EC_ERROR;
+
+        file_entry* source = *cc_sources_begin(self);
+        FILE* output = self->output.file;
+        struct pathbuf path;
+        if (!output)
+        {
+                get_file_as(&path, source, PCH_EXT);
+                if (!(output = fopen(path.buf, "w")))
+                {
+                        cc_unable_to_open(self, path.buf);
+                        return EC_ERROR;
+                }
+        }
+
+        errcode result = EC_ERROR;
+        jmp_buf fatal;
+        cc_unit_output unit;
+        cc_context context;
+        cc_unit_output_init(&unit, self);
+        cc_context_init(&context, self, &unit, fatal);
+
+        char header[160];
+        cc_get_pch_header(self, header, sizeof(header));
+        struct buf_writer writer;
+        init_buf_writer(&writer, output);
+        buf_write_str(&writer, header);
+        if (setjmp(fatal))
+                goto cleanup;
+        result = c_emit_pch(&context.c, source, &writer);
+cleanup:
+        drop_buf_writer(&writer);
+        cc_context_dispose(&context);
+        if (output != self->output.file)
+        {
+                fclose(output);
+                if (EC_FAILED(result))
+                        fs_delfile(path.buf);
+        }
+        else if (EC_FAILED(result) && self->output.file_path)
+        {
+                fclose(output);
+                self->output.file = NULL;
+                fs_delfile(self->output.file_path);
+        }
+        return result;
+}
+
+static errcode cc_codegen_file(cc_instance* self,
+        cc_unit_output* unit, file_entry* file, bool emit_llvm_ir)
 {
         const char* ext = emit_llvm_ir ? LL_EXT : SSA_EXT;
         struct pathbuf path;
@@ -358,8 +624,10 @@ static errcode cc_codegen_file(cc_instance* self, file_entry* file, bool emit_ll
         if (!fout)
                 return EC_ERROR;
 
-        errcode result = cc_codegen_file_ex(self, file, emit_llvm_ir, fout);
+        errcode result = cc_codegen_file_ex(self, unit, file, emit_llvm_ir, fout);
         fclose(fout);
+        if (EC_FAILED(result))
+                fs_delfile(path.buf);
         return result;
 }
 
@@ -379,56 +647,798 @@ static void cc_cleanup_codegen(cc_instance* self, bool emit_llvm_ir)
         }
 }
 
-static errcode cc_codegen(cc_instance* self, bool emit_llvm_ir)
+static errcode cc_check_return_code(cc_instance* self,
+        cc_unit_output* unit, const char* tool, int code)
 {
-        CC_FOREACH_SOURCE(self, it, end)
-                if (EC_FAILED(cc_codegen_file(self, *it, emit_llvm_ir)))
-                        goto cleanup;
-        CC_FOREACH_BUILTIN_SOURCE(self, it, end)
-                if (EC_FAILED(cc_codegen_file(self, *it, emit_llvm_ir)))
-                        goto cleanup;
-
+        if (code)
+        {
+                cc_unit_error(self, unit, "%s returned %d", tool, code);
+                return EC_ERROR;
+        }
         return EC_NO_ERROR;
+}
+
+// Looks llc up when it is needed first. Later units reuse the result instead of
+// probing the candidates again, which starts a process for every one of them.
+// toolchain.lock is held by the caller.
+static void cc_detect_llc(cc_instance* self)
+{
+        cc_toolchain* tc = &self->toolchain;
+        if (tc->llc_detected)
+                return;
 
+        struct llc detected;
+        if (self->input.llc_path)
+        {
+                llc_init(&detected, self->input.llc_path);
+                detected.is_clang = strstr(self->input.llc_path, "clang") != NULL;
+                tc->llc_found = true;
+        }
+        else
+                tc->llc_found = llc_try_detect(&detected);
+        tc->llc = detected.path;
+        tc->llc_is_clang = detected.is_clang;
+        tc->llc_detected = true;
+}
+
+static bool cc_find_llc(cc_instance* self, cc_unit_output* unit, struct llc* llc)
+{
+        cc_toolchain* tc = &self->toolchain;
+        mutex_lock(&tc->lock);
+        cc_detect_llc(self);
+        bool found = tc->llc_found;
+        mutex_release(&tc->lock);
+
+        if (!found)
+        {
+                cc_unit_error(self, unit, "cannot find %s", LLC_NATIVE_NAME);
+                return false;
+        }
+
+        llc_init(llc, tc->llc.buf);
+        llc->is_clang = tc->llc_is_clang;
+        return true;
+}
+
+// Identifies llc by its path and its version, so that objects built by another llc
+// are not found in the cache. Returns false if llc is not found.
+static bool cc_get_llc_key(cc_instance* self, uint64_t* key)
+{
+        cc_toolchain* tc = &self->toolchain;
+        mutex_lock(&tc->lock);
+        cc_detect_llc(self);
+        if (tc->llc_found && !tc->llc_key_detected)
+        {
+                struct llc llc;
+                llc_init(&llc, tc->llc.buf);
+                char version[1024];
+                if (!llc_get_version(&llc, version, sizeof(version)))
+                        *version = '\0';
+                tc->llc_key = hash64(HASH64_INIT, tc->llc.buf, strlen(tc->llc.buf));
+                tc->llc_key = hash64(tc->llc_key, version, strlen(version));
+                tc->llc_key_detected = true;
+        }
+        bool found = tc->llc_found;
+        *key = tc->llc_key;
+        mutex_release(&tc->lock);
+        return found;
+}
+
+// Compilation cache.
+// Outputs of translation units are kept in opts.cache_dir under a hash of the
+// preprocessed source (precompiled header and included files included) and of the
+// options, so a unit whose preprocessed text did not change is not compiled again.
+// A unit which is not found is compiled from the text it was hashed with, so it
+// is preprocessed once either way.
+// Only outputs are cached: a unit which is found is not parsed, so its warnings
+// are not reported again.
+typedef struct
+{
+        struct buf_writer buf;
+        uint64_t hash;
+        char* text;
+        size_t size;
+        size_t capacity;
+} cc_hash_writer;
+
+static size_t cc_hash_write(void* writer, const void* data, size_t size)
+{
+        cc_hash_writer* self = writer;
+        self->hash = hash64(self->hash, data, size);
+        if (self->size + size + 1 > self->capacity)
+        {
+                size_t capacity = self->capacity * 2 + size + 1;
+                char* text = alloc(capacity);
+                memcpy(text, self->text, self->size);
+                dealloc(self->text);
+                self->text = text;
+                self->capacity = capacity;
+        }
+        memcpy(self->text + self->size, data, size);
+        self->size += size;
+        self->text[self->size] = '\0';
+        return size;
+}
+
+typedef struct
+{
+        // false if the cache is not used for the unit
+        bool enabled;
+        struct pathbuf path;
+        // the output is a temporary file which is renamed to path instead of copied
+        bool move_output;
+} cc_cache_entry;
+
+// Preprocesses the source and hashes its text, returns false if it cannot be preprocessed.
+// Errors are reported to message if it is not NULL. The text is kept as
+// unit->preprocessed (with line markers, which keep the lines of the source), which is
+// compiled instead of the source unless the output is found, see cc_report_preprocessed.
+// #pragma link libraries of the source are added to the unit.
+static bool cc_hash_source(cc_instance* self,
+        cc_unit_output* unit, file_entry* file, FILE* message, uint64_t* result)
+{
+        bool hashed = false;
+        jmp_buf fatal;
+        cc_unit_output pp_unit;
+        cc_context context;
+        struct vec implicit_libs;
+        vec_init(&implicit_libs);
+        pp_unit.message = message;
+        pp_unit.implicit_libs = &implicit_libs;
+        pp_unit.preprocessed = NULL;
+        pp_unit.diagnosed = false;
+        cc_context_init(&context, self, &pp_unit, fatal);
+
+        cc_hash_writer writer;
+        init_custom_buf_writer(&writer.buf, cc_hash_write);
+        writer.hash = HASH64_INIT;
+        writer.text = NULL;
+        writer.size = 0;
+        writer.capacity = 0;
+        c_pragma_handlers h = { .on_link = cc_handle_pragma_link, .data = &pp_unit };
+        if (setjmp(fatal))
+                goto cleanup;
+        if (EC_FAILED(c_preprocess_source(&context.c, file, h, true, &writer.buf))
+                || flush_buf_writer(&writer.buf))
+        {
+                goto cleanup;
+        }
+
+        // the text begins with a line marker, so it is not preprocessed again
+        struct pathbuf path = pathbuf_from_str(pathfile(file->path));
+        strcpy((char*)pathext(path.buf), "i");
+        const char* text = writer.text ? writer.text : "";
+        if (!(unit->preprocessed = file_emulate(&self->input.source_lookup, path.buf, text)))
+                goto cleanup;
+
+        *result = writer.hash;
+        hashed = true;
 cleanup:
-        cc_cleanup_codegen(self, emit_llvm_ir);
-        return EC_ERROR;
+        VEC_FOREACH(&implicit_libs, it, end)
+        {
+                if (hashed)
+                        vec_push(unit->implicit_libs, *it);
+                else
+                        dealloc(*it);
+        }
+        vec_drop(&implicit_libs);
+        dealloc(writer.text);
+        drop_buf_writer(&writer.buf);
+        cc_context_dispose(&context);
+        return hashed;
 }
 
-static errcode cc_check_return_code(cc_instance* self, const char* tool, int code)
+// deletes the text kept by cc_hash_source once the unit is compiled or found
+static void cc_drop_preprocessed(cc_unit_output* unit)
 {
-        if (code)
+        if (!unit->preprocessed)
+                return;
+
+        file_drop_emulated(unit->preprocessed);
+        unit->preprocessed = NULL;
+        unit->diagnosed = false;
+}
+
+// Tokens of a macro expansion have the location of the macro name, which is not where
+// they are in the preprocessed text, so diagnostics of the text are held back. If there
+// are any, the source is parsed again to report them (a unit without diagnostics, which
+// is the usual case, is still preprocessed once).
+static errcode cc_report_preprocessed(cc_instance* self,
+        cc_unit_output* unit, file_entry* file, errcode result)
+{
+        bool diagnosed = unit->diagnosed;
+        cc_drop_preprocessed(unit);
+        if (!diagnosed)
+                return result;
+
+        // the libraries are added by cc_hash_source already
+        struct vec implicit_libs;
+        vec_init(&implicit_libs);
+        cc_unit_output source_unit = *unit;
+        source_unit.implicit_libs = &implicit_libs;
+
+        jmp_buf fatal;
+        cc_context context;
+        cc_context_init(&context, self, &source_unit, fatal);
+        if (setjmp(fatal))
+                goto cleanup;
+        cc_emit_file(self, &context, file);
+cleanup:
+        cc_context_dispose(&context);
+        VEC_FOREACH(&implicit_libs, it, end)
+                dealloc(*it);
+        vec_drop(&implicit_libs);
+        return result;
+}
+
+// Looks the unit up in the cache and copies the cached output with the given extension
+// to output. Otherwise fills the entry which cc_cache_store uses to keep the output.
+static bool cc_cache_find(cc_instance* self, cc_unit_output* unit,
+        file_entry* file, const char* ext, const char* output, cc_cache_entry* entry)
+{
+        entry->enabled = false;
+        entry->move_output = false;
+        if (!self->opts.cache_dir)
+                return false;
+
+        // objects also depend on llc, the unit is compiled without the cache
+        // if it is not found (and fails there)
+        uint64_t llc_key = 0;
+        bool uses_llc = strcmp(ext, OBJ_EXT) == 0 || strcmp(ext, ASM_EXT) == 0;
+        if (uses_llc && !cc_get_llc_key(self, &llc_key))
+                return false;
+
+        uint64_t h;
+        if (!cc_hash_source(self, unit, file, NULL, &h))
+                return false;
+
+        // the TM declarations are parsed with every unit, but are not part of its preprocessed text
+        if (self->opts.ext.enable_tm)
         {
-                cc_error(self, "%s returned %d", tool, code);
-                return EC_ERROR;
+                size_t size;
+                const char* decls = file_map(self->input.tm_decls, &size);
+                if (decls)
+                        h = hash64(h, decls, size);
         }
-        return EC_NO_ERROR;
+
+        char key[128];
+        cc_get_opts_key(self, key, sizeof(key));
+        h = hash64(h, key, strlen(key));
+        h = hash64(h, ext, strlen(ext));
+        h = hash64(h, &llc_key, sizeof(llc_key));
+
+        char name[64];
+        snprintf(name, sizeof(name), "%016llx.%s", (unsigned long long)h, ext);
+        entry->enabled = true;
+        entry->path = pathbuf_from_str(self->opts.cache_dir);
+        join(&entry->path, name);
+        if (!isfile(entry->path.buf) || fs_copyfile(entry->path.buf, output) != 0)
+                return false;
+
+        cc_drop_preprocessed(unit);
+        entry->enabled = false;
+        return true;
 }
 
-static errcode cc_compile_file(cc_instance* self,
-        file_entry* file, int llc_output_kind, const char* output)
+static void cc_cache_store(cc_cache_entry* entry, errcode result, const char* output)
+{
+        if (!entry->enabled)
+                return;
+
+        if (entry->move_output)
+        {
+                // fails if another process has stored the same output meanwhile
+                if (EC_FAILED(result) || rename(output, entry->path.buf) != 0)
+                        fs_delfile(output);
+                return;
+        }
+        if (EC_FAILED(result))
+                return;
+
+        // the output is copied under a temporary name first, so that a unit which is
+        // compiled by another process at the same time never finds a partial file
+        struct pathbuf tmp = entry->path;
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".%08x", strhash(output));
+        strcat(tmp.buf, suffix);
+        if (fs_copyfile(output, tmp.buf) != 0 || rename(tmp.buf, entry->path.buf) != 0)
+                fs_delfile(tmp.buf);
+}
+
+static void cc_set_llc_opts(cc_instance* self, struct llc* llc, int llc_output_kind, const char* output)
+{
+        llc_add_opt(llc, LLC_O0 + self->opts.optimization.level);
+        llc_add_opt(llc, llc_output_kind);
+        llc_add_opt(llc, self->opts.target == CTK_X86_32 ? LLC_X86 : LLC_X64);
+        llc_set_output(llc, output);
+}
+
+// llc which keeps compiling a unit in the background after cc_compile_file returned,
+// so that the next unit can be parsed meanwhile (see cc_run_jobs_pipelined)
+typedef struct
+{
+        bool running;
+        FILE* input;
+        struct thread waiter;
+        int exit_code;
+        cc_cache_entry cache;
+        struct pathbuf output;
+} cc_backend;
+
+static void cc_backend_wait(void* backend)
+{
+        cc_backend* self = backend;
+        self->exit_code = llc_close(self->input);
+}
+
+// waits for llc and reports its result to the unit
+static errcode cc_backend_finish(cc_instance* self, cc_unit_output* unit, cc_backend* backend)
+{
+        if (!backend->running)
+                return EC_NO_ERROR;
+
+        thread_wait(&backend->waiter);
+        backend->running = false;
+        errcode result = cc_check_return_code(self, unit, LLC_NATIVE_NAME, backend->exit_code);
+        cc_cache_store(&backend->cache, result, backend->output.buf);
+        return result;
+}
+
+// Prints the module straight to the standard input of llc, so no .ll file is written.
+// llc is started only after the module is built, a unit with errors does not start it.
+// If backend is not NULL, llc is left running and is finished by cc_backend_finish.
+static errcode cc_compile_file_piped(cc_instance* self, cc_unit_output* unit,
+        file_entry* file, int llc_output_kind, const char* output, cc_backend* backend)
+{
+        errcode result = EC_ERROR;
+        jmp_buf fatal;
+        cc_context context;
+
+        cc_context_init(&context, self, unit, fatal);
+        if (setjmp(fatal))
+                goto cleanup;
+
+        ssa_module* sm = cc_emit_file(self, &context, file);
+        if (!sm)
+                goto cleanup;
+
+        struct llc llc;
+        if (!cc_find_llc(self, unit, &llc))
+                goto cleanup;
+
+        cc_set_llc_opts(self, &llc, llc_output_kind, output);
+        FILE* pipe = llc_open(&llc);
+        if (!pipe)
+        {
+                cc_unit_error(self, unit, "cannot start %s", LLC_NATIVE_NAME);
+                goto cleanup;
+        }
+
+        // llc names the module after its input, keep the name of the .ll file
+        struct pathbuf ll_file;
+        get_file_as(&ll_file, file, LL_EXT);
+        fputs("source_filename = \"", pipe);
+        for (const char* c = ll_file.buf; *c; c++)
+        {
+                if (*c == '\\' || *c == '"')
+                        fprintf(pipe, "\\%02X", *c);
+                else
+                        fputc(*c, pipe);
+        }
+        fputs("\"\n", pipe);
+
+        ssa_pretty_print_module_llvm(pipe, &context.ssa, sm);
+        if (backend)
+        {
+                backend->input = pipe;
+                thread_init(&backend->waiter, cc_backend_wait, backend);
+                if (thread_start(&backend->waiter) == 0)
+                {
+                        backend->running = true;
+                        result = EC_NO_ERROR;
+                        goto cleanup;
+                }
+        }
+        result = cc_check_return_code(self, unit, LLC_NATIVE_NAME, llc_close(pipe));
+cleanup:
+        cc_context_dispose(&context);
+        return result;
+}
+
+static errcode cc_compile_file_uncached(cc_instance* self, cc_unit_output* unit,
+        file_entry* file, int llc_output_kind, const char* output, cc_backend* backend)
 {
-        if (EC_FAILED(cc_codegen_file(self, file, true)))
+        if (self->opts.pipe)
+                return cc_compile_file_piped(self, unit, file, llc_output_kind, output, backend);
+
+        if (EC_FAILED(cc_codegen_file(self, unit, file, true)))
                 return EC_ERROR;
 
         struct pathbuf ll_file;
         get_file_as(&ll_file, file, LL_EXT);
 
         struct llc llc;
-        if (!llc_try_detect(&llc))
-        {
-                cc_error(self, "cannot find %s", LLC_NATIVE_NAME);
+        if (!cc_find_llc(self, unit, &llc))
                 return EC_ERROR;
-        }
 
-        llc_add_opt(&llc, LLC_O0 + self->opts.optimization.level);
-        llc_add_opt(&llc, llc_output_kind);
-        llc_add_opt(&llc, self->opts.target == CTK_X86_32 ? LLC_X86 : LLC_X64);
+        cc_set_llc_opts(self, &llc, llc_output_kind, output);
         llc_set_input(&llc, ll_file.buf);
-        llc_set_output(&llc, output);
         int exit_code = llc_run(&llc);
         fs_delfile(ll_file.buf);
-        return cc_check_return_code(self, LLC_NATIVE_NAME, exit_code);
+        return cc_check_return_code(self, unit, LLC_NATIVE_NAME, exit_code);
+}
+
+// If backend is not NULL, llc may still be running when the function returns,
+// the unit is finished by cc_backend_finish then.
+static errcode cc_compile_file_ex(cc_instance* self, cc_unit_output* unit,
+        file_entry* file, int llc_output_kind, const char* output, cc_backend* backend)
+{
+        const char* ext = llc_output_kind == LLC_ASM ? ASM_EXT : OBJ_EXT;
+        struct pathbuf output_file;
+        if (!output)
+        {
+                get_file_as(&output_file, file, ext);
+                output = output_file.buf;
+        }
+
+        cc_cache_entry cache;
+        if (cc_cache_find(self, unit, file, ext, output, &cache))
+                return EC_NO_ERROR;
+
+        errcode result = cc_compile_file_uncached(self, unit, file, llc_output_kind, output, backend);
+        result = cc_report_preprocessed(self, unit, file, result);
+        if (backend && backend->running)
+        {
+                // the output is cached once llc finishes it
+                backend->cache = cache;
+                backend->output = pathbuf_from_str(output);
+                return result;
+        }
+        cc_cache_store(&cache, result, output);
+        return result;
+}
+
+static errcode cc_compile_file(cc_instance* self,
+        cc_unit_output* unit, file_entry* file, int llc_output_kind, const char* output)
+{
+        return cc_compile_file_ex(self, unit, file, llc_output_kind, output, NULL);
+}
+
+// Object files of builtin sources (e.g. _tm.c) only depend on the compiler, llc,
+// the preprocessed source and the options used to compile them, so they are kept in
+// opts.cache_dir (or the temporary directory of the user) under a name derived
+// from all of these and reused by later runs.
+static bool cc_get_builtin_obj_file(cc_instance* self,
+        cc_unit_output* unit, file_entry* file, struct pathbuf* path)
+{
+        if (self->opts.cache_dir)
+                *path = pathbuf_from_str(self->opts.cache_dir);
+        else if (fs_usertmpdir(path) != 0)
+        {
+                cc_unit_error(self, unit, "cannot create a directory for temporary files");
+                return false;
+        }
+
+        uint64_t llc_key;
+        if (!cc_get_llc_key(self, &llc_key))
+        {
+                cc_unit_error(self, unit, "cannot find %s", LLC_NATIVE_NAME);
+                return false;
+        }
+
+        uint64_t h;
+        if (!cc_hash_source(self, unit, file, unit->message, &h))
+                return false;
+
+        char key[128];
+        cc_get_opts_key(self, key, sizeof(key));
+        h = hash64(h, key, strlen(key));
+        h = hash64(h, &llc_key, sizeof(llc_key));
+
+        struct pathbuf name = pathbuf_from_str(pathfile(file->path));
+        char* ext_pos = (char*)pathext(name.buf);
+        if (*ext_pos)
+                ext_pos--;
+        snprintf(ext_pos, sizeof(name.buf) - (ext_pos - name.buf),
+                "-%016llx." OBJ_EXT, (unsigned long long)h);
+        join(path, name.buf);
+        return true;
+}
+
+static errcode cc_compile_builtin_file(cc_instance* self,
+        cc_unit_output* unit, file_entry* file, struct pathbuf* obj_file, cc_backend* backend)
+{
+        if (!cc_get_builtin_obj_file(self, unit, file, obj_file))
+                return EC_ERROR;
+        if (isfile(obj_file->buf))
+        {
+                cc_drop_preprocessed(unit);
+                return EC_NO_ERROR;
+        }
+
+        // the object is renamed once llc finishes it, so that
+        // another process never finds (and links) a partial file
+        cc_cache_entry cache;
+        cache.enabled = true;
+        cache.move_output = true;
+        cache.path = *obj_file;
+        struct pathbuf tmp;
+        fs_tmpname(&tmp, obj_file->buf);
+
+        errcode result = cc_compile_file_uncached(self, unit, file, LLC_OBJ, tmp.buf, backend);
+        result = cc_report_preprocessed(self, unit, file, result);
+        if (backend && backend->running)
+        {
+                backend->cache = cache;
+                backend->output = tmp;
+                return result;
+        }
+        cc_cache_store(&cache, result, tmp.buf);
+        return result;
+}
+
+// A translation unit that is compiled by cc_codegen or cc_compile.
+typedef struct
+{
+        cc_instance* instance;
+        file_entry* file;
+        bool builtin;
+        // the cached object of a builtin source
+        struct pathbuf obj_file;
+        bool compile;
+        bool emit_llvm_ir;
+        int llc_output_kind;
+        cc_unit_output unit;
+        struct vec implicit_libs;
+        bool done;
+        errcode result;
+} cc_job;
+
+// if backend is not NULL, llc may be left running, see cc_compile_file_ex
+static errcode cc_run_job_ex(cc_job* job, cc_backend* backend)
+{
+        if (job->compile && job->builtin && job->llc_output_kind == LLC_OBJ)
+                return cc_compile_builtin_file(job->instance,
+                        &job->unit, job->file, &job->obj_file, backend);
+
+        if (job->compile)
+                return cc_compile_file_ex(job->instance,
+                        &job->unit, job->file, job->llc_output_kind, NULL, backend);
+
+        const char* ext = job->emit_llvm_ir ? LL_EXT : SSA_EXT;
+        struct pathbuf output;
+        get_file_as(&output, job->file, ext);
+        cc_cache_entry cache;
+        if (cc_cache_find(job->instance, &job->unit, job->file, ext, output.buf, &cache))
+                return EC_NO_ERROR;
+
+        errcode result = cc_codegen_file(job->instance, &job->unit, job->file, job->emit_llvm_ir);
+        result = cc_report_preprocessed(job->instance, &job->unit, job->file, result);
+        cc_cache_store(&cache, result, output.buf);
+        return result;
+}
+
+static errcode cc_run_job(cc_job* job)
+{
+        return cc_run_job_ex(job, NULL);
+}
+
+typedef struct
+{
+        cc_job* jobs;
+        size_t num_jobs;
+        size_t next;
+        bool failed;
+        struct mutex lock;
+} cc_job_queue;
+
+static void cc_job_queue_worker(void* queue)
+{
+        cc_job_queue* self = queue;
+        while (1)
+        {
+                // jobs are taken in source order, so when a job fails every
+                // job before it has been taken (and will be finished) already
+                mutex_lock(&self->lock);
+                cc_job* job = !self->failed && self->next < self->num_jobs
+                        ? self->jobs + self->next++ : NULL;
+                mutex_release(&self->lock);
+                if (!job)
+                        return;
+
+                job->result = cc_run_job(job);
+                job->done = true;
+                if (EC_FAILED(job->result))
+                {
+                        mutex_lock(&self->lock);
+                        self->failed = true;
+                        mutex_release(&self->lock);
+                }
+        }
+}
+
+static void cc_copy_stream(FILE* to, FILE* from)
+{
+        char buf[4096];
+        size_t n;
+        rewind(from);
+        while ((n = fread(buf, 1, sizeof(buf), from)))
+                fwrite(buf, 1, n, to);
+}
+
+// gives every job its own diagnostics and libraries, which cc_report_jobs merges afterwards
+static void cc_prepare_jobs(cc_instance* self, cc_job* jobs, size_t num_jobs)
+{
+        for (size_t i = 0; i < num_jobs; i++)
+        {
+                cc_job* job = jobs + i;
+                vec_init(&job->implicit_libs);
+                job->unit.implicit_libs = &job->implicit_libs;
+                if (!(job->unit.message = tmpfile()))
+                        job->unit.message = self->output.message;
+        }
+}
+
+// Reports everything up to the first failed job, which is exactly
+// what a sequential run would have produced.
+static errcode cc_report_jobs(cc_instance* self, cc_job* jobs, size_t num_jobs)
+{
+        errcode result = EC_NO_ERROR;
+        for (size_t i = 0; i < num_jobs; i++)
+        {
+                cc_job* job = jobs + i;
+                bool report = EC_SUCCEEDED(result) && job->done;
+                if (job->unit.message != self->output.message)
+                {
+                        if (report)
+                                cc_copy_stream(self->output.message, job->unit.message);
+                        fclose(job->unit.message);
+                }
+                VEC_FOREACH(&job->implicit_libs, it, end)
+                {
+                        if (report)
+                                vec_push(&self->input.implicit_libs, *it);
+                        else
+                                dealloc(*it);
+                }
+                vec_drop(&job->implicit_libs);
+                if (report && EC_FAILED(job->result))
+                        result = EC_ERROR;
+        }
+        return result;
+}
+
+static errcode cc_run_jobs_in_parallel(cc_instance* self, cc_job* jobs, size_t num_jobs, unsigned num_threads)
+{
+        cc_prepare_jobs(self, jobs, num_jobs);
+
+        cc_job_queue queue;
+        queue.jobs = jobs;
+        queue.num_jobs = num_jobs;
+        queue.next = 0;
+        queue.failed = false;
+        mutex_init(&queue.lock);
+
+        // the calling thread is one of the workers
+        struct thread* threads = alloc(sizeof(*threads) * (num_threads - 1));
+        unsigned num_started = 0;
+        for (unsigned i = 0; i < num_threads - 1; i++)
+        {
+                thread_init(threads + num_started, cc_job_queue_worker, &queue);
+                if (thread_start(threads + num_started) == 0)
+                        num_started++;
+        }
+        cc_job_queue_worker(&queue);
+        for (unsigned i = 0; i < num_started; i++)
+                thread_wait(threads + i);
+        dealloc(threads);
+        mutex_drop(&queue.lock);
+
+        return cc_report_jobs(self, jobs, num_jobs);
+}
+
+// Runs the jobs one by one, but llc compiles a unit while the next one is parsed and emitted.
+// The job is done once its llc finishes, so its diagnostics are reported in source order.
+static errcode cc_run_jobs_pipelined(cc_instance* self, cc_job* jobs, size_t num_jobs)
+{
+        cc_prepare_jobs(self, jobs, num_jobs);
+
+        // llc of the previous job and of the current one
+        cc_backend backends[2];
+        backends[0].running = false;
+        backends[1].running = false;
+        cc_job* prev = NULL;
+        for (size_t i = 0; i < num_jobs; i++)
+        {
+                cc_job* job = jobs + i;
+                job->result = cc_run_job_ex(job, backends + i % 2);
+                if (prev)
+                {
+                        errcode result = cc_backend_finish(self, &prev->unit, backends + (i - 1) % 2);
+                        prev->done = true;
+                        if (EC_FAILED(result))
+                        {
+                                prev->result = result;
+                                cc_backend_finish(self, &job->unit, backends + i % 2);
+                                break;
+                        }
+                }
+                if (EC_FAILED(job->result))
+                {
+                        job->done = true;
+                        break;
+                }
+                prev = job;
+        }
+        if (prev && !prev->done)
+        {
+                prev->result = cc_backend_finish(self, &prev->unit, backends + (prev - jobs) % 2);
+                prev->done = true;
+        }
+
+        return cc_report_jobs(self, jobs, num_jobs);
+}
+
+static errcode cc_run_jobs(cc_instance* self, cc_job* jobs, size_t num_jobs)
+{
+        unsigned num_threads = self->opts.num_jobs;
+        if (!num_threads)
+                num_threads = num_hardware_threads();
+        if (num_threads > num_jobs)
+                num_threads = (unsigned)num_jobs;
+        if (num_threads > 1)
+                return cc_run_jobs_in_parallel(self, jobs, num_jobs, num_threads);
+        if (self->opts.pipe && num_jobs > 1 && jobs->compile)
+                return cc_run_jobs_pipelined(self, jobs, num_jobs);
+
+        for (size_t i = 0; i < num_jobs; i++)
+                if (EC_FAILED(cc_run_job(jobs + i)))
+                        return EC_ERROR;
+        return EC_NO_ERROR;
+}
+
+// creates a job for every source and builtin source
+static cc_job* cc_new_jobs(cc_instance* self, size_t* num_jobs)
+{
+        *num_jobs = self->input.sources.size + self->input.builtin_sources.size;
+        cc_job* jobs = alloc(sizeof(*jobs) * (*num_jobs ? *num_jobs : 1));
+        cc_job* job = jobs;
+        CC_FOREACH_SOURCE(self, it, end)
+        {
+                job->file = *it;
+                (job++)->builtin = false;
+        }
+        CC_FOREACH_BUILTIN_SOURCE(self, it, end)
+        {
+                job->file = *it;
+                (job++)->builtin = true;
+        }
+
+        for (size_t i = 0; i < *num_jobs; i++)
+        {
+                jobs[i].instance = self;
+                jobs[i].compile = false;
+                jobs[i].emit_llvm_ir = false;
+                jobs[i].llc_output_kind = LLC_OBJ;
+                jobs[i].done = false;
+                jobs[i].result = EC_NO_ERROR;
+                cc_unit_output_init(&jobs[i].unit, self);
+        }
+        return jobs;
+}
+
+static errcode cc_codegen(cc_instance* self, bool emit_llvm_ir)
+{
+        size_t num_jobs;
+        cc_job* jobs = cc_new_jobs(self, &num_jobs);
+        for (size_t i = 0; i < num_jobs; i++)
+                jobs[i].emit_llvm_ir = emit_llvm_ir;
+
+        errcode result = cc_run_jobs(self, jobs, num_jobs);
+        dealloc(jobs);
+        if (EC_FAILED(result))
+                cc_cleanup_codegen(self, emit_llvm_ir);
+        return result;
 }
 
 static void cc_cleanup_compilation(cc_instance* self, int llc_output_kind)
@@ -440,6 +1450,9 @@ static void cc_cleanup_compilation(cc_instance* self, int llc_output_kind)
                 get_file_as(&file, *it, ext);
                 fs_delfile(file.buf);
         }
+        if (llc_output_kind == LLC_OBJ)
+                return; // object files of builtin sources are cached
+
         CC_FOREACH_BUILTIN_SOURCE(self, it, end)
         {
                 get_file_as(&file, *it, ext);
@@ -449,19 +1462,28 @@ static void cc_cleanup_compilation(cc_instance* self, int llc_output_kind)
 
 static errcode cc_compile(cc_instance* self, int llc_output_kind)
 {
-        CC_FOREACH_SOURCE(self, it, end)
-                if (EC_FAILED(cc_compile_file(self, *it, llc_output_kind, NULL)))
-                {
-                        cc_cleanup_compilation(self, llc_output_kind);
-                        return EC_ERROR;
-                }
-        CC_FOREACH_BUILTIN_SOURCE(self, it, end)
-                if (EC_FAILED(cc_compile_file(self, *it, llc_output_kind, NULL)))
-                {
-                        cc_cleanup_compilation(self, llc_output_kind);
-                        return EC_ERROR;
-                }
-        return EC_NO_ERROR;
+        size_t num_jobs;
+        cc_job* jobs = cc_new_jobs(self, &num_jobs);
+        for (size_t i = 0; i < num_jobs; i++)
+        {
+                jobs[i].compile = true;
+                jobs[i].llc_output_kind = llc_output_kind;
+        }
+
+        errcode result = cc_run_jobs(self, jobs, num_jobs);
+        if (EC_SUCCEEDED(result) && llc_output_kind == LLC_OBJ)
+                for (size_t i = 0; i < num_jobs; i++)
+                        if (jobs[i].builtin)
+                        {
+                                char* copy = alloc(strlen(jobs[i].obj_file.buf) + 1);
+                                strcpy(copy, jobs[i].obj_file.buf);
+                                vec_push(&self->output.builtin_obj_files, copy);
+                        }
+
+        dealloc(jobs);
+        if (EC_FAILED(result))
+                cc_cleanup_compilation(self, llc_output_kind);
+        return result;
 }
 
 static void cc_close_output_stream(cc_instance* self)
@@ -480,8 +1502,10 @@ extern errcode cc_generate_obj(cc_instance* self)
                 if (!cc_check_single_input(self))
                         return EC_ERROR;
 
+                cc_unit_output unit;
+                cc_unit_output_init(&unit, self);
                 cc_close_output_stream(self);
-                return cc_compile_file(self,
+                return cc_compile_file(self, &unit,
                         *cc_sources_begin(self), LLC_OBJ, self->output.file_path);
         }
 
@@ -495,8 +1519,10 @@ extern errcode cc_generate_asm(cc_instance* self)
                 if (!cc_check_single_input(self))
                         return EC_ERROR;
 
+                cc_unit_output unit;
+                cc_unit_output_init(&unit, self);
                 cc_close_output_stream(self);
-                return cc_compile_file(self,
+                return cc_compile_file(self, &unit,
                         *cc_sources_begin(self), LLC_ASM, self->output.file_path);
         }
 
@@ -510,7 +1536,9 @@ extern errcode cc_generate_ssa(cc_instance* self)
                 if (!cc_check_single_input(self))
                         return EC_ERROR;
 
-                return cc_codegen_file_ex(self,
+                cc_unit_output unit;
+                cc_unit_output_init(&unit, self);
+                return cc_codegen_file_ex(self, &unit,
                         *cc_sources_begin(self), false, self->output.file);
         }
 
@@ -524,7 +1552,9 @@ extern errcode cc_generate_llvm_ir(cc_instance* self)
                 if (!cc_check_single_input(self))
                         return EC_ERROR;
 
-                return cc_codegen_file_ex(self,
+                cc_unit_output unit;
+                cc_unit_output_init(&unit, self);
+                return cc_codegen_file_ex(self, &unit,
                         *cc_sources_begin(self), true, self->output.file);
         }
 
@@ -539,11 +1569,8 @@ static errcode cc_link(cc_instance* self, struct lld* lld)
                 get_file_as(&obj_file, *it, OBJ_EXT);
                 lld_add_file(lld, obj_file.buf);
         }
-        CC_FOREACH_BUILTIN_SOURCE(self, it, end)
-        {
-                get_file_as(&obj_file, *it, OBJ_EXT);
-                lld_add_file(lld, obj_file.buf);
-        }
+        VEC_FOREACH(&self->output.builtin_obj_files, it, end)
+                lld_add_file(lld, *it);
 
         CC_FOREACH_OBJ_FILE(self, it, end)
                 lld_add_file(lld, (*it)->path);
@@ -558,8 +1585,10 @@ static errcode cc_link(cc_instance* self, struct lld* lld)
 
         if (self->opts.linker.emit_debug_info)
                 lld_add_opt(lld, LLD_DEBUG_FULL);
+        cc_unit_output unit;
+        cc_unit_output_init(&unit, self);
         int exit_code = lld_run(lld);
-        return cc_check_return_code(self, "lld", exit_code);
+        return cc_check_return_code(self, &unit, "lld", exit_code);
 }
 
 extern errcode cc_generate_exec(cc_instance* self)
@@ -3,11 +3,15 @@
 
 #include "scc/cc/cc.h"
 
+extern void cc_push_lib(struct vec* libs, const char* lib);
 extern void cc_error(cc_instance* self, const char* format, ...);
 extern void cc_unable_to_open(cc_instance* self, const char* path);
 extern void cc_file_doesnt_exit(cc_instance* self, const char* file);
 
+extern errcode cc_precompile_tm_decls(cc_instance* self);
+extern errcode cc_check_pch(cc_instance* self);
 extern errcode cc_dump_tokens(cc_instance* self);
+extern errcode cc_preprocess(cc_instance* self);
 extern errcode cc_dump_tree(cc_instance* self);
 extern errcode cc_perform_syntax_analysis(cc_instance* self);
 extern errcode cc_generate_obj(cc_instance* self);
@@ -15,5 +19,6 @@ extern errcode cc_generate_asm(cc_instance* self);
 extern errcode cc_generate_ssa(cc_instance* self);
 extern errcode cc_generate_llvm_ir(cc_instance* self);
 extern errcode cc_generate_exec(cc_instance* self);
+extern errcode cc_generate_pch(cc_instance* self);
 
 #endif
\ No newline at end of file
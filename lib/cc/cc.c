@@ -11,11 +11,13 @@ extern void cc_init(cc_instance* self, FILE* message)
         self->input.lld_path = NULL;
         self->input.entry = NULL;
         self->input.tm_decls = NULL;
+        self->input.pch = NULL;
         vec_init(&self->input.sources);
         vec_init(&self->input.builtin_sources);
         vec_init(&self->input.libs);
         vec_init(&self->input.implicit_libs);
         vec_init(&self->input.obj_files);
+        vec_init(&self->input.include_dirs);
         flookup_init(&self->input.source_lookup);
         flookup_init(&self->input.lib_lookup);
 
@@ -23,11 +25,18 @@ extern void cc_init(cc_instance* self, FILE* message)
         self->output.message = message;
         self->output.file = NULL;
         self->output.file_path = NULL;
+        vec_init(&self->output.builtin_obj_files);
 
         self->opts.target = CTK_X86_32;
+        self->opts.num_jobs = 1;
+        self->opts.cache_dir = NULL;
+        self->opts.pipe = false;
         self->opts.optimization.eliminate_dead_code = false;
         self->opts.optimization.fold_constants = false;
         self->opts.optimization.promote_allocas = false;
+        self->opts.optimization.inline_functions = false;
+        self->opts.optimization.propagate_constants = false;
+        self->opts.optimization.eliminate_common_subexpressions = false;
         self->opts.optimization.level = 0;
         self->opts.cprint.print_expr_value = false;
         self->opts.cprint.print_expr_type = false;
@@ -37,6 +46,13 @@ extern void cc_init(cc_instance* self, FILE* message)
         self->opts.cprint.print_semantic_init = false;
         self->opts.linker.emit_debug_info = false;
         self->opts.ext.enable_tm = false;
+
+        mutex_init(&self->toolchain.lock);
+        self->toolchain.llc_detected = false;
+        self->toolchain.llc_found = false;
+        self->toolchain.llc_is_clang = false;
+        self->toolchain.llc_key_detected = false;
+        self->toolchain.llc_key = 0;
 }
 
 extern void cc_dispose(cc_instance* self)
@@ -57,6 +73,11 @@ extern void cc_dispose(cc_instance* self)
         vec_drop(&self->input.sources);
         vec_drop(&self->input.builtin_sources);
         vec_drop(&self->input.obj_files);
+        vec_drop(&self->input.include_dirs);
+        for (int i = 0; i < self->output.builtin_obj_files.size; i++)
+                dealloc(self->output.builtin_obj_files.items[i]);
+        vec_drop(&self->output.builtin_obj_files);
+        mutex_drop(&self->toolchain.lock);
 }
 
 extern void cc_set_output_stream(cc_instance* self, FILE* out)
@@ -85,7 +106,7 @@ extern void cc_add_lib_dir(cc_instance* self, const char* dir)
         flookup_add(&self->input.lib_lookup, dir);
 }
 
-extern errcode cc_add_lib(cc_instance* self, const char* lib, bool is_implicit)
+extern void cc_push_lib(struct vec* libs, const char* lib)
 {
         const char* default_ext = ".lib";
         char* s = alloc(strlen(lib) + strlen(default_ext) + 1);
@@ -93,7 +114,12 @@ extern errcode cc_add_lib(cc_instance* self, const char* lib, bool is_implicit)
         if (!*pathext(lib))
                 strcat(s, default_ext);
 
-        vec_push(is_implicit ? &self->input.implicit_libs : &self->input.libs, s);
+        vec_push(libs, s);
+}
+
+extern errcode cc_add_lib(cc_instance* self, const char* lib, bool is_implicit)
+{
+        cc_push_lib(is_implicit ? &self->input.implicit_libs : &self->input.libs, lib);
         return EC_NO_ERROR;
 }
 
@@ -102,6 +128,12 @@ extern void cc_add_source_dir(cc_instance* self, const char* dir)
         flookup_add(&self->input.source_lookup, dir);
 }
 
+extern void cc_add_include_dir(cc_instance* self, const char* dir)
+{
+        cc_add_source_dir(self, dir);
+        vec_push(&self->input.include_dirs, (void*)dir);
+}
+
 extern errcode cc_add_source_file(cc_instance* self, const char* file, bool builtin)
 {
         file_entry* source = file_get(&self->input.source_lookup, file);
@@ -128,6 +160,19 @@ extern errcode cc_add_obj_file(cc_instance* self, const char* file)
         return EC_NO_ERROR;
 }
 
+extern errcode cc_set_pch(cc_instance* self, const char* file)
+{
+        file_entry* pch = file_get(&self->input.source_lookup, file);
+        if (!pch)
+        {
+                cc_file_doesnt_exit(self, file);
+                return EC_ERROR;
+        }
+
+        self->input.pch = pch;
+        return EC_NO_ERROR;
+}
+
 extern errcode cc_emulate_source_file(
         cc_instance* self, const char* file, const char* content, bool builtin, bool add_to_input)
 {
@@ -153,16 +198,23 @@ extern errcode cc_run(cc_instance* self)
                 return EC_ERROR;
         }
 
+        if (self->opts.ext.enable_tm && EC_FAILED(cc_precompile_tm_decls(self)))
+                return EC_ERROR;
+        if (EC_FAILED(cc_check_pch(self)))
+                return EC_ERROR;
+
         switch (self->output.kind)
         {
                 case COK_NONE: return cc_perform_syntax_analysis(self);
                 case COK_EXEC: return cc_generate_exec(self);
                 case COK_OBJ: return cc_generate_obj(self);
                 case COK_LEXEMES: return cc_dump_tokens(self);
+                case COK_PREPROCESSED: return cc_preprocess(self);
                 case COK_C: return cc_dump_tree(self);
                 case COK_SSA: return cc_generate_ssa(self);
                 case COK_ASM: return cc_generate_asm(self);
                 case COK_LLVM_IR: return cc_generate_llvm_ir(self);
+                case COK_PCH: return cc_generate_pch(self);
         }
         return EC_ERROR;
 }
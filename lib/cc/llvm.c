@@ -44,17 +44,24 @@ void llc_init(struct llc* self, const char* llc_path)
 
 static bool cmd_exists(const char* cmd)
 {
+#ifdef _WIN32
+        const char* null_device = "nul";
+#else
+        const char* null_device = "/dev/null";
+#endif
         char buf[128];
-        snprintf(buf, 128, "%s --version > nul 2> nul", cmd);
+        snprintf(buf, 128, "%s --version > %s 2> %s", cmd, null_device, null_device);
         return system(buf) == 0;
 }
 
+#ifdef _WIN32
 static bool check_program_files(struct pathbuf* pb, const char* rel)
 {
         *pb = pathbuf_from_str("C:\\PROGRA~1\\");
         join(pb, rel);
         return isfile(pb->buf);
 }
+#endif
 
 static bool try_detect(struct pathbuf* result, int num_opts, const char** opts)
 {
@@ -65,8 +72,10 @@ static bool try_detect(struct pathbuf* result, int num_opts, const char** opts)
                         *result = pathbuf_from_str(opts[i]);
                         return true;
                 }
+#ifdef _WIN32
                 else if (check_program_files(result, opts[i]))
                         return true;
+#endif
         }
         return false;
 }
@@ -74,11 +83,16 @@ static bool try_detect(struct pathbuf* result, int num_opts, const char** opts)
 bool llc_try_detect(struct llc* self)
 {
         const char* opts[] = {
+#ifdef _WIN32
                 "LLVM\\bin\\llc.exe",
                 "llc.exe",
                 // Fall back to clang if llc is not available
                 "LLVM\\bin\\clang.exe",
-                "clang.exe", 
+                "clang.exe",
+#else
+                "llc",
+                "clang",
+#endif
         };
         llc_init(self, "");
         if (!try_detect(&self->path, ARRAY_SIZE(opts), opts))
@@ -125,44 +139,89 @@ static const char* clang_opts[] = {
         "-m64"
 };
 
-int llc_run(struct llc* self)
+static void llc_get_args(struct llc* self, struct args* args, struct pathbuf* clang_out)
 {
-        struct args args;
-        args_init(&args);
-
-        add_arg(&args, self->input);
+        args_init(args);
+        if (self->input)
+                add_arg(args, self->input);
+        else
+        {
+                // the module is read from the standard input
+                if (self->is_clang)
+                {
+                        add_arg(args, "-x");
+                        add_arg(args, "ir");
+                }
+                add_arg(args, "-");
+        }
 
-        struct pathbuf clang_out;
         if (!self->output && self->is_clang)
         {
                 // Force clang to emit .obj file for compatibility
-                clang_out = pathbuf_from_str(self->input);
-                strcpy((char*)pathext(clang_out.buf), "obj");
-                add_arg(&args, "-o");
-                add_arg(&args, clang_out.buf);
+                assert(self->input && "Output of clang reading from stdin is not set");
+                *clang_out = pathbuf_from_str(self->input);
+                strcpy((char*)pathext(clang_out->buf), "obj");
+                add_arg(args, "-o");
+                add_arg(args, clang_out->buf);
         }
         else if (self->output)
         {
-                add_arg(&args, "-o");
-                add_arg(&args, self->output);
+                add_arg(args, "-o");
+                add_arg(args, self->output);
         }
 
         for (int i = 0; i < self->num_opts; i++)
         {
                 int opt = self->opts[i];
                 assert(opt < ARRAY_SIZE(llc_opts) && "Unknown option");
-                add_arg(&args, self->is_clang ? clang_opts[opt] : llc_opts[opt]);
+                add_arg(args, self->is_clang ? clang_opts[opt] : llc_opts[opt]);
         }
         if (self->is_clang)
-                add_arg(&args, "-Wno-override-module");
+                add_arg(args, "-Wno-override-module");
 
         // printf("llc >> %s\n", self->path.buf);
-        // for (int i = 0; i < args.argc; i++)
-        //        printf("llc >> %s\n", args.argv[i]);
+        // for (int i = 0; i < args->argc; i++)
+        //        printf("llc >> %s\n", args->argv[i]);
+}
 
+int llc_run(struct llc* self)
+{
+        struct args args;
+        struct pathbuf clang_out;
+        llc_get_args(self, &args, &clang_out);
         return execute(self->path.buf, args.argc, args.argv);
 }
 
+FILE* llc_open(struct llc* self)
+{
+        struct args args;
+        struct pathbuf clang_out;
+        self->input = NULL;
+        llc_get_args(self, &args, &clang_out);
+        return execute_with_input(self->path.buf, args.argc, args.argv);
+}
+
+int llc_close(FILE* input)
+{
+        return wait_execute(input);
+}
+
+bool llc_get_version(struct llc* self, char* version, size_t size)
+{
+        const char* args[] = { "--version" };
+        FILE* output = execute_with_output(self->path.buf, ARRAY_SIZE(args), args);
+        if (!output)
+                return false;
+
+        size_t n = fread(version, 1, size - 1, output);
+        version[n] = '\0';
+        // the rest is read as well, so that llc is not stopped by a broken pipe
+        char rest[256];
+        while (fread(rest, 1, sizeof(rest), output))
+                ;
+        return wait_execute(output) == 0 && n;
+}
+
 void lld_init(struct lld* self, const char* lld_path)
 {
         self->path = pathbuf_from_str(lld_path);
@@ -186,8 +245,12 @@ void lld_drop(struct lld* self)
 bool lld_try_detect(struct lld* self)
 {
         const char* opts[] = {
+#ifdef _WIN32
                 "LLVM\\bin\\lld-link.exe",
                 "lld-link.exe",
+#else
+                "lld-link",
+#endif
         };
         lld_init(self, "");
         return try_detect(&self->path, ARRAY_SIZE(opts), opts);
@@ -1,5 +1,6 @@
 #include "scc/core/cmd.h"
 #include "scc/core/file.h"
+#include <stdio.h>
 #include <stdlib.h> // strtoi
 #include <string.h>
 
@@ -92,12 +93,48 @@ static void append_cmd(struct cmdbuf* buf, const char* arg)
         buf->pos += snprintf(buf->pos, rem, (has_spaces ? "\"%s\" " : "%s "), arg);
 }
 
+static void build_cmd(struct cmdbuf* cmd, const char* path, int argc, const char** argv)
+{
+        cmd->pos = cmd->buf;
+        append_cmd(cmd, path);
+        for (int i = 0; i < argc; i++)
+                append_cmd(cmd, argv[i]);
+}
+
 int execute(const char* path, int argc, const char** argv)
 {
         struct cmdbuf cmd;
-        cmd.pos = cmd.buf;
-        append_cmd(&cmd, path);
-        for (int i = 0; i < argc; i++)
-                append_cmd(&cmd, argv[i]);
+        build_cmd(&cmd, path, argc, argv);
         return system(cmd.buf);
 }
+
+FILE* execute_with_input(const char* path, int argc, const char** argv)
+{
+        struct cmdbuf cmd;
+        build_cmd(&cmd, path, argc, argv);
+#ifdef _WIN32
+        return _popen(cmd.buf, "wb");
+#else
+        return popen(cmd.buf, "w");
+#endif
+}
+
+FILE* execute_with_output(const char* path, int argc, const char** argv)
+{
+        struct cmdbuf cmd;
+        build_cmd(&cmd, path, argc, argv);
+#ifdef _WIN32
+        return _popen(cmd.buf, "rb");
+#else
+        return popen(cmd.buf, "r");
+#endif
+}
+
+int wait_execute(FILE* input)
+{
+#ifdef _WIN32
+        return _pclose(input);
+#else
+        return pclose(input);
+#endif
+}
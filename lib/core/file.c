@@ -6,12 +6,21 @@
 #include "scc/core/hash.h"
 
 #include <stdio.h>
+#include <string.h>
 
+#ifdef _WIN32
 #include <Windows.h>
 #include <Shlwapi.h>
-#include <string.h>
-
 #define PATH_DELIMETER '\\'
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PATH_DELIMETER '/'
+#endif
 
 static int is_sep(int sep)
 {
@@ -33,8 +42,13 @@ struct pathbuf pathbuf_from_str(const char* s)
 
 void cwd(struct pathbuf* path)
 {
+#ifdef _WIN32
         if (!GetCurrentDirectory(MAX_PATH_LEN, path->buf))
                 UNREACHABLE();
+#else
+        if (!getcwd(path->buf, MAX_PATH_LEN))
+                UNREACHABLE();
+#endif
         addsep(path);
 }
 
@@ -75,6 +89,8 @@ void join(struct pathbuf* path, const char* extra)
         fixpath(path);
 }
 
+#ifdef _WIN32
+
 int abspath(struct pathbuf* dst, const char* src)
 {
         return !GetFullPathName(src, MAX_PATH_LEN, dst->buf, NULL)
@@ -95,6 +111,70 @@ int isfile(const char* path)
         return !(att & FILE_ATTRIBUTE_DIRECTORY);
 }
 
+#else
+
+// removes '.' and '..' components from an absolute path, like GetFullPathName does
+static void normpath(char* path)
+{
+        char* out = path + 1;
+        const char* it = path + 1;
+        while (*it)
+        {
+                const char* end = it;
+                while (*end && !is_sep(*end))
+                        end++;
+
+                size_t len = end - it;
+                if (len == 2 && it[0] == '.' && it[1] == '.')
+                {
+                        if (out != path + 1)
+                                out--;
+                        while (out != path + 1 && !is_sep(out[-1]))
+                                out--;
+                }
+                else if (len && !(len == 1 && *it == '.'))
+                {
+                        memmove(out, it, len);
+                        out += len;
+                        if (*end)
+                                *out++ = PATH_DELIMETER;
+                }
+
+                it = *end ? end + 1 : end;
+        }
+        *out = '\0';
+}
+
+int abspath(struct pathbuf* dst, const char* src)
+{
+        struct pathbuf path;
+        if (is_sep(*src))
+                path = pathbuf_from_str("/");
+        else
+                cwd(&path);
+        if (strlen(path.buf) + strlen(src) >= MAX_PATH_LEN)
+                return -1;
+
+        join(&path, src);
+        normpath(path.buf);
+        *dst = path;
+        return 0;
+}
+
+int isdir(const char* path)
+{
+        struct stat st;
+        return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+int isfile(const char* path)
+{
+        struct stat st;
+        return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+#endif
+
 const char* pathfile(const char* path)
 {
         size_t len = strlen(path);
@@ -133,6 +213,39 @@ const char* pathext(const char* path)
         return path + len;
 }
 
+int fs_copyfile(const char* from, const char* to)
+{
+        FILE* in = fopen(from, "rb");
+        if (!in)
+                return -1;
+        FILE* out = fopen(to, "wb");
+        if (!out)
+        {
+                fclose(in);
+                return -1;
+        }
+
+        char buf[4096];
+        size_t n;
+        int result = 0;
+        while ((n = fread(buf, 1, sizeof(buf), in)))
+        {
+                if (fwrite(buf, 1, n, out) != n)
+                {
+                        result = -1;
+                        break;
+                }
+        }
+        if (ferror(in))
+                result = -1;
+        fclose(in);
+        if (fclose(out))
+                result = -1;
+        return result;
+}
+
+#ifdef _WIN32
+
 size_t fs_filesize(const char* path)
 {
         size_t size = 0;
@@ -152,13 +265,132 @@ int fs_delfile(const char* file)
         return DeleteFile(file) ? 0 : -1;
 }
 
-static file_entry* new_file_entry(const char* path, const char* content)
+int fs_usertmpdir(struct pathbuf* path)
+{
+        // the temporary directory belongs to the current user already
+        DWORD len = GetTempPath(MAX_PATH_LEN + 1, path->buf);
+        if (!len || len > MAX_PATH_LEN)
+                return -1;
+        join(path, "scc");
+        return CreateDirectory(path->buf, NULL) || GetLastError() == ERROR_ALREADY_EXISTS ? 0 : -1;
+}
+
+void fs_tmpname(struct pathbuf* tmp, const char* path)
+{
+        *tmp = pathbuf_from_str(path);
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".%lu", (unsigned long)GetCurrentProcessId());
+        strncat(tmp->buf, suffix, MAX_PATH_LEN - strlen(tmp->buf));
+}
+
+// empty files cannot be mapped, *content is set to NULL for them
+static int fs_map(const char* path, char** content, size_t* size)
+{
+        HANDLE h = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_READONLY, NULL);
+        if (h == INVALID_HANDLE_VALUE)
+                return -1;
+
+        int result = -1;
+        LARGE_INTEGER i;
+        *content = NULL;
+        if (GetFileSizeEx(h, &i)) {
+                *size = (size_t)i.QuadPart;
+                HANDLE m = *size
+                        ? CreateFileMapping(h, NULL, PAGE_READONLY, 0, 0, NULL)
+                        : NULL;
+                if (m) {
+                        *content = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+                        CloseHandle(m);
+                }
+                result = *size && !*content ? -1 : 0;
+        }
+        CloseHandle(h);
+        return result;
+}
+
+static void fs_unmap(char* content, size_t size)
+{
+        UnmapViewOfFile(content);
+}
+
+#else
+
+size_t fs_filesize(const char* path)
+{
+        struct stat st;
+        return stat(path, &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+int fs_delfile(const char* file)
+{
+        return unlink(file);
+}
+
+int fs_usertmpdir(struct pathbuf* path)
+{
+        const char* tmp = getenv("TMPDIR");
+        *path = pathbuf_from_str(tmp && *tmp ? tmp : "/tmp");
+        char name[32];
+        snprintf(name, sizeof(name), "scc-%u", (unsigned)getuid());
+        join(path, name);
+        if (mkdir(path->buf, 0700) != 0 && errno != EEXIST)
+                return -1;
+
+        // a directory created by another user is not used
+        struct stat st;
+        return lstat(path->buf, &st) == 0 && S_ISDIR(st.st_mode) && st.st_uid == getuid() ? 0 : -1;
+}
+
+void fs_tmpname(struct pathbuf* tmp, const char* path)
+{
+        *tmp = pathbuf_from_str(path);
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".%lu", (unsigned long)getpid());
+        strncat(tmp->buf, suffix, MAX_PATH_LEN - strlen(tmp->buf));
+}
+
+// empty files cannot be mapped, *content is set to NULL for them
+static int fs_map(const char* path, char** content, size_t* size)
+{
+        int fd = open(path, O_RDONLY);
+        if (fd == -1)
+                return -1;
+
+        int result = -1;
+        struct stat st;
+        *content = NULL;
+        if (fstat(fd, &st) == 0) {
+                *size = (size_t)st.st_size;
+                void* p = *size
+                        ? mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0)
+                        : NULL;
+                if (p != MAP_FAILED) {
+                        *content = p;
+                        result = 0;
+                }
+        }
+        close(fd);
+        return result;
+}
+
+static void fs_unmap(char* content, size_t size)
+{
+        munmap(content, size);
+}
+
+#endif
+
+static file_entry* new_file_entry(file_lookup* lookup, const char* path, const char* content)
 {
         file_entry* e = alloc(sizeof(*e));
+        e->lookup = lookup;
         e->path = alloc(strlen(path) + 1);
         strcpy(e->path, path);
         e->is_virtual = 0;
         e->virtual_content = 0;
+        e->mapped_content = 0;
+        e->mapped_size = 0;
         if (content)
         {
                 e->is_virtual = 1;
@@ -173,20 +405,45 @@ static void del_file_entry(file_entry* e)
         dealloc(e->path);
         if (e->is_virtual)
                 dealloc(e->virtual_content);
+        if (e->mapped_content)
+                fs_unmap(e->mapped_content, e->mapped_size);
         dealloc(e);
 }
 
 extern size_t file_size(const file_entry* e)
 {
-        return e->is_virtual
-                ? strlen(e->virtual_content)
+        if (e->is_virtual)
+                return strlen(e->virtual_content);
+
+        mutex_lock(&e->lookup->lock);
+        size_t size = e->mapped_content
+                ? e->mapped_size
                 : fs_filesize(e->path);
+        mutex_release(&e->lookup->lock);
+        return size;
+}
+
+extern const char* file_map(file_entry* e, size_t* size)
+{
+        if (e->is_virtual)
+        {
+                *size = strlen(e->virtual_content);
+                return e->virtual_content;
+        }
+
+        mutex_lock(&e->lookup->lock);
+        const char* content = e->mapped_content;
+        if (!content && !fs_map(e->path, &e->mapped_content, &e->mapped_size))
+                content = e->mapped_content ? e->mapped_content : "";
+        *size = e->mapped_size;
+        mutex_release(&e->lookup->lock);
+        return content;
 }
 
 static file_entry* flookup_new_entry(file_lookup* self, const char* path, const char* content)
 {
-        file_entry* e = new_file_entry(path, content);
-        hashmap_insert(&self->lookup, strhash(path), e);
+        file_entry* e = new_file_entry(self, path, content);
+        file_path_map_insert(&self->lookup, e->path, (unsigned)strlen(e->path), e);
         return e;
 }
 
@@ -196,19 +453,24 @@ static file_entry* flookup_new_entry(file_lookup* self, const char* path, const
 
 extern void flookup_init(file_lookup* self)
 {
-        hashmap_init(&self->lookup);
+        file_path_map_init(&self->lookup);
         self->dirs = dirs_new();
+        mutex_init(&self->lock);
 }
 
 extern void flookup_dispose(file_lookup* self)
 {
-        HASHMAP_FOREACH(&self->lookup, it)
+        for (struct file_path_map_iter it = file_path_map_begin(&self->lookup);
+                it.pos != it.end; file_path_map_next(&it))
+        {
                 del_file_entry(it.pos->value);
-        hashmap_drop(&self->lookup);
+        }
+        file_path_map_drop(&self->lookup);
 
         for (int i = 0; i < self->dirs->size; i++)
                 dealloc(self->dirs->items[i]);
         dirs_del(self->dirs);
+        mutex_drop(&self->lock);
 }
 
 extern void flookup_add(file_lookup* self, const char* dir)
@@ -239,7 +501,8 @@ static file_entry* file_get_without_lookup(file_lookup* self, const char* path)
         struct pathbuf abs;
         if (abspath(&abs, path))
                 return NULL;
-        struct hashmap_entry* entry = hashmap_lookup(&self->lookup, strhash(abs.buf));
+        struct file_path_map_entry* entry = file_path_map_lookup(
+                &self->lookup, abs.buf, (unsigned)strlen(abs.buf));
         if (entry)
                 return entry->value;
         if (!isfile(abs.buf))
@@ -255,7 +518,8 @@ static file_entry* file_get_with_lookup(file_lookup* self, const char* path)
                         continue;
                 join(&abs, path);
 
-                struct hashmap_entry* entry = hashmap_lookup(&self->lookup, strhash(abs.buf));
+                struct file_path_map_entry* entry = file_path_map_lookup(
+                        &self->lookup, abs.buf, (unsigned)strlen(abs.buf));
                 if (entry)
                         return entry->value;
 
@@ -267,8 +531,12 @@ static file_entry* file_get_with_lookup(file_lookup* self, const char* path)
 
 extern file_entry* file_get(file_lookup* lookup, const char* path)
 {
+        mutex_lock(&lookup->lock);
         file_entry* entry = file_get_without_lookup(lookup, path);
-        return entry ? entry : file_get_with_lookup(lookup, path);
+        if (!entry)
+                entry = file_get_with_lookup(lookup, path);
+        mutex_release(&lookup->lock);
+        return entry;
 }
 
 extern file_entry* file_emulate(
@@ -277,5 +545,21 @@ extern file_entry* file_emulate(
         struct pathbuf abs;
         cwd(&abs);
         join(&abs, path);
-        return flookup_new_entry(lookup, abs.buf, content);
+        mutex_lock(&lookup->lock);
+        file_entry* entry = flookup_new_entry(lookup, abs.buf, content);
+        mutex_release(&lookup->lock);
+        return entry;
+}
+
+extern void file_drop_emulated(file_entry* entry)
+{
+        file_lookup* lookup = entry->lookup;
+        unsigned size = (unsigned)strlen(entry->path);
+        mutex_lock(&lookup->lock);
+        // the lookup keeps the first file of a path, which may be another one
+        struct file_path_map_entry* e = file_path_map_lookup(&lookup->lookup, entry->path, size);
+        if (e && e->value == entry)
+                file_path_map_erase(&lookup->lookup, entry->path, size);
+        mutex_release(&lookup->lock);
+        del_file_entry(entry);
 }
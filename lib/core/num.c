@@ -167,7 +167,18 @@ op_result num_mul(struct num* self, const struct num* rhs)
 op_result num_div(struct num* self, const struct num* rhs)
 {
         CHECK_OP(self, rhs);
-        if (num_is_integral(self))
+        if (self->kind == NUM_INT)
+        {
+                int64_t x = num_i64(self);
+                int64_t y = num_i64(rhs);
+                if (y == 0)
+                        return OR_DIV_BY_ZERO;
+                if (y == -1 && x == INT64_MIN)
+                        return OR_OVERFLOW;
+                self->_u64 = mod2((uint64_t)(x / y), self->num_bits);
+                return OR_OK;
+        }
+        else if (self->kind == NUM_UINT)
         {
                 uint64_t x = self->_u64;
                 uint64_t y = rhs->_u64;
@@ -244,7 +255,10 @@ op_result num_bit_shr(struct num* self, const struct num* rhs)
         {
                 uint64_t x = self->_u64;
                 uint64_t y = rhs->_u64;
-                self->_u64 = mod2(x >> y, self->num_bits);
+                // negative numbers are shifted arithmetically
+                self->_u64 = self->kind == NUM_INT
+                        ? mod2((uint64_t)(num_i64(self) >> y), self->num_bits)
+                        : mod2(x >> y, self->num_bits);
                 return self->_u64 << y != x ? OR_UNDERFLOW : OR_OK;
         }
         else if (self->kind == NUM_FLOAT)
@@ -339,9 +353,11 @@ void num_to_int(struct num* self, unsigned num_bits)
 {
         if (num_is_integral(self))
         {
+                // negative numbers are sign-extended from their width
+                uint64_t x = self->kind == NUM_INT ? (uint64_t)num_i64(self) : self->_u64;
                 self->kind = NUM_INT;
                 self->num_bits = num_bits;
-                self->_u64 = mod2(self->_u64, num_bits);         
+                self->_u64 = mod2(x, num_bits);
         }
         else if (is_f32(self))
                 init_int(self, (int64_t)self->_f32, num_bits);
@@ -355,9 +371,11 @@ void num_to_uint(struct num* self, unsigned num_bits)
 {
         if (num_is_integral(self))
         {
+                // negative numbers are sign-extended from their width
+                uint64_t x = self->kind == NUM_INT ? (uint64_t)num_i64(self) : self->_u64;
                 self->kind = NUM_UINT;
                 self->num_bits = num_bits;
-                self->_u64 = mod2(self->_u64, num_bits);
+                self->_u64 = mod2(x, num_bits);
         }
         else if (is_f32(self))
                 init_uint(self, (uint64_t)self->_f32, num_bits);
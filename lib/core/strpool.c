@@ -1,46 +1,44 @@
 #include "scc/core/strpool.h"
 
-#include "scc/core/hash.h"
-
-#include <string.h> // memcmp
+#include <string.h> // memcpy
 
 static struct strentry empty;
 
 void init_strpool(struct strpool* self)
 {
-        hashmap_init(&self->map);
+        strpool_map_init(&self->map);
+        vec_init(&self->entries);
         init_stack_alloc(&self->alloc);
 }
 
 void drop_strpool(struct strpool* self)
 {
-        hashmap_drop(&self->map);
+        strpool_map_drop(&self->map);
+        vec_drop(&self->entries);
         drop_stack_alloc(&self->alloc);
 }
 
 int strpool_has(const struct strpool* self, unsigned ref)
 {
-        return !ref ? 1 : hashmap_has(&self->map, ref);
+        return ref <= self->entries.size;
 }
 
 unsigned strpool_insert(struct strpool* self, const void* data, size_t size)
 {
         if (!size)
                 return 0;
-        unsigned ref = hash(data, size);
-        for (unsigned i = 1; ; i++) {
-                struct strentry* entry = strpool_lookup(self, ref);
-                if (entry && entry->size == size && memcmp(entry->data, data, size) == 0)
-                        return ref;
-                else if (hashmap_key_ok(ref) && ref != 0)
-                        break;
-                ref += i;
-        }
+
+        struct strpool_map_entry* e = strpool_map_lookup(&self->map, data, (unsigned)size);
+        if (e)
+                return e->value;
 
         struct strentry* copy = stack_alloc(&self->alloc, sizeof(struct strentry) + size);
         copy->size = size;
         memcpy(copy->data, data, size);
-        hashmap_insert(&self->map, ref, copy);
+        vec_push(&self->entries, copy);
+
+        unsigned ref = (unsigned)self->entries.size;
+        strpool_map_insert(&self->map, copy->data, (unsigned)size, ref);
         return ref;
 }
 
@@ -48,6 +46,5 @@ struct strentry* strpool_lookup(const struct strpool* self, unsigned ref)
 {
         if (!ref)
                 return &empty;
-        struct hashmap_entry* e = hashmap_lookup(&self->map, ref);
-        return e ? e->value : 0;
+        return ref <= self->entries.size ? self->entries.items[ref - 1] : 0;
 }
@@ -0,0 +1,109 @@
+#include "scc/core/thread.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+void thread_init(struct thread* self, void(*entry)(void*), void* data)
+{
+        self->entry = entry;
+        self->data = data;
+}
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_entry(void* param)
+{
+        struct thread* self = param;
+        self->entry(self->data);
+        return 0;
+}
+
+int thread_start(struct thread* self)
+{
+        self->handle = CreateThread(NULL, 0, &thread_entry, self, 0, NULL);
+        return self->handle ? 0 : -1;
+}
+
+void thread_wait(const struct thread* self)
+{
+        WaitForSingleObject(self->handle, INFINITE);
+        CloseHandle(self->handle);
+}
+
+unsigned num_hardware_threads(void)
+{
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+}
+
+static_assert(sizeof(SRWLOCK) == sizeof(void*), "struct mutex needs an update");
+
+void mutex_init(struct mutex* self)
+{
+        InitializeSRWLock((SRWLOCK*)&self->lock);
+}
+
+void mutex_drop(struct mutex* self)
+{
+}
+
+void mutex_lock(struct mutex* self)
+{
+        AcquireSRWLockExclusive((SRWLOCK*)&self->lock);
+}
+
+void mutex_release(struct mutex* self)
+{
+        ReleaseSRWLockExclusive((SRWLOCK*)&self->lock);
+}
+
+#else
+
+static void* thread_entry(void* param)
+{
+        struct thread* self = param;
+        self->entry(self->data);
+        return NULL;
+}
+
+int thread_start(struct thread* self)
+{
+        return pthread_create(&self->handle, NULL, &thread_entry, self) ? -1 : 0;
+}
+
+void thread_wait(const struct thread* self)
+{
+        pthread_join(self->handle, NULL);
+}
+
+unsigned num_hardware_threads(void)
+{
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        return n > 0 ? (unsigned)n : 1;
+}
+
+void mutex_init(struct mutex* self)
+{
+        pthread_mutex_init(&self->lock, NULL);
+}
+
+void mutex_drop(struct mutex* self)
+{
+        pthread_mutex_destroy(&self->lock);
+}
+
+void mutex_lock(struct mutex* self)
+{
+        pthread_mutex_lock(&self->lock);
+}
+
+void mutex_release(struct mutex* self)
+{
+        pthread_mutex_unlock(&self->lock);
+}
+
+#endif
@@ -1,5 +1,13 @@
 #include "scc/lex/charset.h"
 
+#if !defined(__SCC__) && (defined(__SSE2__) || defined(_M_X64))
+#define C_CHARSET_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 const int c_char_info_table[256] =
 {
         CCK_UNKNOWN,    CCK_UNKNOWN,    CCK_UNKNOWN,    CCK_UNKNOWN,
@@ -82,4 +90,119 @@ const int c_char_info_table[256] =
         CCK_UNKNOWN,    CCK_UNKNOWN,    CCK_UNKNOWN,    CCK_UNKNOWN,
         CCK_UNKNOWN,    CCK_UNKNOWN,    CCK_UNKNOWN,    CCK_UNKNOWN,
         CCK_UNKNOWN,    CCK_UNKNOWN,    CCK_UNKNOWN,    CCK_UNKNOWN,
-};
\ No newline at end of file
+};
+
+#ifdef C_CHARSET_SSE2
+
+static inline unsigned c_char_first_bit(unsigned mask)
+{
+#ifdef _MSC_VER
+        unsigned long i;
+        _BitScanForward(&i, mask);
+        return (unsigned)i;
+#else
+        return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+// returns the mask of bytes in [lo, hi]
+static inline __m128i c_char_in_range(__m128i v, char lo, char hi)
+{
+        // shift lo to -128 so that the signed comparison checks both bounds
+        __m128i x = _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - lo)));
+        return _mm_cmplt_epi8(x, _mm_set1_epi8((char)(-0x80 + hi - lo + 1)));
+}
+
+static inline __m128i c_char_equal(__m128i v, char c)
+{
+        return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+
+// returns the position of the first byte set in the 16-bit mask, or NULL
+static inline const char* c_char_first_of_mask(const char* pos, __m128i m)
+{
+        unsigned mask = (unsigned)_mm_movemask_epi8(m);
+        return mask ? pos + c_char_first_bit(mask) : NULL;
+}
+
+static inline const char* c_char_first_not_of_mask(const char* pos, __m128i m)
+{
+        unsigned mask = ~(unsigned)_mm_movemask_epi8(m) & 0xFFFF;
+        return mask ? pos + c_char_first_bit(mask) : NULL;
+}
+
+#endif
+
+extern const char* c_char_skip_identifier(const char* pos, const char* end)
+{
+#ifdef C_CHARSET_SSE2
+        for (; end - pos >= 16; pos += 16)
+        {
+                __m128i v = _mm_loadu_si128((const __m128i*)pos);
+                __m128i m = _mm_or_si128(
+                        c_char_in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z'),
+                        _mm_or_si128(c_char_in_range(v, '0', '9'), c_char_equal(v, '_')));
+                const char* stop = c_char_first_not_of_mask(pos, m);
+                if (stop)
+                        return stop;
+        }
+#endif
+        while (pos != end && (c_char_info_table[(unsigned char)*pos] & (CCK_LETTER | CCK_DIGIT)))
+                pos++;
+        return pos;
+}
+
+extern const char* c_char_skip_spaces(const char* pos, const char* end)
+{
+#ifdef C_CHARSET_SSE2
+        for (; end - pos >= 16; pos += 16)
+        {
+                __m128i v = _mm_loadu_si128((const __m128i*)pos);
+                __m128i m = _mm_or_si128(c_char_equal(v, ' '), c_char_equal(v, '\t'));
+                const char* stop = c_char_first_not_of_mask(pos, m);
+                if (stop)
+                        return stop;
+        }
+#endif
+        while (pos != end && (*pos == ' ' || *pos == '\t'))
+                pos++;
+        return pos;
+}
+
+extern const char* c_char_skip_line_comment(const char* pos, const char* end)
+{
+#ifdef C_CHARSET_SSE2
+        for (; end - pos >= 16; pos += 16)
+        {
+                __m128i v = _mm_loadu_si128((const __m128i*)pos);
+                __m128i m = _mm_or_si128(
+                        _mm_or_si128(c_char_equal(v, '\n'), c_char_equal(v, '\r')),
+                        c_char_equal(v, '\\'));
+                const char* stop = c_char_first_of_mask(pos, m);
+                if (stop)
+                        return stop;
+        }
+#endif
+        while (pos != end && *pos != '\n' && *pos != '\r' && *pos != '\\')
+                pos++;
+        return pos;
+}
+
+extern const char* c_char_skip_block_comment(const char* pos, const char* end)
+{
+#ifdef C_CHARSET_SSE2
+        for (; end - pos >= 16; pos += 16)
+        {
+                __m128i v = _mm_loadu_si128((const __m128i*)pos);
+                __m128i m = _mm_or_si128(
+                        _mm_or_si128(c_char_equal(v, '\n'), c_char_equal(v, '\r')),
+                        _mm_or_si128(c_char_equal(v, '\\'), c_char_equal(v, '*')));
+                const char* stop = c_char_first_of_mask(pos, m);
+                if (stop)
+                        return stop;
+        }
+#endif
+        while (pos != end && *pos != '\n' && *pos != '\r' && *pos != '\\' && *pos != '*')
+                pos++;
+        return pos;
+}
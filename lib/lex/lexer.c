@@ -1,46 +1,60 @@
 #include "scc/lex/lexer.h"
 #include "scc/c-common/context.h"
+#include "scc/c-common/limits.h"
+#include "scc/c-common/source.h"
+#include "scc/core/file.h"
 #include "scc/tree/context.h"
 #include "scc/lex/misc.h"
 #include "scc/lex/reswords-info.h"
 #include "errors.h"
 #include "numeric-literal.h"
+#include "macro.h"
+#include "scc/lex/charset.h"
 
-static_assert(CTK_TOTAL_SIZE == 116, "lexer reswords initialization needs an update");
-
-static void c_lexer_add_token(c_lexer* self, c_token_kind k, bool pp)
+extern void c_lexer_init(c_lexer* self, c_context* context)
 {
-        const c_resword_info* info = c_get_token_kind_info(k);
-        if (pp)
-                c_reswords_add_pp_resword(&self->reswords, info->string, k);
-        else
-                c_reswords_add_resword(&self->reswords, info->string, k);
+        c_reswords_init(&self->reswords, context);
+        c_preprocessor_init(&self->pp, &self->reswords, context);
 }
 
-static void c_lexer_init_reswords(c_lexer* self)
+// sources named *.i and sources beginning with a line marker, like the output of -E,
+// are preprocessed already
+static bool c_source_is_preprocessed(c_source* source)
 {
-        for (c_token_kind i = CTK_CHAR; i < CTK_CONST_INT; i++)
-                c_lexer_add_token(self, i, false);
-        for (c_token_kind i = CTK_PP_IF; i <= CTK_PP_PRAGMA; i++)
-                c_lexer_add_token(self, i, true);
+        file_entry* file = c_source_get_file(source);
+        if (strcmp(pathext(file->path), "i") == 0)
+                return true;
 
-        if (self->pp.context->lang_opts.ext.tm_enabled)
-                for (c_token_kind i = CTK_ATOMIC; i < CTK_TOTAL_SIZE; i++)
-                        c_lexer_add_token(self, i, false);
-}
+        size_t size;
+        const char* text = file_map(file, &size);
+        if (!text || !size || text[0] != '#')
+                return false;
 
-extern void c_lexer_init(c_lexer* self, c_context* context)
-{
-        c_reswords_init(&self->reswords, context);
-        c_preprocessor_init(&self->pp, &self->reswords, context);
-        c_lexer_init_reswords(self);
+        size_t i = 1;
+        while (i < size && text[i] == ' ')
+                i++;
+        return i < size && c_char_is_digit(text[i]);
 }
 
 extern errcode c_lexer_enter_source_file(c_lexer* self, c_source* source)
 {
+        // macros of a precompiled header have to be expanded in the source
+        self->pp.preprocessed = source
+                && !self->pp.context->pch
+                && c_source_is_preprocessed(source);
         return c_preprocessor_enter_source(&self->pp, source);
 }
 
+extern errcode c_lexer_enter_pch(c_lexer* self)
+{
+        c_context* context = self->pp.context;
+        if (!context->pch)
+                return EC_NO_ERROR;
+
+        c_source* pch = c_source_get_from_file(&context->source_manager, context->pch);
+        return pch ? c_preprocessor_enter_source(&self->pp, pch) : EC_ERROR;
+}
+
 extern void c_lexer_dispose(c_lexer* self)
 {
         c_reswords_dispose(&self->reswords);
@@ -105,8 +119,12 @@ extern errcode c_lex_source(c_context* context, file_entry* source, FILE* error,
         c_lexer lexer;
         c_lexer_init(&lexer, context);
         c_source* s = c_source_get_from_file(&context->source_manager, source);
-        if (!source || EC_FAILED(c_lexer_enter_source_file(&lexer, s)))
+        if (!source
+                || EC_FAILED(c_lexer_enter_source_file(&lexer, s))
+                || EC_FAILED(c_lexer_enter_pch(&lexer)))
+        {
                 goto cleanup;
+        }
 
         while (1)
         {
@@ -124,3 +142,212 @@ cleanup:
         c_lexer_dispose(&lexer);
         return code;
 }
+
+// strings of preprocessed tokens have their escape sequences resolved,
+// while strings of macro bodies are kept as they were written
+static void c_print_preprocessed_token(
+        const c_context* context, const c_token* t, bool raw_strings, struct buf_writer* output)
+{
+        c_token_kind k = c_token_get_kind(t);
+        if (k == CTK_ID || k == CTK_PP_NUM)
+                buf_write_str(output, tree_get_id_string(context->tree, c_token_get_string(t)));
+        else if (k == CTK_CONST_STRING)
+        {
+                buf_write_char(output, '"');
+                if (raw_strings)
+                        buf_write_str(output, tree_get_id_string(context->tree, c_token_get_string(t)));
+                else
+                {
+                        struct strentry* entry = tree_get_id_strentry(context->tree, c_token_get_string(t));
+                        char unescaped[C_MAX_LINE_LENGTH * 2];
+                        c_get_unescaped_string(unescaped, ARRAY_SIZE(unescaped), (const char*)entry->data, entry->size);
+                        buf_write_str(output, unescaped);
+                }
+                buf_write_char(output, '"');
+        }
+        else if (k == CTK_CONST_CHAR)
+        {
+                int c = c_token_get_char(t);
+                buf_write_char(output, '\'');
+                if (c_char_is_escape(c))
+                {
+                        buf_write_char(output, '\\');
+                        buf_write_char(output, c_char_from_escape(c));
+                }
+                else
+                        buf_write_char(output, c);
+                buf_write_char(output, '\'');
+        }
+        else
+                buf_write_str(output, c_get_token_kind_info(k)->string);
+}
+
+// Keeps the preprocessed text on the lines of the source: tokens of the same line
+// are separated by spaces, and a token on one of the next few lines is preceded by
+// new-lines. Otherwise a line marker is written, as in: # 12 "file.c"
+typedef struct
+{
+        const c_context* context;
+        struct buf_writer* output;
+        // source and line of the last written token
+        const c_source* source;
+        int line;
+} c_line_writer;
+
+static void c_line_writer_init(c_line_writer* self, const c_context* context, struct buf_writer* output)
+{
+        self->context = context;
+        self->output = output;
+        self->source = NULL;
+        self->line = 0;
+}
+
+static void c_print_line_marker(c_line_writer* self, bool first)
+{
+        char line[32];
+        snprintf(line, ARRAY_SIZE(line), "# %d \"", self->line);
+        const char* path = self->source->file->path;
+        char file[MAX_PATH_LEN * 2];
+        c_get_unescaped_string(file, ARRAY_SIZE(file), path, strlen(path) + 1);
+
+        if (!first)
+                buf_write_char(self->output, '\n');
+        buf_write_str(self->output, line);
+        buf_write_str(self->output, file);
+        buf_write_str(self->output, "\"\n");
+}
+
+// writes what separates the token from the previous one
+static void c_line_writer_advance(c_line_writer* self, const c_token* t)
+{
+        tree_location loc = c_token_get_loc(t);
+        const c_source* source = c_source_find_by_loc(&self->context->source_manager, loc);
+        int line = source ? c_source_get_line(source, loc) : 0;
+        if (!source || (source == self->source && line <= self->line))
+        {
+                if (self->source)
+                        buf_write_char(self->output, ' ');
+                return;
+        }
+
+        if (source == self->source && line - self->line <= 8)
+        {
+                for (; self->line < line; self->line++)
+                        buf_write_char(self->output, '\n');
+                return;
+        }
+
+        bool first = !self->source;
+        self->source = source;
+        self->line = line;
+        c_print_line_marker(self, first);
+}
+
+static errcode c_preprocess_to_text(
+        c_lexer* self, file_entry* source, bool line_markers, struct buf_writer* output)
+{
+        c_context* context = self->pp.context;
+        c_source* s = c_source_get_from_file(&context->source_manager, source);
+        if (!source
+                || EC_FAILED(c_lexer_enter_source_file(self, s))
+                || EC_FAILED(c_lexer_enter_pch(self)))
+        {
+                return EC_ERROR;
+        }
+
+        c_line_writer lines;
+        c_line_writer_init(&lines, context, output);
+        while (1)
+        {
+                c_token* t = c_preprocess(&self->pp);
+                if (!t)
+                        return EC_ERROR;
+                if (c_token_is(t, CTK_EOF))
+                {
+                        if (line_markers && lines.source)
+                                buf_write_char(output, '\n');
+                        c_token_delete(context, t);
+                        return EC_NO_ERROR;
+                }
+
+                if (line_markers)
+                        c_line_writer_advance(&lines, t);
+                c_print_preprocessed_token(context, t, false, output);
+                if (!line_markers)
+                        buf_write_char(output, c_token_is(t, CTK_SEMICOLON) ? '\n' : ' ');
+
+                // tokens are written as soon as they are preprocessed,
+                // so the memory of the token is reused by the next one
+                c_token_delete(context, t);
+        }
+}
+
+extern errcode c_preprocess_source(
+        c_context* context,
+        file_entry* source,
+        c_pragma_handlers handlers,
+        bool line_markers,
+        struct buf_writer* output)
+{
+        c_lexer lexer;
+        c_lexer_init(&lexer, context);
+        lexer.pp.pragma_handlers = handlers;
+        errcode code = c_preprocess_to_text(&lexer, source, line_markers, output);
+        c_lexer_dispose(&lexer);
+        return code;
+}
+
+static void c_print_macro_definition(
+        const c_context* context, const c_macro* macro, struct buf_writer* output)
+{
+        buf_write_str(output, "#define ");
+        buf_write_str(output, tree_get_id_string(context->tree, macro->name));
+        if (macro->function_like)
+        {
+                buf_write_char(output, '(');
+                for (size_t i = 0; i < c_macro_get_params_size(macro); i++)
+                {
+                        if (i)
+                                buf_write_str(output, ", ");
+                        buf_write_str(output, tree_get_id_string(context->tree, c_macro_get_param(macro, i)));
+                }
+                buf_write_char(output, ')');
+        }
+        C_FOREACH_MACRO_TOKEN(macro, it, end)
+        {
+                buf_write_char(output, ' ');
+                c_print_preprocessed_token(context, *it, true, output);
+        }
+        buf_write_char(output, '\n');
+}
+
+static errcode c_pch_on_link(void* output, const char* lib)
+{
+        buf_write_str(output, "\n#pragma link \"");
+        buf_write_str(output, lib);
+        buf_write_str(output, "\"\n");
+        return EC_NO_ERROR;
+}
+
+extern errcode c_emit_pch(c_context* context, file_entry* source, struct buf_writer* output)
+{
+        c_lexer lexer;
+        c_lexer_init(&lexer, context);
+        lexer.pp.pragma_handlers.on_link = c_pch_on_link;
+        lexer.pp.pragma_handlers.data = output;
+
+        errcode code = c_preprocess_to_text(&lexer, source, false, output);
+        if (EC_SUCCEEDED(code))
+        {
+                buf_write_char(output, '\n');
+                HASHMAP_FOREACH(&lexer.pp.macro_lookup, it)
+                {
+                        const c_macro* macro = it.pos->value;
+                        if (!macro->builtin)
+                                c_print_macro_definition(context, macro, output);
+                }
+        }
+
+        c_lexer_dispose(&lexer);
+        return code;
+}
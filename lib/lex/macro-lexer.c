@@ -9,17 +9,66 @@
 #include "errors.h"
 #include "macro.h"
 
+extern void c_macro_args_init(c_macro_args* self, c_context* context)
+{
+        self->context = context;
+        vec_init(&self->tokens);
+        c_macro_arg_vec_init(&self->args);
+}
+
+extern void c_macro_args_dispose(c_macro_args* self)
+{
+        // the lexer returns copies of argument tokens, so nothing refers to them anymore
+        for (size_t i = 0; i < self->tokens.size; i++)
+                c_token_delete(self->context, vec_get(&self->tokens, i));
+        vec_drop(&self->tokens);
+        c_macro_arg_vec_drop(&self->args);
+}
+
+// arguments are read one after another, so a token always belongs to the last one
+extern void c_macro_args_add(c_macro_args* self, size_t arg, c_token* token)
+{
+        if (arg == self->args.size)
+                c_macro_args_set_empty(self, arg);
+
+        assert(arg + 1 == self->args.size);
+        vec_push(&self->tokens, token);
+        c_macro_arg_vec_last_ptr(&self->args)->end = self->tokens.size;
+}
+
+extern void c_macro_args_set_empty(c_macro_args* self, size_t arg)
+{
+        assert(arg == self->args.size);
+        c_macro_arg a = { self->tokens.size, self->tokens.size };
+        c_macro_arg_vec_push(&self->args, a);
+}
+
+extern void c_macro_args_get(const c_macro_args* self, size_t arg, c_token*** begin, c_token*** end)
+{
+        assert(arg < self->args.size);
+        c_macro_arg a = c_macro_arg_vec_get(&self->args, arg);
+        *begin = (c_token**)self->tokens.items + a.begin;
+        *end = (c_token**)self->tokens.items + a.end;
+}
+
 extern void c_macro_lexer_init(
         c_macro_lexer* self,
         c_context* context,
         c_macro* macro,
+        c_macro_args* args,
         tree_location loc)
 {
         self->context = context;
         self->macro = macro;
+        self->args = *args;
         self->loc = loc;
-        self->pos = NULL;
-        vec_init(&self->tokens);
+        self->cursor.pos = 0;
+        self->cursor.arg_pos = self->cursor.arg_end = NULL;
+}
+
+extern void c_macro_lexer_dispose(c_macro_lexer* self)
+{
+        c_macro_args_dispose(&self->args);
 }
 
 static c_token* _c_macro_lexer_concat(c_macro_lexer* self, c_token* l, c_token* r, tree_location loc)
@@ -46,116 +95,128 @@ static c_token* _c_macro_lexer_concat(c_macro_lexer* self, c_token* l, c_token*
         return result;
 }
 
-static c_token* c_macro_lexer_concat(c_macro_lexer* self, const struct vec* tokens, tree_location loc)
-{
-        size_t size = tokens->size;
-        assert(size >= 2);
-
-        c_token* concat = _c_macro_lexer_concat(self, tokens->items[0], tokens->items[1], loc);
-        if (!concat)
-                return NULL;
+// Stands for an empty argument which is an operand of '##'. Pasting it with
+// a token gives the token, and it is removed from the expansion afterwards.
+static const char c_placemarker = 0;
+#define C_PLACEMARKER ((c_token*)&c_placemarker)
 
-        for (size_t i = 2; i < size; i++)
-                if (!(concat = _c_macro_lexer_concat(self, concat, vec_get(tokens, i), loc)))
-                        return NULL;
-
-        return concat;
+static bool c_macro_token_is_hash2(const c_macro* macro, size_t i)
+{
+        return i < c_macro_get_tokens_size(macro)
+                && c_macro_get_token_param(macro, i) == C_MACRO_NO_PARAM
+                && c_token_is(c_macro_get_token(macro, i), CTK_HASH2);
 }
 
-static inline c_token* c_macro_lexer_stringify_macro_arg(
-        c_macro_lexer* self, c_macro_args* args, c_token** arg, tree_location hash_loc)
+// moves the cursor to the next token of the expansion and returns it, or NULL at the end.
+// If the token is '#' which stringifies an argument, *stringified is set to the index of its parameter.
+static c_token* c_macro_lexer_next(
+        const c_macro_lexer* self, c_macro_cursor* cursor, unsigned* stringified)
 {
-        struct vec* tokens;
-        if (arg == c_macro_get_tokens_end(self->macro) 
-                || !c_token_is(*arg, CTK_ID) 
-                || !(tokens = c_macro_args_get(args, c_token_get_string(*arg))))
+        const c_macro* macro = self->macro;
+        *stringified = C_MACRO_NO_PARAM;
+        while (1)
         {
-                c_error_hash_is_not_followed_by_a_macro_param(self->context, hash_loc);
-                return NULL;
-        }
+                if (cursor->arg_pos != cursor->arg_end)
+                        return *cursor->arg_pos++;
+                if (cursor->pos == c_macro_get_tokens_size(macro))
+                        return NULL;
 
-        c_token** begin = (c_token**)vec_begin(tokens);
-        c_token** end = (c_token**)vec_end(tokens);
+                size_t i = cursor->pos++;
+                unsigned param = c_macro_get_token_param(macro, i);
+                if (param != C_MACRO_NO_PARAM)
+                {
+                        c_macro_args_get(&self->args, param, &cursor->arg_pos, &cursor->arg_end);
+                        if (cursor->arg_pos == cursor->arg_end
+                                && ((i && c_macro_token_is_hash2(macro, i - 1))
+                                        || c_macro_token_is_hash2(macro, i + 1)))
+                        {
+                                return C_PLACEMARKER;
+                        }
+                        continue;
+                }
 
-        c_token** from = begin;
-        while (from != end && c_token_is(*from, CTK_WSPACE))
-                from++;
+                c_token* t = c_macro_get_token(macro, i);
+                // '#' is followed by a parameter, this is checked when the macro is defined
+                if (macro->function_like && c_token_is(t, CTK_HASH))
+                        *stringified = c_macro_get_token_param(macro, cursor->pos++);
+                return t;
+        }
+}
 
-        c_token** to = end - 1;
-        while (to != begin - 1 && c_token_is(*to, CTK_WSPACE))
-                to--;
+static c_token* c_macro_lexer_stringify_macro_arg(c_macro_lexer* self, unsigned param)
+{
+        c_token** begin;
+        c_token** end;
+        c_macro_args_get(&self->args, param, &begin, &end);
 
         char string[C_MAX_LINE_LENGTH + 1];
         *string = '\0';
 
         int len = 0;
-        for (c_token** it = from; it <= to; it++)
+        for (c_token** it = begin; it != end; it++)
                 len += c_token_to_string(self->context->tree, *it, string + len, C_MAX_LINE_LENGTH - len);
 
         tree_id string_id = tree_get_id_for_string_s(self->context->tree, string, len + 1);
         return c_token_new_string(self->context, self->loc, string_id);
 }
 
-extern errcode c_macro_lexer_substitute_macro_args(c_macro_lexer* self, c_macro_args* args)
+// returns a new token which is the next token of the expansion, or NULL at the end
+static c_token* c_macro_lexer_read_token(c_macro_lexer* self)
 {
-        C_FOREACH_MACRO_TOKEN(self->macro, it, end)
-        {
-                struct vec* tokens;
-                c_token* t = *it;
-                if (c_token_is(t, CTK_WSPACE) || c_token_is(t, CTK_EOL))
-                        continue;
-                else if (c_token_is(t, CTK_ID)
-                        && (tokens = c_macro_args_get(args, c_token_get_string(t))))
-                {
-                        for (size_t i = 0; i < tokens->size; i++)
-                        {
-                                c_token* tok = vec_get(tokens, i);
-                                if (c_token_is(tok, CTK_WSPACE) || c_token_is(tok, CTK_EOL))
-                                        continue;
-                                vec_push(&self->tokens, c_token_copy_with_new_loc(self->context, tok, self->loc));
-                        }
-                        continue;
-                }
-                
-                if (c_token_is(t, CTK_HASH) && self->macro->function_like)
-                        if (!(t = c_macro_lexer_stringify_macro_arg(self, args, ++it, c_token_get_loc(t))))
-                                return EC_ERROR;
-
-                vec_push(&self->tokens, t);
-        }
+        unsigned stringified;
+        c_token* t = c_macro_lexer_next(self, &self->cursor, &stringified);
+        if (!t || t == C_PLACEMARKER)
+                return t;
+
+        return stringified != C_MACRO_NO_PARAM
+                ? c_macro_lexer_stringify_macro_arg(self, stringified)
+                : c_token_copy_with_new_loc(self->context, t, self->loc);
+}
 
-        self->pos = (c_token**)self->tokens.items;
-        return EC_NO_ERROR;
+static bool c_macro_lexer_next_is_hash2(const c_macro_lexer* self)
+{
+        c_macro_cursor cursor = self->cursor;
+        unsigned stringified;
+        c_token* t = c_macro_lexer_next(self, &cursor, &stringified);
+        return t && t != C_PLACEMARKER && c_token_is(t, CTK_HASH2);
 }
 
 extern c_token* c_macro_lexer_lex_token(c_macro_lexer* self)
 {
-        c_token** end = (c_token**)vec_end(&self->tokens);
-        if (self->pos == end)
-                return c_token_new_end_of_macro(self->context, self->loc, self->macro->name);
-
-        if (end - self->pos > 1 && c_token_is(*(self->pos + 1), CTK_HASH2))
+        c_token* t;
+        do
         {
-                struct vec tokens_to_concat;
-                vec_init(&tokens_to_concat);
-                vec_push(&tokens_to_concat, *self->pos);
-                self->pos++;
+                t = c_macro_lexer_read_token(self);
+                if (!t)
+                        return c_token_new_end_of_macro(self->context, self->loc, self->macro->name);
 
-                while (self->pos != end && c_token_is(*self->pos, CTK_HASH2))
+                while (c_macro_lexer_next_is_hash2(self))
                 {
-                        while (c_token_is(*self->pos, CTK_HASH2))
-                                self->pos++;
-                        vec_push(&tokens_to_concat, *self->pos);
-                        self->pos++;
-                }
+                        while (c_macro_lexer_next_is_hash2(self))
+                        {
+                                unsigned stringified;
+                                c_macro_lexer_next(self, &self->cursor, &stringified);
+                        }
 
-                c_token* concat = c_macro_lexer_concat(self, &tokens_to_concat, self->loc);
-                vec_drop(&tokens_to_concat);
-                if (!concat)
-                        return false;
+                        c_token* r = c_macro_lexer_read_token(self);
+                        if (!r)
+                                break;
+                        if (r == C_PLACEMARKER)
+                                continue;
+                        if (t == C_PLACEMARKER)
+                        {
+                                t = r;
+                                continue;
+                        }
 
-                return concat;
-        }
+                        c_token* concat = _c_macro_lexer_concat(self, t, r, self->loc);
+                        c_token_delete(self->context, t);
+                        c_token_delete(self->context, r);
+                        if (!concat)
+                                return NULL;
+                        t = concat;
+                }
+        } while (t == C_PLACEMARKER);
 
-        return c_token_copy_with_new_loc(self->context, *self->pos++, self->loc);
+        return t;
 }
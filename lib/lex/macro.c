@@ -1,6 +1,6 @@
 #include "macro.h"
 #include "scc/c-common/context.h"
-#include "scc/core/hashmap.h"
+#include "scc/lex/token.h"
 
 #define VEC u32vec
 #define VEC_T unsigned
@@ -16,6 +16,7 @@ extern c_macro* c_macro_new(c_context* context,
         m->loc = loc;
         m->name = name;
         m->params = u32vec_new();
+        m->token_params = u32vec_new();
         vec_init(&m->tokens);
         return m;
 }
@@ -33,7 +34,20 @@ extern void c_macro_add_param(c_macro* self, c_context* context, tree_id param)
 
 extern void c_macro_add_token(c_macro* self, c_context* context, c_token* token)
 {
+        unsigned param = C_MACRO_NO_PARAM;
+        if (self->function_like && c_token_is(token, CTK_ID))
+        {
+                tree_id id = c_token_get_string(token);
+                for (unsigned i = 0; i < self->params->size; i++)
+                        if (u32vec_get(self->params, i) == id)
+                        {
+                                param = i;
+                                break;
+                        }
+        }
+
         vec_push(&self->tokens, token);
+        u32vec_push(self->token_params, param);
 }
 
 extern c_token* c_macro_get_token(const c_macro* self, size_t i)
@@ -41,6 +55,11 @@ extern c_token* c_macro_get_token(const c_macro* self, size_t i)
         return c_macro_get_tokens_begin(self)[i];
 }
 
+extern unsigned c_macro_get_token_param(const c_macro* self, size_t i)
+{
+        return u32vec_get(self->token_params, i);
+}
+
 extern c_token** c_macro_get_tokens_begin(const c_macro* self)
 {
         return (c_token**)self->tokens.items;
@@ -75,48 +94,3 @@ extern size_t c_macro_get_params_size(const c_macro* self)
 {
         return self->params->size;
 }
-
-extern void c_macro_args_init(c_macro_args* self, c_context* context)
-{
-        self->context = context;
-        hashmap_init(&self->args);
-}
-
-extern void c_macro_args_dispose(c_macro_args* self)
-{
-        for (struct hashmap_iter it = hashmap_begin(&self->args);
-                it.pos != it.end; hashmap_next(&it))
-        {
-                vec_del(it.pos->value);
-        }
-        hashmap_drop(&self->args);
-}
-
-extern void c_macro_args_add(c_macro_args* self, tree_id arg, c_token* token)
-{
-        struct vec* tokens;
-        struct hashmap_entry* entry = hashmap_lookup(&self->args, arg);
-        if (!entry)
-        {
-                tokens = vec_new();
-                hashmap_update(&self->args, arg, tokens);
-        }
-        else
-                tokens = entry->value;
-
-        vec_push(tokens, token);
-}
-
-extern void c_macro_args_set_empty(c_macro_args* self, tree_id arg)
-{
-        struct hashmap_entry* entry = hashmap_lookup(&self->args, arg);
-        assert(!entry);
-        struct vec* tokens = vec_new();
-        hashmap_update(&self->args, arg, tokens);
-}
-
-extern struct vec* c_macro_args_get(c_macro_args* self, tree_id arg)
-{
-        struct hashmap_entry* entry = hashmap_lookup(&self->args, arg);
-        return entry ? entry->value : NULL;
-}
@@ -7,12 +7,18 @@
 typedef struct _c_context c_context;
 typedef struct _c_token c_token;
 
+// the body token is not a parameter
+#define C_MACRO_NO_PARAM ((unsigned)-1)
+
 typedef struct _c_macro
 {
         bool builtin;
         bool function_like;
         bool used;
         struct vec tokens;
+        // for every token of the body, the index of the parameter it names or C_MACRO_NO_PARAM,
+        // resolved when the token is added so that expansion doesn't look parameters up
+        struct u32vec* token_params;
         struct u32vec* params;
         tree_location loc;
         tree_id name;
@@ -24,6 +30,7 @@ extern void c_macro_delete(c_context* context, c_macro* macro);
 extern void c_macro_add_param(c_macro* self, c_context* context, tree_id param);
 extern void c_macro_add_token(c_macro* self, c_context* context, c_token* token);
 extern c_token* c_macro_get_token(const c_macro* self, size_t i);
+extern unsigned c_macro_get_token_param(const c_macro* self, size_t i);
 extern c_token** c_macro_get_tokens_begin(const c_macro* self);
 extern c_token** c_macro_get_tokens_end(const c_macro* self);
 extern size_t c_macro_get_tokens_size(const c_macro* self);
@@ -42,16 +49,4 @@ extern size_t c_macro_get_params_size(const c_macro* self);
                 **ENDNAME = c_macro_get_tokens_begin(PMACRO) - 1; \
                 ITNAME != ENDNAME; ITNAME--)
 
-typedef struct _c_macro_args
-{
-        struct hashmap args;
-        c_context* context;
-} c_macro_args;
-
-extern void c_macro_args_init(c_macro_args* self, c_context* context);
-extern void c_macro_args_dispose(c_macro_args* self);
-extern void c_macro_args_add(c_macro_args* self, tree_id arg, c_token* token);
-extern void c_macro_args_set_empty(c_macro_args* self, tree_id arg);
-extern struct vec* c_macro_args_get(c_macro_args* self, tree_id arg);
-
 #endif
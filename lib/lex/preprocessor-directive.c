@@ -1,5 +1,7 @@
 #include "preprocessor-directive.h"
 #include "scc/c-common/context.h"
+#include "scc/c-common/source.h"
+#include "scc/core/hashmap.h"
 #include "scc/core/num.h"
 #include "scc/lex/preprocessor.h"
 #include "scc/lex/token.h"
@@ -47,14 +49,46 @@ static bool _c_preprocessor_handle_directive(c_preprocessor* self, c_token* tok)
         }
 }
 
+static void c_preprocessor_update_include_guard(c_preprocessor* self, c_token_kind directive)
+{
+        c_include_guard* guard = &self->lexer->guard;
+        size_t depth = c_cond_stack_depth(self->lexer);
+        if (guard->state == CIGS_NONE || directive == CTK_EOD)
+                return;
+
+        if (depth == 0)
+        {
+                guard->state = directive == CTK_PP_IFNDEF && guard->state == CIGS_START
+                        ? CIGS_INSIDE : CIGS_NONE;
+        }
+        else if (depth == 1 && guard->state == CIGS_INSIDE)
+        {
+                if (directive == CTK_PP_ENDIF)
+                        guard->state = CIGS_AFTER;
+                else if (directive == CTK_PP_ELIF || directive == CTK_PP_ELSE)
+                        guard->state = CIGS_NONE;
+        }
+}
+
 extern bool c_preprocessor_handle_directive(c_preprocessor* self, c_token* tok)
 {
         size_t current_depth = c_lexer_stack_depth(&self->lexer_stack) - 1;
+        c_token_kind k = c_token_get_kind(tok);
         assert(self->lexer->kind == CPLK_TOKEN);
+        c_preprocessor_update_include_guard(self, k);
         self->lexer->token_lexer.in_directive = true;
         bool result = _c_preprocessor_handle_directive(self, tok);
         c_lexer_stack_get(
                 &self->lexer_stack, current_depth)->token_lexer.in_directive = false;
+
+        // tokens of conditional directives are owned by the condition stack
+        // and are deleted by #elif, #else or #endif which can be handled already
+        if (result
+                && k != CTK_PP_IF && k != CTK_PP_IFDEF && k != CTK_PP_IFNDEF
+                && k != CTK_PP_ELIF && k != CTK_PP_ELSE)
+        {
+                c_token_delete(self->context, tok);
+        }
         return result;
 }
 
@@ -75,18 +109,24 @@ static bool c_preprocessor_skip_conditional_directive_body(c_preprocessor* self)
                         c_error_unterminated_directive(self->context, info->token);
                         return false;
                 }
-                if (!c_token_is(t, CTK_HASH))
+
+                // skipped tokens are not referenced by anything
+                bool is_hash = c_token_is(t, CTK_HASH);
+                c_token_delete(self->context, t);
+                if (!is_hash)
                         continue;
 
                 if (!(t = c_preprocess_non_wspace(self)))
                         continue;
-                if (!c_token_is(t, CTK_ID))
-                        continue;
 
-                c_token_kind directive = c_reswords_get_pp_resword_by_ref(
-                        self->reswords, c_token_get_string(t));
+                c_token_kind directive = c_token_is(t, CTK_ID)
+                        ? c_reswords_get_pp_resword_by_ref(self->reswords, c_token_get_string(t))
+                        : CTK_UNKNOWN;
                 if (directive == CTK_UNKNOWN)
+                {
+                        c_token_delete(self->context, t);
                         continue;
+                }
 
                 c_token_set_kind(t, directive);
                 switch (directive)
@@ -111,6 +151,7 @@ static bool c_preprocessor_skip_conditional_directive_body(c_preprocessor* self)
                                 break;
 
                 }
+                c_token_delete(self->context, t);
         }
 }
 
@@ -141,6 +182,7 @@ static bool c_preprocessor_require_end_of_directive(c_preprocessor* self, c_toke
                 return false;
         }
 
+        c_token_delete(self->context, t);
         return true;
 }
 
@@ -158,6 +200,7 @@ extern bool c_preprocessor_handle_if_directive(c_preprocessor* self, c_token* to
                 return false;
         }
 
+        c_token_delete(self->context, last);
         return c_preprocessor_finish_conditional_directive(self, !num_is_zero(&val));
 }
 
@@ -189,8 +232,10 @@ extern bool c_preprocessor_handle_ifdef_directive(c_preprocessor* self, c_token*
         if (!t || !c_preprocessor_require_end_of_directive(self, CTK_PP_IFDEF))
                 return false;
 
+        tree_id name = c_token_get_string(t);
+        c_token_delete(self->context, t);
         return c_preprocessor_finish_conditional_directive(self,
-                c_preprocessor_macro_defined(self, c_token_get_string(t)));
+                c_preprocessor_macro_defined(self, name));
 }
 
 extern bool c_preprocessor_handle_ifndef_directive(c_preprocessor* self, c_token* tok)
@@ -201,8 +246,15 @@ extern bool c_preprocessor_handle_ifndef_directive(c_preprocessor* self, c_token
         if (!t || !c_preprocessor_require_end_of_directive(self, CTK_PP_IFNDEF))
                 return false;
 
+        tree_id name = c_token_get_string(t);
+        c_token_delete(self->context, t);
+
+        c_include_guard* guard = &self->lexer->guard;
+        if (guard->state == CIGS_INSIDE && c_cond_stack_depth(self->lexer) == 1)
+                guard->macro = name;
+
         return c_preprocessor_finish_conditional_directive(self,
-                !c_preprocessor_macro_defined(self, c_token_get_string(t)));
+                !c_preprocessor_macro_defined(self, name));
 }
 
 static bool c_preprocessor_check_else_of_endif_directive(c_preprocessor* self, c_token* tok)
@@ -230,6 +282,7 @@ extern bool c_preprocessor_handle_elif_directive(c_preprocessor* self, c_token*
                 return false;
 
         c_cond_directive* info = c_get_cond_directive(self->lexer);
+        c_token_delete(self->context, info->token);
         info->token = tok;
 
         c_token* last;
@@ -241,6 +294,7 @@ extern bool c_preprocessor_handle_elif_directive(c_preprocessor* self, c_token*
                 c_error_extra_tokens_at_end_of_directive(self->context, CTK_PP_ELIF, c_token_get_loc(last));
                 return false;
         }
+        c_token_delete(self->context, last);
 
         return c_preprocessor_finish_conditional_directive(self, !info->condition && !num_is_zero(&val));
 }
@@ -251,6 +305,7 @@ extern bool c_preprocessor_handle_else_directive(c_preprocessor* self, c_token*
                 return false;
 
         c_cond_directive* info = c_get_cond_directive(self->lexer);
+        c_token_delete(self->context, info->token);
         info->token = tok;
 
         if (!c_preprocessor_require_end_of_directive(self, CTK_PP_ELSE))
@@ -263,6 +318,7 @@ extern bool c_preprocessor_handle_endif_directive(c_preprocessor* self, c_token*
 {
         if (!c_preprocessor_check_else_of_endif_directive(self, tok))
                 return false;
+        c_token_delete(self->context, c_get_cond_directive(self->lexer)->token);
         c_pop_cond_directive(self->lexer);
         return c_preprocessor_require_end_of_directive(self, CTK_PP_ENDIF);
 }
@@ -333,9 +389,19 @@ extern bool c_preprocessor_handle_include_directive(c_preprocessor* self)
         if (!source)
                 return false;
 
+        c_token_delete(self->context, t);
         if (!c_preprocessor_require_end_of_directive(self, CTK_PP_INCLUDE))
                 return false;
 
+        // skip sources that would produce no tokens when included again
+        if (source->once && hashmap_lookup(&self->entered_sources, c_source_get_loc_begin(source)))
+                return true;
+        if (source->guard_macro != TREE_INVALID_ID
+                && c_preprocessor_macro_defined(self, source->guard_macro))
+        {
+                return true;
+        }
+
         return EC_SUCCEEDED(c_preprocessor_enter_source(self, source));
 }
 
@@ -348,7 +414,10 @@ static bool c_preprocessor_read_macro_body(c_preprocessor* self, c_macro* macro)
                         return false;
 
                 if (c_token_is(t, CTK_EOD))
+                {
+                        c_token_delete(self->context, t);
                         break;
+                }
 
                 c_macro_add_token(macro, self->context, t);
         }
@@ -368,6 +437,19 @@ static bool c_preprocessor_read_macro_body(c_preprocessor* self, c_macro* macro)
                         return false;
                 }
 
+        if (macro->function_like)
+                for (size_t i = 0; i < size; i++)
+                {
+                        c_token* t = c_macro_get_token(macro, i);
+                        if (c_token_is(t, CTK_HASH)
+                                && (i + 1 == size || c_macro_get_token_param(macro, i + 1) == C_MACRO_NO_PARAM))
+                        {
+                                c_error_hash_is_not_followed_by_a_macro_param(
+                                        self->context, c_token_get_loc(t));
+                                return false;
+                        }
+                }
+
         return true;
 }
 
@@ -377,7 +459,10 @@ static bool c_preprocessor_read_macro_params(c_preprocessor* self, c_macro* macr
         if (!t)
                 return false;
         if (c_token_is(t, CTK_RBRACKET))
+        {
+                c_token_delete(self->context, t);
                 return true;
+        }
 
         for (; ; t = c_preprocess_non_wspace(self))
         {
@@ -390,11 +475,15 @@ static bool c_preprocessor_read_macro_params(c_preprocessor* self, c_macro* macr
                 }
 
                 c_macro_add_param(macro, self->context, c_token_get_string(t));
+                c_token_delete(self->context, t);
                 if (!(t = c_preprocess_non_wspace(self)))
                         return false;
 
                 if (c_token_is(t, CTK_RBRACKET))
+                {
+                        c_token_delete(self->context, t);
                         return true;
+                }
                 else if (c_token_is(t, CTK_EOD))
                 {
                         c_error_missing_closing_bracket_in_macro_parameter_list(
@@ -407,6 +496,7 @@ static bool c_preprocessor_read_macro_params(c_preprocessor* self, c_macro* macr
                                 self->context, c_token_get_loc(t));
                         return false;
                 }
+                c_token_delete(self->context, t);
         }
 }
 
@@ -418,6 +508,7 @@ extern bool c_preprocessor_handle_define_directive(c_preprocessor* self)
 
         c_macro* macro = c_macro_new(self->context, false, false,
                 c_token_get_loc(t), c_token_get_string(t));
+        c_token_delete(self->context, t);
         if (!(t = c_preprocess_non_comment(self)))
                 return false;
 
@@ -436,6 +527,7 @@ extern bool c_preprocessor_handle_define_directive(c_preprocessor* self)
                 return false;
         }
 
+        c_token_delete(self->context, t);
         if (has_body && !c_preprocessor_read_macro_body(self, macro))
                 return false;
 
@@ -465,11 +557,18 @@ extern bool c_preprocessor_handle_pragma_directive(c_preprocessor* self)
         if (!t)
                 return false;
 
+        if (c_token_is(t, CTK_ID) && c_token_get_string(t) == self->id.once)
+        {
+                c_token_delete(self->context, t);
+                self->lexer->token_lexer.source->once = true;
+                return c_preprocessor_require_end_of_directive(self, CTK_PP_PRAGMA);
+        }
         if (!c_token_is(t, CTK_ID) || c_token_get_string(t) != self->id.link)
         {
                 c_error_unknown_pragma(self->context, c_token_get_loc(t));
                 return false;
         }
+        c_token_delete(self->context, t);
         if (!(t = c_preprocess_non_macro(self)))
                 return false;
 
@@ -487,6 +586,7 @@ extern bool c_preprocessor_handle_pragma_directive(c_preprocessor* self)
                 return false;
         }
 
+        c_token_delete(self->context, t);
         return EC_SUCCEEDED(c_pragma_handlers_on_link(&self->pragma_handlers, lib));
 }
 
@@ -496,5 +596,6 @@ extern bool c_preprocessor_handle_undef_directive(c_preprocessor* self, c_token*
         if (!t || !c_preprocessor_require_end_of_directive(self, CTK_PP_UNDEF))
                 return false;
         c_preprocessor_undef(self, c_token_get_string(t));
+        c_token_delete(self->context, t);
         return true;
 }
@@ -14,22 +14,27 @@ extern void c_init_pp_token_lexer(c_pp_lexer* self, c_context* context)
         self->kind = CPLK_TOKEN;
         c_token_lexer_init(&self->token_lexer, context);
         c_cond_stack_init(&self->cond_stack);
+        self->guard.state = CIGS_START;
+        self->guard.macro = TREE_INVALID_ID;
 }
 
 extern void c_init_pp_macro_token_lexer(
         c_pp_lexer* self,
         c_context* context,
         c_macro* macro,
+        c_macro_args* args,
         tree_location loc)
 {
         self->kind = CPLK_MACRO;
-        c_macro_lexer_init(&self->macro_lexer, context, macro, loc);
+        c_macro_lexer_init(&self->macro_lexer, context, macro, args, loc);
 }
 
 extern void c_dispose_pp_lexer(c_pp_lexer* self)
 {
         if (self->kind == CPLK_TOKEN)
                 c_cond_stack_drop(&self->cond_stack);
+        else if (self->kind == CPLK_MACRO)
+                c_macro_lexer_dispose(&self->macro_lexer);
 }
 
 extern c_token* c_pp_lex(c_pp_lexer* self)
@@ -123,9 +128,10 @@ extern c_pp_lexer* c_push_macro_lexer(
         c_lexer_stack* self,
         c_context* context,
         c_macro* macro,
+        c_macro_args* args,
         tree_location loc)
 {
         c_pp_lexer l;
-        c_init_pp_macro_token_lexer(&l, context, macro, loc);
+        c_init_pp_macro_token_lexer(&l, context, macro, args, loc);
         return push_lexer(self, l);
 }
@@ -13,6 +13,7 @@
 #include "preprocessor-directive.h"
 #include "macro.h"
 #include "errors.h"
+#include <stdlib.h>
 #include <time.h>
 
 static c_macro* _c_preprocessor_init_builtin_macro(
@@ -42,11 +43,15 @@ static void c_preprocessor_set_file(c_preprocessor* self, const c_source* source
         c_token_set_string(t, tree_get_id_for_string(self->context->tree, file));
 }
 
+// sets __LINE__ to the line of the source being read, the line is looked up
+// only when __LINE__ is expanded
 static void c_preprocessor_update_line(c_preprocessor* self)
 {
         c_pp_lexer* lexer = c_lexer_stack_get(&self->lexer_stack, self->token_lexer_depth);
+        const c_token_lexer* token_lexer = &lexer->token_lexer;
         char num[100];
-        snprintf(num, ARRAY_SIZE(num), "%d", lexer->token_lexer.line);
+        snprintf(num, ARRAY_SIZE(num), "%d",
+                c_source_get_line(token_lexer->source, token_lexer->loc));
         c_token* t = c_macro_get_token(self->builtin_macro.line, 0);
         c_token_set_string(t, tree_get_id_for_string(self->context->tree, num));
 }
@@ -88,18 +93,21 @@ static void c_preprocessor_init_builtin_macro(c_preprocessor* self)
 }
 
 extern void c_preprocessor_init(
-        c_preprocessor* self, const c_reswords* reswords, c_context* context)
+        c_preprocessor* self, c_reswords* reswords, c_context* context)
 {
         self->lexer = NULL;
         self->token_lexer_depth = -1;
         c_init_lexer_stack(&self->lexer_stack, context);
         self->lookahead.next_unexpanded_token = NULL;
         self->lookahead.next_expanded_token = NULL;
+        self->preprocessed = false;
         hashmap_init(&self->macro_lookup);
+        hashmap_init(&self->entered_sources);
         self->reswords = reswords;
         self->context = context;
         self->id.defined = tree_get_id_for_string(self->context->tree, "defined");
         self->id.link = tree_get_id_for_string(self->context->tree, "link");
+        self->id.once = tree_get_id_for_string(self->context->tree, "once");
         c_preprocessor_init_builtin_macro(self);
         c_pragma_handlers_init(&self->pragma_handlers, 0);
 }
@@ -110,12 +118,14 @@ extern void c_preprocessor_dispose(c_preprocessor* self)
                 c_preprocessor_exit(self);
         c_dispose_lexer_stack(&self->lexer_stack);
         hashmap_drop(&self->macro_lookup);
+        hashmap_drop(&self->entered_sources);
 }
 
 extern errcode c_preprocessor_enter_source(c_preprocessor* self, c_source* source)
 {
         assert(source);
 
+        hashmap_insert(&self->entered_sources, c_source_get_loc_begin(source), source);
         self->lexer = c_push_token_lexer(
                 &self->lexer_stack, self->context);
         c_preprocessor_set_file(self, source);
@@ -124,12 +134,12 @@ extern errcode c_preprocessor_enter_source(c_preprocessor* self, c_source* sourc
 }
 
 static void c_preprocessor_enter_macro(
-        c_preprocessor* self, c_macro* macro, tree_location loc)
+        c_preprocessor* self, c_macro* macro, c_macro_args* args, tree_location loc)
 {
         assert(macro);
         macro->used = true;
         self->lexer = c_push_macro_lexer(
-                &self->lexer_stack, self->context, macro, loc);
+                &self->lexer_stack, self->context, macro, args, loc);
 }
 
 extern void c_preprocessor_exit(c_preprocessor* self)
@@ -190,14 +200,14 @@ extern c_token* c_preprocess_non_comment(c_preprocessor* self)
                         return NULL;
 
                 if (c_token_is(t, CTK_COMMENT))
-                        return c_token_new_wspace(self->context, c_token_get_loc(t), 1);
+                {
+                        tree_location loc = c_token_get_loc(t);
+                        c_token_delete(self->context, t);
+                        return c_token_new_wspace(self->context, loc, 1);
+                }
 
                 if (!c_token_is(t, CTK_EOF))
-                {
-                        if (c_token_is(t, CTK_EOL) || c_token_is(t, CTK_EOD))
-                                c_preprocessor_update_line(self);
                         return t;
-                }
 
                 if (c_cond_stack_depth(self->lexer))
                 {
@@ -205,8 +215,13 @@ extern c_token* c_preprocess_non_comment(c_preprocessor* self)
                                 c_get_cond_directive(self->lexer)->token);
                         return NULL;
                 }
+
+                c_include_guard* guard = &self->lexer->guard;
+                self->lexer->token_lexer.source->guard_macro = guard->state == CIGS_AFTER
+                        ? guard->macro : TREE_INVALID_ID;
                 if (c_lexer_stack_depth(&self->lexer_stack) > 1)
                 {
+                        c_token_delete(self->context, t);
                         c_preprocessor_exit(self);
                         continue; // consume eof of included file
                 }
@@ -224,19 +239,70 @@ extern c_token* c_preprocess_non_wspace(c_preprocessor* self)
                         return NULL;
 
                 if (c_token_is(t, CTK_WSPACE) || c_token_is(t, CTK_EOL))
+                {
+                        c_token_delete(self->context, t);
                         continue;
+                }
 
                 return t;
         }
 }
 
+// reads the rest of a line marker: # <line> ["<file>" [<flag>...]]
+static bool c_preprocessor_read_line_marker(c_preprocessor* self, c_token* line)
+{
+        c_token_lexer* lexer = &self->lexer->token_lexer;
+        const char* num = tree_get_id_string(self->context->tree, c_token_get_string(line));
+        int n = atoi(num);
+        c_token_delete(self->context, line);
+
+        // a marker without a file keeps the file of the previous one
+        const struct c_line_marker_vec* markers = &lexer->source->line_markers;
+        const char* file = markers->size
+                ? c_line_marker_vec_last(markers).file : c_source_get_file(lexer->source)->path;
+
+        c_token* t = c_preprocess_non_wspace(self);
+        if (t && c_token_is(t, CTK_CONST_STRING))
+        {
+                const char* string = tree_get_id_string(self->context->tree, c_token_get_string(t));
+                char escaped[MAX_PATH_LEN + 1];
+                c_get_escaped_string(escaped, ARRAY_SIZE(escaped), string, strlen(string) + 1);
+                file = tree_get_id_string(self->context->tree,
+                        tree_get_id_for_string(self->context->tree, escaped));
+        }
+
+        // flags are ignored
+        while (t && !c_token_is(t, CTK_EOD))
+        {
+                c_token_delete(self->context, t);
+                t = c_preprocess_non_wspace(self);
+        }
+        if (!t)
+                return false;
+
+        c_token_delete(self->context, t);
+        lexer->in_directive = false;
+        c_source_add_line_marker(lexer->source, lexer->loc, n, file);
+        return true;
+}
+
 extern c_token* c_preprocess_non_directive(c_preprocessor* self)
 {
         while (1)
         {
                 c_token* t = c_preprocess_non_wspace(self);
-                if (!t || !c_token_is(t, CTK_HASH))
+                if (!t)
+                        return NULL;
+                if (!c_token_is(t, CTK_HASH))
+                {
+                        // a token outside of conditionals means the source is not guarded
+                        if (self->lexer->kind == CPLK_TOKEN
+                                && !c_cond_stack_depth(self->lexer) && !c_token_is(t, CTK_EOF))
+                        {
+                                self->lexer->guard.state = CIGS_NONE;
+                        }
                         return t;
+                }
 
                 // this happens when we get '#' from macro e.g:
                 //      #define A #
@@ -247,10 +313,17 @@ extern c_token* c_preprocess_non_directive(c_preprocessor* self)
                         return NULL;
                 }
 
+                c_token_delete(self->context, t);
                 self->lexer->token_lexer.in_directive = true;
                 if (!(t = c_preprocess_non_wspace(self)))
                         return NULL;
  
+                if (c_token_is(t, CTK_PP_NUM))
+                {
+                        if (!c_preprocessor_read_line_marker(self, t))
+                                return NULL;
+                        continue;
+                }
                 if (c_token_is(t, CTK_ID))
                 {
                         c_token_kind directive = c_reswords_get_pp_resword_by_ref(
@@ -308,8 +381,7 @@ static bool c_preprocessor_add_macro_arg(c_preprocessor* self, c_preprocessing_a
         if (!c_preprocessor_check_macro_args_overflow(self, pp_args))
                 return false;
 
-        tree_id arg_name = c_macro_get_param(pp_args->macro, pp_args->num_args - 1);
-        c_macro_args_add(pp_args->args, arg_name, arg);
+        c_macro_args_add(pp_args->args, pp_args->num_args - 1, arg);
         return true;
 }
 
@@ -319,8 +391,7 @@ static bool c_preprocessor_append_empty_macro_arg(c_preprocessor* self, c_prepro
         if (!c_preprocessor_check_macro_args_overflow(self, pp_args))
                 return false;
 
-        tree_id arg_name = c_macro_get_param(pp_args->macro, pp_args->num_args - 1);
-        c_macro_args_set_empty(pp_args->args, arg_name);
+        c_macro_args_set_empty(pp_args->args, pp_args->num_args - 1);
         return true;
 }
 
@@ -356,6 +427,7 @@ static bool c_preprocessor_read_macro_args(
                         bracket_nesting--;
                         if (bracket_nesting == 0)
                         {
+                                c_token_delete(self->context, t);
                                 if (empty_arg && pp_args.num_params && !c_preprocessor_append_empty_macro_arg(self, &pp_args))
                                         return false;
                                 return c_preprocessor_check_macro_args_underflow(self, &pp_args);
@@ -363,6 +435,7 @@ static bool c_preprocessor_read_macro_args(
                 }
                 else if (c_token_is(t, CTK_COMMA) && bracket_nesting == 1)
                 {
+                        c_token_delete(self->context, t);
                         if (empty_arg && !c_preprocessor_append_empty_macro_arg(self, &pp_args))
                                 return false;
                         empty_arg = true;
@@ -377,8 +450,58 @@ static bool c_preprocessor_read_macro_args(
         }
 }
 
+// Tokens of a preprocessed source are read straight from its token lexer,
+// since it has no macros to expand and its only directives are line markers.
+// Any other directive is handled as usual and turns the preprocessing back on
+// for the rest of the source.
+static c_token* c_preprocess_preprocessed(c_preprocessor* self)
+{
+        c_token_lexer* lexer = &self->lexer->token_lexer;
+        while (1)
+        {
+                c_token* t = c_token_lexer_lex_token(lexer);
+                if (!t)
+                        return NULL;
+
+                c_token_kind k = c_token_get_kind(t);
+                if (k == CTK_WSPACE || k == CTK_COMMENT || k == CTK_EOL)
+                {
+                        c_token_delete(self->context, t);
+                        continue;
+                }
+                if (k != CTK_HASH)
+                        return t;
+
+                c_token_delete(self->context, t);
+                lexer->in_directive = true;
+                if (!(t = c_preprocess_non_wspace(self)))
+                        return NULL;
+
+                if (c_token_is(t, CTK_PP_NUM))
+                {
+                        if (!c_preprocessor_read_line_marker(self, t))
+                                return NULL;
+                        continue;
+                }
+
+                self->preprocessed = false;
+                if (c_token_is(t, CTK_ID))
+                {
+                        c_token_kind directive = c_reswords_get_pp_resword_by_ref(
+                                self->reswords, c_token_get_string(t));
+                        c_token_set_kind(t, directive);
+                }
+                if (!c_preprocessor_handle_directive(self, t))
+                        return NULL;
+                return c_preprocess_non_macro(self);
+        }
+}
+
 extern c_token* c_preprocess_non_macro(c_preprocessor* self)
 {
+        if (self->preprocessed)
+                return c_preprocess_preprocessed(self);
+
         while (1)
         {
                 c_token* t;
@@ -389,6 +512,7 @@ extern c_token* c_preprocess_non_macro(c_preprocessor* self)
 
                 if (c_token_is(t, CTK_EOM))
                 {
+                        c_token_delete(self->context, t);
                         c_preprocessor_exit(self);
                         continue;
                 }
@@ -415,19 +539,18 @@ extern c_token* c_preprocess_non_macro(c_preprocessor* self)
                                 self->lookahead.next_unexpanded_token = next;
                                 return t;
                         }
+                        c_token_delete(self->context, next);
                         if (!c_preprocessor_read_macro_args(self, macro, &args, loc))
                         {
                                 c_macro_args_dispose(&args);
                                 return NULL;
                         }
                 }
+                c_token_delete(self->context, t);
 
-                c_preprocessor_enter_macro(self, macro, loc);
-                bool failed = EC_FAILED(c_macro_lexer_substitute_macro_args(
-                        &self->lexer->macro_lexer, &args));
-                c_macro_args_dispose(&args);
-                if (failed)
-                        return NULL;
+                if (macro == self->builtin_macro.line)
+                        c_preprocessor_update_line(self);
+                c_preprocessor_enter_macro(self, macro, &args, loc);
         }
 }
 
@@ -474,6 +597,8 @@ static c_token* c_preprocessor_concat_and_escape_strings(c_preprocessor* self, s
                 (char*)i8vec_begin(&concat), concat.size);
         tree_location loc = c_token_get_loc(vec_get(strings, 0));
         i8vec_drop(&concat);
+        for (size_t i = 0; i < strings->size; i++)
+                c_token_delete(self->context, vec_get(strings, i));
 
         return c_token_new_string(self->context, loc, concat_ref);
 }
@@ -1,48 +1,111 @@
 #include "scc/lex/reswords.h"
 #include "scc/c-common/context.h"
-#include "scc/core/hash.h"
-#include "scc/lex/token-kind.h"
+#include "scc/tree/context.h"
+#include "scc/lex/reswords-info.h"
+#include "scc/lex/misc.h"
+#include "scc/lex/charset.h"
+#include <string.h>
 
-extern void c_reswords_init(c_reswords* self, c_context* context)
+static_assert(CTK_TOTAL_SIZE == 116, "reswords initialization needs an update");
+
+// has no collisions for the strings of _c_resword_infos in a table of 128 entries
+static inline unsigned c_resword_hash(const char* s, size_t size)
 {
-        hashmap_init(&self->reswords);
-        hashmap_init(&self->pp_reswords);
+        unsigned h = (unsigned char)s[0]
+                + 29 * (unsigned char)s[1]
+                + 11 * (unsigned char)s[size - 1]
+                + 5 * (unsigned)size;
+        return h & (C_RESWORDS_TABLE_SIZE - 1);
 }
 
-extern void c_reswords_dispose(c_reswords* self)
+// returns the index of the entry of the string, or the index of a free entry
+static unsigned c_reswords_find(const c_reswords* self, const char* s, size_t size)
 {
-        hashmap_drop(&self->reswords);
-        hashmap_drop(&self->pp_reswords);
+        unsigned i = c_resword_hash(s, size);
+        // probing is only needed if a new resword collides with an existing one
+        while (self->table[i].string
+                && (self->table[i].size != size || memcmp(self->table[i].string, s, size) != 0))
+        {
+                i = (i + 1) & (C_RESWORDS_TABLE_SIZE - 1);
+        }
+        return i;
 }
 
-extern void c_reswords_add_resword(c_reswords* self, const char* string, int kind)
+static void c_reswords_add(c_reswords* self, c_token_kind k, bool pp)
 {
-        hashmap_insert(&self->reswords, strhash(string), (void*)(size_t)kind);
+        const char* s = c_get_token_kind_info(k)->string;
+        // punctuators can't be identifiers
+        if (!c_char_is_letter((unsigned char)s[0]))
+                return;
+
+        size_t size = strlen(s);
+        c_resword* r = self->table + c_reswords_find(self, s, size);
+        r->string = s;
+        r->size = (uint8_t)size;
+        if (pp)
+                r->pp_kind = (uint8_t)k;
+        else
+                r->kind = (uint8_t)k;
 }
 
-extern void c_reswords_add_pp_resword(c_reswords* self, const char* string, int kind)
+extern void c_reswords_init(c_reswords* self, c_context* context)
 {
-        hashmap_insert(&self->pp_reswords, strhash(string), (void *)(size_t)kind);
+        self->context = context;
+        memset(self->table, 0, sizeof(self->table));
+        c_resword_cache_init(&self->cache);
+
+        for (c_token_kind i = CTK_CHAR; i < CTK_CONST_INT; i++)
+                c_reswords_add(self, i, false);
+        for (c_token_kind i = CTK_PP_IF; i <= CTK_PP_PRAGMA; i++)
+                c_reswords_add(self, i, true);
+
+        if (context->lang_opts.ext.tm_enabled)
+                for (c_token_kind i = CTK_ATOMIC; i < CTK_TOTAL_SIZE; i++)
+                        c_reswords_add(self, i, false);
 }
 
-extern int c_reswords_get_resword(const c_reswords* self, const char* string, size_t len)
+extern void c_reswords_dispose(c_reswords* self)
 {
-        return c_reswords_get_resword_by_ref(self, hash(string, len));
+        c_resword_cache_drop(&self->cache);
 }
 
-extern int c_reswords_get_resword_by_ref(const c_reswords* self, unsigned ref)
+static const c_resword* c_reswords_classify(c_reswords* self, unsigned ref)
 {
-        struct hashmap_entry* entry = hashmap_lookup(&self->reswords, ref);
-        return entry ? (int)(size_t)entry->value : CTK_UNKNOWN;
+        struct c_resword_cache* cache = &self->cache;
+        if (ref >= cache->size)
+        {
+                size_t old_size = cache->size;
+                size_t new_size = old_size ? old_size : 1024;
+                while (new_size <= ref)
+                        new_size *= 2;
+                c_resword_cache_resize(cache, new_size);
+                memset(cache->items + old_size, 0, new_size - old_size);
+        }
+
+        uint8_t entry = cache->items[ref];
+        if (!entry)
+        {
+                unsigned i = C_RESWORDS_TABLE_SIZE;
+                struct strentry* s = tree_get_id_strentry(self->context->tree, ref);
+                // the size of the entry includes the terminating zero
+                if (s && s->size > 1)
+                {
+                        i = c_reswords_find(self, s->data, s->size - 1);
+                        if (!self->table[i].string)
+                                i = C_RESWORDS_TABLE_SIZE;
+                }
+                entry = (uint8_t)(i + 1);
+                cache->items[ref] = entry;
+        }
+        return self->table + entry - 1;
 }
 
-extern int c_reswords_get_pp_resword(const c_reswords* self, const char* string, size_t len)
+extern int c_reswords_get_resword_by_ref(c_reswords* self, unsigned ref)
 {
-        return c_reswords_get_pp_resword_by_ref(self, hash(string, len));
+        return c_reswords_classify(self, ref)->kind;
 }
 
-extern int c_reswords_get_pp_resword_by_ref(const c_reswords* self, unsigned ref)
+extern int c_reswords_get_pp_resword_by_ref(c_reswords* self, unsigned ref)
 {
-        struct hashmap_entry* entry = hashmap_lookup(&self->pp_reswords, ref);
-        return entry ? (c_token_kind)(size_t)entry->value : CTK_UNKNOWN;
+        return c_reswords_classify(self, ref)->pp_kind;
 }
@@ -1,5 +1,4 @@
 #include "scc/lex/token-lexer.h"
-#include "scc/core/buf-io.h"
 #include "scc/core/file.h"
 #include "scc/lex/token-kind.h"
 #include "scc/c-common/source.h"
@@ -10,6 +9,7 @@
 #include "errors.h"
 #include <ctype.h> // toupper
 #include <stdio.h>
+#include <string.h>
 
 typedef struct
 {
@@ -36,6 +36,19 @@ static bool c_sequence_append(c_sequence* self, int c)
         return true;
 }
 
+static bool c_sequence_append_n(c_sequence* self, const char* s, size_t n)
+{
+        if (c_sequence_length(self) + n > C_MAX_LINE_LENGTH)
+        {
+                c_error_token_is_too_long(self->context, self->loc);
+                return false;
+        }
+        memcpy(self->pos, s, n);
+        self->pos += n;
+        *self->pos = '\0';
+        return true;
+}
+
 static void c_sequence_init(c_sequence* self, c_context* context, tree_location loc)
 {
         self->context = context;
@@ -46,12 +59,14 @@ static void c_sequence_init(c_sequence* self, c_context* context, tree_location
 
 static tree_id c_sequence_get_id(c_sequence* self)
 {
-        return tree_get_id_for_string(self->context->tree, self->buffer);
+        return tree_get_id_for_string_s(self->context->tree,
+                self->buffer, c_sequence_length(self) + 1);
 }
 
 extern void c_token_lexer_init(c_token_lexer* self, c_context* context)
 {
         self->c = self->nextc = -1;
+        self->input.pos = self->input.end = NULL;
 
         self->angle_string_expected = false;
         self->hash_expected = true;
@@ -62,21 +77,14 @@ extern void c_token_lexer_init(c_token_lexer* self, c_context* context)
         self->context = context;
 
         self->loc = TREE_INVALID_LOC;
-        self->line = -1;
         self->tab_to_space = 4;
 }
 
 static inline int readc(c_token_lexer* self)
 {
-        if (self->input.is_file)
-                return buf_read_char(&self->input.reader);
-        int c = *self->input.str;
-        if (c)
-        {
-                self->input.str++;
-                return c;
-        }
-        return -1;
+        return self->input.pos != self->input.end
+                ? (unsigned char)*self->input.pos++
+                : -1;
 }
 
 static inline void _c_token_lexer_readc(c_token_lexer* self)
@@ -106,42 +114,47 @@ static inline int c_token_lexer_readc(c_token_lexer* self)
                 _c_token_lexer_readc(self);
                 _c_token_lexer_readc(self);
         }
+        return self->c;
+}
 
-        if (self->c == '\n')
-        {
-                self->line++;
-                if (self->source)
-                        c_source_save_line_loc(self->source, self->loc + 1);
-        }
+// Bulk scanning: self->nextc is the last character read from the input, so
+// the text starting at it is contiguous. A run of characters which contains
+// no new-lines, '\r' or backslashes can be skipped at once, since reading it
+// one by one would only advance the location.
 
-        return self->c;
+// returns the contiguous input starting at self->nextc, or NULL at the end of input
+static inline const char* c_token_lexer_get_run(const c_token_lexer* self)
+{
+        return self->nextc != -1 ? self->input.pos - 1 : NULL;
+}
+
+// advances to the character preceding stop so that *stop becomes self->nextc
+static inline void c_token_lexer_skip_run(c_token_lexer* self, const char* run, const char* stop)
+{
+        if (stop == run)
+                return;
+
+        self->loc += (tree_location)(stop - run);
+        self->c = (unsigned char)stop[-1];
+        self->input.pos = stop;
+        self->nextc = readc(self);
 }
 
 extern errcode c_token_lexer_enter(c_token_lexer* self, c_source* source)
 {
         if (!source)
                 return EC_ERROR;
-        file_entry* fe = c_source_get_file(source);
-        if (!fe->is_virtual)
-        {
-                self->input.is_file = 1;
-                FILE* f = fopen(fe->path, "r");
-                if (!f)
-                {
-                        c_error_cannot_open_source_file(self->context, 0, c_source_get_name(source));
-                        return EC_ERROR;
-                }
-                init_buf_reader(&self->input.reader, f);
-        }
-        else
+        size_t size;
+        const char* content = file_map(c_source_get_file(source), &size);
+        if (!content)
         {
-                self->input.is_file = 0;
-                self->input.str = fe->virtual_content;
+                c_error_cannot_open_source_file(self->context, 0, c_source_get_name(source));
+                return EC_ERROR;
         }
+        self->input.pos = content;
+        self->input.end = content + size;
 
         tree_location start_loc = c_source_get_loc_begin(source);
-        // save first line location
-        c_source_save_line_loc(source, start_loc);
         self->source = source;
 
         c_token_lexer_readc(self);
@@ -150,25 +163,19 @@ extern errcode c_token_lexer_enter(c_token_lexer* self, c_source* source)
         self->loc = start_loc;
         self->hash_expected = true;
         self->in_directive = false;
-
-        c_location loc;
-        c_source_find_loc(&self->context->source_manager, &loc, start_loc);
-        self->line = loc.line;
-
         return EC_NO_ERROR;
 }
 
 extern void c_token_lexer_enter_str(c_token_lexer* self, const char* str, tree_location start_loc)
 {
-        self->input.is_file = 0;
-        self->input.str = str;
+        self->input.pos = str;
+        self->input.end = str + strlen(str);
         c_token_lexer_readc(self);
         c_token_lexer_readc(self);
         self->source = 0;
         self->loc = start_loc;
         self->hash_expected = true;
         self->in_directive = false;
-        self->line = 0;
 }
 
 extern bool c_token_lexer_at_eof(const c_token_lexer* self)
@@ -181,6 +188,15 @@ static c_token* c_token_lexer_lex_identifier(c_token_lexer* self, c_sequence* se
         c_sequence_append(seq, self->c);
         while (1)
         {
+                const char* run = c_token_lexer_get_run(self);
+                if (run)
+                {
+                        const char* stop = c_char_skip_identifier(run, self->input.end);
+                        if (!c_sequence_append_n(seq, run, (size_t)(stop - run)))
+                                return NULL;
+                        c_token_lexer_skip_run(self, run, stop);
+                }
+
                 int c = c_token_lexer_readc(self);
                 if (c_token_lexer_at_eof(self) || !(c_char_info_table[c] & (CCK_LETTER | CCK_DIGIT)))
                         break;
@@ -199,6 +215,14 @@ static c_token* c_token_lexer_lex_spaces(c_token_lexer* self)
         while (!c_token_lexer_at_eof(self) && c_char_is_space(c))
         {
                 spaces += c == '\t' ? self->tab_to_space : 1;
+                const char* run = c_token_lexer_get_run(self);
+                if (run)
+                {
+                        const char* stop = c_char_skip_spaces(run, self->input.end);
+                        for (const char* it = run; it != stop; it++)
+                                spaces += *it == '\t' ? self->tab_to_space : 1;
+                        c_token_lexer_skip_run(self, run, stop);
+                }
                 c = c_token_lexer_readc(self);
         }
         return c_token_new_wspace(self->context, loc, spaces);
@@ -303,12 +327,22 @@ static c_token* c_token_lexer_lex_comment(c_token_lexer* self, tree_location sta
         if (self->c == '/')
         {
                 while (!c_token_lexer_at_eof(self) && self->c != '\n')
+                {
+                        const char* run = c_token_lexer_get_run(self);
+                        if (run)
+                                c_token_lexer_skip_run(self, run,
+                                        c_char_skip_line_comment(run, self->input.end));
                         c_token_lexer_readc(self);
+                }
         }
         else if (self->c == '*')
         {
                 while (1)
                 {
+                        const char* run = c_token_lexer_get_run(self);
+                        if (run)
+                                c_token_lexer_skip_run(self, run,
+                                        c_char_skip_block_comment(run, self->input.end));
                         c_token_lexer_readc(self);
                         if (c_token_lexer_at_eof(self))
                         {
@@ -132,6 +132,8 @@ extern c_token* c_token_copy(c_context* context, c_token* token)
                 return c_token_new_wspace(context, loc, c_token_get_spaces(token));
         else if (k == CTK_PP_NUM)
                 return c_token_new_pp_num(context, loc, c_token_get_string(token));
+        else if (k == CTK_EOM)
+                return c_token_new_end_of_macro(context, loc, c_token_get_string(token));
 
         return c_token_new(context, k, loc);
 }
@@ -142,4 +144,38 @@ extern c_token* c_token_copy_with_new_loc(c_context* context, c_token* token, tr
         if (copy)
                 c_token_set_loc(copy, new_loc);
         return copy;
-}
\ No newline at end of file
+}
+
+// returns the size a token of the given kind was allocated with. Kinds can only
+// be changed to ones of lesser or equal size, so this never exceeds the allocation
+static size_t c_token_get_size(c_token_kind k)
+{
+        switch (k)
+        {
+                case CTK_ID:
+                case CTK_CONST_STRING:
+                case CTK_ANGLE_STRING:
+                case CTK_EOM:
+                        return sizeof(struct _c_string_token);
+                case CTK_PP_NUM:
+                        return sizeof(c_token);
+                case CTK_CONST_FLOAT:
+                        return sizeof(struct _c_float_token);
+                case CTK_CONST_DOUBLE:
+                        return sizeof(struct _c_double_token);
+                case CTK_CONST_INT:
+                        return sizeof(struct _c_int_token);
+                case CTK_CONST_CHAR:
+                        return sizeof(struct _c_char_token);
+                case CTK_WSPACE:
+                        return sizeof(struct _c_wspace_token);
+                default:
+                        return sizeof(struct _c_token_base);
+        }
+}
+
+extern void c_token_delete(c_context* context, c_token* token)
+{
+        if (token)
+                c_context_deallocate_node(context, token, c_token_get_size(c_token_get_kind(token)));
+}
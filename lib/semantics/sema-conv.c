@@ -20,7 +20,7 @@ extern tree_type* c_sema_lvalue_conversion(c_sema* self, tree_expr** e)
                 // the desugared expressions can be still lvalues,
                 // but we don't need them in value-checking
                 tree_set_expr_value_kind(tree_desugar_expr(*e), TVK_RVALUE);
-                t = tree_new_qualified_type(self->context, t, TTQ_UNQUALIFIED);
+                t = c_sema_get_qualified_type(self, t, TTQ_UNQUALIFIED);
                 *e = c_sema_new_impl_cast(self, *e, t);
                 tree_set_expr_value_kind(*e, TVK_RVALUE);
         }
@@ -33,7 +33,7 @@ extern tree_type* c_sema_array_to_pointer_conversion(c_sema* self, tree_expr** e
         if (tree_expr_is_lvalue(*e) && tree_type_is(t, TTK_ARRAY))
         {
                 tree_type* eltype = tree_get_array_eltype(t);
-                t = c_sema_new_pointer_type(self, TTQ_UNQUALIFIED, eltype);
+                t = c_sema_get_pointer_type(self, TTQ_UNQUALIFIED, eltype);
                 *e = c_sema_new_impl_cast(self, *e, t);
                 tree_set_expr_value_kind(*e, TVK_RVALUE);
         }
@@ -45,7 +45,7 @@ extern tree_type* c_sema_function_to_pointer_conversion(c_sema* self, tree_expr*
         tree_type* t = tree_desugar_type(tree_get_expr_type(*e));
         if (tree_type_is(t, TTK_FUNCTION))
         {
-                t = c_sema_new_pointer_type(self, TTQ_UNQUALIFIED, t);
+                t = c_sema_get_pointer_type(self, TTQ_UNQUALIFIED, t);
                 *e = c_sema_new_impl_cast(self, *e, t);
                 tree_set_expr_value_kind(*e, TVK_RVALUE);
         }
@@ -486,7 +486,7 @@ extern c_param* c_sema_finish_param(c_sema* self, c_param* p)
         if (tree_type_is(param_type, TTK_ARRAY) || tree_type_is(param_type, TTK_FUNCTION))
         {
                 // todo: [ qualifiers ]
-                tree_type* ptr = c_sema_new_pointer_type(self, TTQ_UNQUALIFIED,
+                tree_type* ptr = c_sema_get_pointer_type(self, TTQ_UNQUALIFIED,
                         tree_type_is(param_type, TTK_ARRAY) ? tree_get_array_eltype(param_type) : param_type);
                 p->declarator.type.head = tree_new_adjusted_type(self->context, ptr, original_type);
         }
@@ -435,7 +435,7 @@ static tree_type* c_sema_check_address_expr(c_sema* self, tree_expr** expr)
         if (!c_sema_require_lvalue_or_function_designator(self, *expr))
                 return NULL;
 
-        return c_sema_new_pointer_type(self, TTQ_UNQUALIFIED, tree_get_expr_type(*expr));
+        return c_sema_get_pointer_type(self, TTQ_UNQUALIFIED, tree_get_expr_type(*expr));
 }
 
 // 6.5.3.2 address and inderection operators
@@ -1035,8 +1035,8 @@ static tree_type* c_sema_check_conditional_operator_pointer_types(
         else
                 return NULL;
 
-        target = tree_new_qualified_type(self->context, target, quals);
-        tree_type* result = c_sema_new_pointer_type(self, TTQ_UNQUALIFIED, target);
+        target = c_sema_get_qualified_type(self, target, quals);
+        tree_type* result = c_sema_get_pointer_type(self, TTQ_UNQUALIFIED, target);
         *lhs = c_sema_new_impl_cast(self, *lhs, result);
         *rhs = c_sema_new_impl_cast(self, *rhs, result);
 
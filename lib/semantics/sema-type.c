@@ -9,12 +9,24 @@
 extern bool c_sema_types_are_compatible(
         const c_sema* self, const tree_type* a, const tree_type* b, bool unqualify)
 {
+        tree_type* ca = tree_get_canonical_type(self->context, a);
+        tree_type* cb = tree_get_canonical_type(self->context, b);
+        if (!ca || !cb)
+        {
+                if (unqualify)
+                {
+                        a = tree_get_modified_type_c(a);
+                        b = tree_get_modified_type_c(b);
+                }
+                return tree_compare_types(a, b) == TTEK_EQ;
+        }
+
         if (unqualify)
         {
-                a = tree_get_modified_type_c(a);
-                b = tree_get_modified_type_c(b);
+                ca = tree_get_modified_type(ca);
+                cb = tree_get_modified_type(cb);
         }
-        return tree_compare_types(a, b) == TTEK_EQ;
+        return ca == cb;
 }
 
 extern bool c_sema_require_complete_type(const c_sema* self, tree_location loc, const tree_type* type)
@@ -33,7 +45,7 @@ extern tree_type* c_sema_get_int_type(c_sema* self, bool signed_, bool extended)
                 ? extended ? TBTK_INT64 : TBTK_INT32
                 : extended ? TBTK_UINT64 : TBTK_UINT32;
 
-        return tree_new_builtin_type(self->context, k);
+        return tree_get_builtin_type(self->context, k);
 }
 
 extern tree_type* c_sema_get_size_t_type(c_sema* self)
@@ -43,22 +55,22 @@ extern tree_type* c_sema_get_size_t_type(c_sema* self)
 
 extern tree_type* c_sema_get_float_type(c_sema* self)
 {
-        return tree_new_builtin_type(self->context, TBTK_FLOAT);
+        return tree_get_builtin_type(self->context, TBTK_FLOAT);
 }
 
 extern tree_type* c_sema_get_double_type(c_sema* self)
 {
-        return tree_new_builtin_type(self->context, TBTK_DOUBLE);
+        return tree_get_builtin_type(self->context, TBTK_DOUBLE);
 }
 
 extern tree_type* c_sema_get_char_type(c_sema* self)
 {
-        return tree_new_builtin_type(self->context, TBTK_INT8);
+        return tree_get_builtin_type(self->context, TBTK_INT8);
 }
 
 extern tree_type* c_sema_get_logical_operation_type(c_sema* self)
 {
-        return tree_new_builtin_type(self->context, TBTK_INT32);
+        return tree_get_builtin_type(self->context, TBTK_INT32);
 }
 
 extern tree_type* c_sema_get_type_for_string_literal(c_sema* self, tree_id id)
@@ -78,7 +90,12 @@ extern tree_type* c_sema_get_builtin_type(
         if (k == TBTK_INVALID)
                 return NULL;
 
-        return tree_new_qualified_type(self->context, tree_new_builtin_type(self->context, k), q);
+        return c_sema_get_qualified_type(self, tree_get_builtin_type(self->context, k), q);
+}
+
+extern tree_type* c_sema_get_qualified_type(c_sema* self, tree_type* type, tree_type_quals q)
+{
+        return tree_get_qualified_type(self->context, type, q);
 }
 
 extern tree_type* c_sema_new_decl_type(c_sema* self, tree_decl* d, bool referenced)
@@ -109,6 +126,11 @@ extern tree_type* c_sema_new_pointer_type(c_sema* self, tree_type_quals quals, t
         return tree_new_qualified_type(self->context, tree_new_pointer_type(self->context, target), quals); 
 }
 
+extern tree_type* c_sema_get_pointer_type(c_sema* self, tree_type_quals quals, tree_type* target)
+{
+        return tree_get_qualified_type(self->context, tree_get_pointer_type(self->context, target), quals);
+}
+
 extern tree_type* c_sema_new_function_type(c_sema* self, tree_type* restype)
 {
         return tree_new_modified_type(self->context, tree_new_func_type(self->context, restype));
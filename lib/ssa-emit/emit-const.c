@@ -67,7 +67,7 @@ static ssa_const* emit_decl_addr(ssa_module_emitter* self, tree_decl* decl)
         ssa_value* global = ssa_get_global_decl(self, decl);
         if (!global && !ssa_emit_global_decl(self, decl))
                 return NULL;
-        tree_type* ptr = tree_new_pointer_type(self->context->tree, tree_get_decl_type(decl));
+        tree_type* ptr = tree_get_pointer_type(self->context->tree, tree_get_decl_type(decl));
         assert(ptr);
         return ssa_new_const_addr(self->context, 
                 ptr, ssa_get_global_decl(self, decl));
@@ -86,7 +86,7 @@ static ssa_const* emit_member_addr(ssa_module_emitter* self, const tree_expr* ex
                 return NULL;
 
         tree_decl* member = tree_get_member_expr_decl(expr);
-        tree_type* member_ptr = tree_new_pointer_type(
+        tree_type* member_ptr = tree_get_pointer_type(
                 ssa_get_tree(self->context), tree_get_decl_type(member));
         tree_decl* rec = tree_get_decl_type_entity(
                 tree_desugar_type(tree_get_pointer_target(ssa_get_const_type(var))));
@@ -175,7 +175,7 @@ static bool ssa_emit_global_var_decl(ssa_module_emitter* self, tree_decl* var)
 
         ssa_set_global_var_init(val, ssa_init);
         ssa_set_global_var_entity(val, var);
-        ssa_set_value_type(val, tree_new_pointer_type(self->context->tree, t));
+        ssa_set_value_type(val, tree_get_pointer_type(self->context->tree, t));
         return true;
 }
 
@@ -213,8 +213,8 @@ static inline bool _ssa_emit_log_expr(
                 ? _ssa_emit_log_expr(self, on_true, rhs_block, global_exit, lhs)
                 : _ssa_emit_log_expr(self, rhs_block, on_false, global_exit, lhs);
 
+        // the block is added to the function when it is terminated
         ssa_enter_block(self, rhs_block);
-        ssa_emit_block(self, rhs_block);
         return lhs_ok && _ssa_emit_log_expr(self, on_true, on_false, global_exit, tree_get_binop_rhs(expr));
 }
 
@@ -226,7 +226,6 @@ static ssa_value* ssa_emit_log_expr(ssa_function_emitter* self, const tree_expr*
         if (!_ssa_emit_log_expr(self, exit, exit, exit, expr))
                 return NULL;
         ssa_enter_block(self, exit);
-        ssa_emit_block(self, exit);
         return phi_var;
 }
 
@@ -549,7 +548,7 @@ extern ssa_value* ssa_emit_member_expr(ssa_function_emitter* self, const tree_ex
 
         if (tree_record_is_union(rec))
         {
-                tree_type* ptr = tree_new_pointer_type(
+                tree_type* ptr = tree_get_pointer_type(
                         ssa_get_tree(self->context), tree_get_decl_type(member));
                 field_addr = ssa_build_cast(&self->builder, ptr, lhs);
         }
@@ -678,7 +677,7 @@ static bool ssa_emit_record_initializer(ssa_function_emitter* self, ssa_value* r
                 tree_designator* fd = tree_get_designation_designators_begin(des)[0];
                 tree_decl* field = tree_get_designator_field(fd);
                 assert(field);
-                tree_type* field_addr = tree_new_pointer_type(
+                tree_type* field_addr = tree_get_pointer_type(
                         ssa_get_tree(self->context), tree_get_decl_type(field));
                 ssa_value* ssa_field = ssa_build_cast(&self->builder, field_addr, record);
                 if (!ssa_emit_local_var_initializer(self, ssa_field, tree_get_designation_init(des)))
@@ -707,7 +706,7 @@ static bool ssa_emit_array_initializer(ssa_function_emitter* self, ssa_value* ar
 {
         tree_type* et = tree_get_array_eltype(
                 tree_desugar_type(tree_get_pointer_target(ssa_get_value_type(array))));
-        tree_type* ptr = tree_new_pointer_type(self->context->tree, et);
+        tree_type* ptr = tree_get_pointer_type(self->context->tree, et);
         array = ssa_build_cast(&self->builder, ptr, array);
         assert(array);
 
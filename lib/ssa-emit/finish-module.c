@@ -72,7 +72,7 @@ static ssa_value* ssa_emit_atomic_block_alloca(
         if (!storage)
                 return NULL;
         if (!(storage = ssa_build_cast_ex(builder, ssa_get_var_instr(storage),
-                tree_new_pointer_type(self->context->tree, t), storage, true)))
+                tree_get_pointer_type(self->context->tree, t), storage, true)))
         {
                 return NULL;
         }
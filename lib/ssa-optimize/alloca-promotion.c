@@ -1,43 +1,106 @@
 #include "scc/ssa-optimize/optimize.h"
-#include "scc/ssa/builder.h"
 #include "scc/ssa/block.h"
+#include "scc/ssa/cfg.h"
 #include "scc/ssa/context.h"
+#include "scc/tree/target.h"
+#include "scc/tree/type.h"
 
-#define HTAB ssa_scope
-#define HTAB_K ssa_id
-#define HTAB_K_EMPTY -1
-#define HTAB_K_DEL -2
-#define HTAB_V ssa_value*
-#include "scc/core/htab.inc"
-#define SSA_SCOPE_FOREACH(PSCOPE, IT)\
-        for (struct ssa_scope_iter IT = ssa_scope_begin(PSCOPE);\
-                IT.pos != IT.end; ssa_scope_next(&IT))
+// Allocas which are only loaded and stored are replaced with SSA values as in
+// Cytron et al. Efficiently Computing Static Single Assignment Form and the Control Dependence Graph.
+// Phis are placed on the iterated dominance frontier of the stores, but only in blocks
+// where the variable is live, then loads are replaced walking the dominator tree.
+// Before that, allocas of records which are only accessed through addresses of the fields
+// are split into an alloca per field.
 
-typedef struct
+static bool ssa_address_is_volatile(ssa_value* addr)
 {
-        ssa_value* def;
-        int num_parents;
-} ssa_parent_def;
-
-#define HTAB ssa_parent_defs
-#define HTAB_K ssa_id
-#define HTAB_K_EMPTY -1
-#define HTAB_K_DEL -2
-#define HTAB_V ssa_parent_def
-#include "scc/core/htab.inc"
-#define SSA_PARENT_DEFS_FOREACH(PDEFS, IT)\
-        for (struct ssa_parent_defs_iter IT = ssa_parent_defs_begin(PDEFS);\
-                IT.pos != IT.end; ssa_parent_defs_next(&IT))
+        return tree_get_type_quals(tree_get_pointer_target(ssa_get_value_type(addr))) & TTQ_VOLATILE;
+}
 
-typedef struct
+// returns true if the address is only loaded from, stored to and used to get addresses of fields
+static bool ssa_address_is_only_accessed(ssa_value* addr)
+{
+        if (ssa_address_is_volatile(addr))
+                return false;
+
+        SSA_FOREACH_VALUE_USE(addr, use, end)
+        {
+                ssa_instr* instr = ssa_get_value_use_instr(use);
+                switch (ssa_get_instr_kind(instr))
+                {
+                        case SIK_LOAD:
+                                break;
+                        case SIK_STORE:
+                                if (ssa_get_instr_operand_value(instr, 0) == addr)
+                                        return false;
+                                break;
+                        case SIK_GETFIELDADDR:
+                                if (!ssa_address_is_only_accessed(ssa_get_instr_var(instr)))
+                                        return false;
+                                break;
+                        default:
+                                return false;
+                }
+        }
+        return true;
+}
+
+static bool ssa_alloca_is_splittable(ssa_instr* alloca)
 {
-        struct ssa_scope defs;
-        struct ssa_scope phis;
-} ssa_block_metadata;
+        ssa_value* var = ssa_get_instr_var(alloca);
+        if (!ssa_value_is_used(var))
+                return false;
+
+        SSA_FOREACH_VALUE_USE(var, use, end)
+                if (ssa_get_instr_kind(ssa_get_value_use_instr(use)) != SIK_GETFIELDADDR)
+                        return false;
+        return ssa_address_is_only_accessed(var);
+}
+
+// replaces the alloca of a record with allocas of the fields used, which are added to the list
+static void ssa_split_alloca(ssa_context* context, ssa_instr* alloca, struct vec* allocas)
+{
+        struct vec field_addrs;
+        vec_init(&field_addrs);
+        SSA_FOREACH_VALUE_USE(ssa_get_instr_var(alloca), use, end)
+                vec_push(&field_addrs, ssa_get_value_use_instr(use));
+
+        // allocas of the fields by their index
+        struct vec fields;
+        vec_init(&fields);
+        VEC_FOREACH(&field_addrs, it, end)
+        {
+                ssa_instr* field_addr = *it;
+                unsigned i = ssa_get_getfieldaddr_index(field_addr);
+                while (fields.size <= i)
+                        vec_push(&fields, NULL);
+
+                ssa_value* field_addr_var = ssa_get_instr_var(field_addr);
+                if (!fields.items[i])
+                {
+                        tree_type* type = ssa_get_value_type(field_addr_var);
+                        ssa_instr* field = ssa_new_alloca(context, type, (unsigned)tree_get_alignof(
+                                ssa_get_target(context), tree_get_pointer_target(type)));
+                        ssa_add_instr_before(field, alloca);
+                        vec_push(allocas, field);
+                        fields.items[i] = field;
+                }
+
+                ssa_replace_value_with(field_addr_var, ssa_get_instr_var(fields.items[i]));
+                ssa_remove_instr(field_addr);
+        }
+
+        ssa_remove_instr(alloca);
+        vec_drop(&fields);
+        vec_drop(&field_addrs);
+}
 
 static bool ssa_alloca_is_promotable(ssa_instr* alloca)
 {
         ssa_value* var = ssa_get_instr_var(alloca);
+        if (ssa_address_is_volatile(var))
+                return false;
+
         bool has_store = false;
         SSA_FOREACH_VALUE_USE(var, use, end)
         {
@@ -45,198 +108,436 @@ static bool ssa_alloca_is_promotable(ssa_instr* alloca)
                 ssa_instr_kind k = ssa_get_instr_kind(instr);
                 if (k == SIK_STORE)
                 {
-                        if (var != ssa_get_instr_operand_value(instr, 1))
+                        if (var == ssa_get_instr_operand_value(instr, 0))
                                 return false;
-
                         has_store = true;
                 }
-                else if (k != SIK_LOAD || !has_store)
+                else if (k != SIK_LOAD)
                         return false;
         }
-        return true;
+        // every load of a variable which is never stored would read its own undefined value
+        return has_store || !ssa_value_is_used(var);
 }
 
-static void ssa_find_promotable_allocas(
-        ssa_context* context, ssa_block* block, struct ssa_scope* promotable_allocas)
+typedef struct
 {
-        ssa_value* label = ssa_get_block_label(block);
+        ssa_instr* alloca;
+        // blocks which store to the variable
+        struct vec def_blocks;
+        // blocks which load the variable before storing to it
+        struct vec use_blocks;
+        // index + 1 of the last block added to def_blocks
+        unsigned last_def_block;
+        // the value reaching the current point of renaming
+        ssa_value* value;
+} ssa_promoted_var;
+
+#define VEC ssa_promoted_var_vec
+#define VEC_T ssa_promoted_var
+#include "scc/core/vec.inc"
+
+typedef struct
+{
+        ssa_instr* phi;
+        unsigned var;
+        // index of the next phi of the block, or -1
+        int next;
+} ssa_promoted_phi;
 
-        ssa_block_metadata* md = alloc(sizeof(ssa_block_metadata));
-        ssa_scope_init(&md->defs);
-        ssa_scope_init(&md->phis);
-        ssa_set_value_metadata(label, md);
+#define VEC ssa_promoted_phi_vec
+#define VEC_T ssa_promoted_phi
+#include "scc/core/vec.inc"
 
-        SSA_FOREACH_BLOCK_INSTR(block, instr)
-        {
-                if (ssa_get_instr_kind(instr) == SIK_ALLOCA)
-                {
-                        if (!ssa_alloca_is_promotable(instr))
-                                continue;
+typedef struct
+{
+        unsigned var;
+        ssa_value* value;
+} ssa_saved_value;
 
-                        ssa_value* var = ssa_get_instr_var(instr);
-                        ssa_scope_insert(promotable_allocas, ssa_get_value_id(var), var);
-                }
+#define VEC ssa_saved_value_vec
+#define VEC_T ssa_saved_value
+#include "scc/core/vec.inc"
+
+typedef struct
+{
+        ssa_context* context;
+        ssa_value* function;
+        ssa_cfg* cfg;
+        struct ssa_promoted_var_vec vars;
+        struct ssa_promoted_phi_vec phis;
+        // index + 1 of the variable by the id of its alloca
+        unsigned* var_by_id;
+        size_t num_ids;
+        // the following are indexed by the cfg node:
+        // index of the first phi placed in the block, or -1
+        int* first_phi;
+        // index + 1 of the last variable which is stored to, live-in or has a phi in the block
+        unsigned* def_mark;
+        unsigned* live_mark;
+        unsigned* phi_mark;
+        // previous values of the variables, restored when leaving a subtree of the dominator tree
+        struct ssa_saved_value_vec saved_values;
+} ssa_alloca_promoter;
+
+static void ssa_init_alloca_promoter(ssa_alloca_promoter* self, ssa_context* context, ssa_value* func)
+{
+        self->context = context;
+        self->function = func;
+        self->cfg = ssa_get_function_cfg(func);
+        ssa_promoted_var_vec_init(&self->vars);
+        ssa_promoted_phi_vec_init(&self->phis);
+        ssa_saved_value_vec_init(&self->saved_values);
+        self->var_by_id = NULL;
+        self->num_ids = 0;
+
+        size_t num_nodes = self->cfg->num_nodes;
+        self->first_phi = alloc(sizeof(int) * num_nodes);
+        self->def_mark = alloc(sizeof(unsigned) * num_nodes);
+        self->live_mark = alloc(sizeof(unsigned) * num_nodes);
+        self->phi_mark = alloc(sizeof(unsigned) * num_nodes);
+        for (size_t i = 0; i < num_nodes; i++)
+        {
+                self->first_phi[i] = -1;
+                self->def_mark[i] = 0;
+                self->live_mark[i] = 0;
+                self->phi_mark[i] = 0;
         }
 }
 
-static void ssa_promote_load(ssa_block* block,
-        ssa_instr* instr, ssa_context* context, struct ssa_scope* promotable_allocas)
+static void ssa_dispose_alloca_promoter(ssa_alloca_promoter* self)
 {
-        ssa_value* label = ssa_get_block_label(block);
-        ssa_block_metadata* md = ssa_get_value_metadata(label);
+        for (size_t i = 0; i < self->vars.size; i++)
+        {
+                vec_drop(&self->vars.items[i].def_blocks);
+                vec_drop(&self->vars.items[i].use_blocks);
+        }
+        ssa_promoted_var_vec_drop(&self->vars);
+        ssa_promoted_phi_vec_drop(&self->phis);
+        ssa_saved_value_vec_drop(&self->saved_values);
+        dealloc(self->var_by_id);
+        dealloc(self->first_phi);
+        dealloc(self->def_mark);
+        dealloc(self->live_mark);
+        dealloc(self->phi_mark);
+}
 
-        ssa_value* source = ssa_get_instr_operand_value(instr, 0);
-        ssa_id source_id = ssa_get_value_id(source);
-        if (!ssa_scope_has(promotable_allocas, source_id))
-                return;
+static void ssa_add_promoted_vars(ssa_alloca_promoter* self, struct vec* allocas)
+{
+        ssa_id max_id = 0;
+        VEC_FOREACH(allocas, it, end)
+        {
+                ssa_instr* alloca = *it;
+                if (!alloca || !ssa_alloca_is_promotable(alloca))
+                        continue;
 
-        struct ssa_scope_entry* def = ssa_scope_lookup(&md->defs, source_id);
-        ssa_value* val = def
-                ? def->value
-                : ssa_new_undef(context, tree_get_pointer_target(ssa_get_value_type(source)));
+                ssa_promoted_var var;
+                var.alloca = alloca;
+                vec_init(&var.def_blocks);
+                vec_init(&var.use_blocks);
+                var.last_def_block = 0;
+                var.value = NULL;
+                ssa_promoted_var_vec_push(&self->vars, var);
+
+                ssa_id id = ssa_get_value_id(ssa_get_instr_var(alloca));
+                if (id > max_id)
+                        max_id = id;
+        }
 
-        ssa_replace_value_with(ssa_get_instr_var(instr), val);
-        ssa_remove_instr(instr);
+        self->num_ids = max_id + 1;
+        self->var_by_id = alloc(sizeof(unsigned) * self->num_ids);
+        for (size_t i = 0; i < self->num_ids; i++)
+                self->var_by_id[i] = 0;
+        for (size_t i = 0; i < self->vars.size; i++)
+                self->var_by_id[ssa_get_value_id(ssa_get_instr_var(self->vars.items[i].alloca))] = (unsigned)i + 1;
 }
 
-static void ssa_promote_allocas_in_block(ssa_context*, ssa_block*, struct ssa_scope*);
-
-static void ssa_merge_parent_defs(ssa_context* context, ssa_block* block, struct ssa_scope* promotable_allocas)
+static ssa_promoted_var* ssa_get_promoted_var(ssa_alloca_promoter* self, ssa_value* addr)
 {
-        ssa_value* label = ssa_get_block_label(block);
-        ssa_block_metadata* md = ssa_get_value_metadata(label);
+        if (ssa_get_value_kind(addr) != SVK_LOCAL_VAR)
+                return NULL;
 
-        int num_parents = 0;
-        struct ssa_parent_defs parent_defs;
-        ssa_parent_defs_init(&parent_defs);
+        ssa_id id = ssa_get_value_id(addr);
+        if (id >= self->num_ids || !self->var_by_id[id])
+                return NULL;
 
-        SSA_FOREACH_VALUE_USE(label, it, end)
-        {
-                ssa_instr* instr = ssa_get_value_use_instr(it);
-                if (ssa_get_instr_kind(instr) != SIK_TERMINATOR)
-                        continue;
+        // values created by the promotion are not numbered
+        ssa_promoted_var* var = self->vars.items + self->var_by_id[id] - 1;
+        return var->alloca == ssa_get_var_instr(addr) ? var : NULL;
+}
 
-                ssa_block* parent_block = ssa_get_instr_block(instr);
-                ssa_value* parent_label = ssa_get_block_label(parent_block);
-                if (ssa_get_value_id(parent_label) >= ssa_get_value_id(label))
-                        continue;
+static void ssa_collect_var_blocks(ssa_alloca_promoter* self)
+{
+        SSA_FOREACH_CFG_NODE(self->cfg, node)
+                SSA_FOREACH_BLOCK_INSTR(node->block, instr)
+                {
+                        ssa_instr_kind k = ssa_get_instr_kind(instr);
+                        if (k == SIK_LOAD)
+                        {
+                                ssa_promoted_var* var = ssa_get_promoted_var(
+                                        self, ssa_get_instr_operand_value(instr, 0));
+                                if (!var || var->last_def_block == node->index + 1)
+                                        continue;
+                                if (!var->use_blocks.size || vec_last(&var->use_blocks) != node)
+                                        vec_push(&var->use_blocks, node);
+                        }
+                        else if (k == SIK_STORE)
+                        {
+                                ssa_promoted_var* var = ssa_get_promoted_var(
+                                        self, ssa_get_instr_operand_value(instr, 1));
+                                if (!var || var->last_def_block == node->index + 1)
+                                        continue;
 
-                ssa_block_metadata* parent_md = ssa_get_value_metadata(parent_label);
-                if (!parent_md)
+                                var->last_def_block = node->index + 1;
+                                vec_push(&var->def_blocks, node);
+                        }
+                }
+}
+
+static void ssa_place_phis(ssa_alloca_promoter* self, unsigned i, struct vec* worklist)
+{
+        ssa_promoted_var* var = self->vars.items + i;
+        unsigned mark = i + 1;
+        VEC_FOREACH(&var->def_blocks, it, end)
+                self->def_mark[((ssa_cfg_node*)*it)->index] = mark;
+
+        // the variable is live-in in the blocks which use it before a store
+        // and in their predecessors which do not store to it
+        VEC_FOREACH(&var->use_blocks, it, end)
+        {
+                self->live_mark[((ssa_cfg_node*)*it)->index] = mark;
+                vec_push(worklist, *it);
+        }
+        while (worklist->size)
+        {
+                ssa_cfg_node* node = vec_pop(worklist);
+                SSA_FOREACH_CFG_NODE_PRED(node, it, end)
                 {
-                        // todo: topological sort?
-                        ssa_promote_allocas_in_block(context, parent_block, promotable_allocas);
-                        parent_md = ssa_get_value_metadata(parent_label);
+                        unsigned pred = (*it)->index;
+                        if (self->live_mark[pred] == mark || self->def_mark[pred] == mark)
+                                continue;
+
+                        self->live_mark[pred] = mark;
+                        vec_push(worklist, *it);
                 }
-        
-                assert(parent_md);
-                SSA_SCOPE_FOREACH(&parent_md->defs, it)
+        }
+
+        tree_type* type = ssa_get_allocated_type(var->alloca);
+        VEC_FOREACH(&var->def_blocks, it, end)
+                vec_push(worklist, *it);
+        while (worklist->size)
+        {
+                ssa_cfg_node* node = vec_pop(worklist);
+                SSA_FOREACH_CFG_NODE_FRONTIER(node, it, end)
                 {
-                        struct ssa_parent_defs_entry* e = ssa_parent_defs_lookup(&parent_defs, it.pos->key);
-                        if (!e)
+                        ssa_cfg_node* frontier = *it;
+                        if (self->phi_mark[frontier->index] == mark
+                                || self->live_mark[frontier->index] != mark)
                         {
-                                ssa_parent_def def = { it.pos->value, 1 };
-                                ssa_parent_defs_insert(&parent_defs, it.pos->key, def);
+                                continue;
                         }
-                        else
-                                e->value.num_parents++;
+
+                        self->phi_mark[frontier->index] = mark;
+                        ssa_instr* phi = ssa_new_phi(self->context, type);
+                        ssa_add_instr_before(phi, ssa_get_block_instrs_begin(frontier->block));
+
+                        ssa_promoted_phi p = { phi, i, self->first_phi[frontier->index] };
+                        self->first_phi[frontier->index] = (int)self->phis.size;
+                        ssa_promoted_phi_vec_push(&self->phis, p);
+
+                        if (self->def_mark[frontier->index] != mark)
+                                vec_push(worklist, frontier);
                 }
-                num_parents++;
         }
+}
 
-        SSA_PARENT_DEFS_FOREACH(&parent_defs, it)
-        {
-                ssa_builder b;
-                ssa_init_builder(&b, context, ssa_get_block_instrs_begin(block));
-                ssa_value* phi = ssa_build_phi(&b, ssa_get_value_type(it.pos->value.def));
-                ssa_scope_update(&md->phis, it.pos->key, phi);
-                ssa_scope_update(&md->defs, it.pos->key, phi);
-        }
+static void ssa_set_var_value(ssa_alloca_promoter* self, ssa_promoted_var* var, ssa_value* value)
+{
+        ssa_saved_value saved = { (unsigned)(var - self->vars.items), var->value };
+        ssa_saved_value_vec_push(&self->saved_values, saved);
+        var->value = value;
+}
 
-        ssa_parent_defs_drop(&parent_defs);
+static ssa_value* ssa_get_var_value(ssa_alloca_promoter* self, ssa_promoted_var* var)
+{
+        return var->value
+                ? var->value
+                : ssa_new_undef(self->context, ssa_get_allocated_type(var->alloca));
 }
 
-static void ssa_promote_allocas_in_block(
-        ssa_context* context, ssa_block* block, struct ssa_scope* promotable_allocas)
+static void ssa_add_successor_phi_operands(
+        ssa_alloca_promoter* self, ssa_block* block, bool reachable)
 {
+        ssa_instr* terminator = ssa_get_block_terminator(block);
+        if (!terminator || ssa_get_instr_kind(terminator) != SIK_TERMINATOR)
+                return;
+
+        // a phi has an operand for each edge, even if several edges come from the same block
         ssa_value* label = ssa_get_block_label(block);
-        ssa_block_metadata* md = ssa_get_value_metadata(label);
+        SSA_FOREACH_TERMINATOR_SUCCESSOR(terminator, it, end)
+        {
+                ssa_cfg_node* succ = ssa_get_cfg_node(self->cfg,
+                        ssa_get_label_block(ssa_get_value_use_value(it)));
+                if (!succ)
+                        continue;
+
+                for (int i = self->first_phi[succ->index]; i != -1; i = self->phis.items[i].next)
+                {
+                        ssa_promoted_phi* p = self->phis.items + i;
+                        ssa_promoted_var* var = self->vars.items + p->var;
+                        ssa_value* value = reachable
+                                ? ssa_get_var_value(self, var)
+                                : ssa_new_undef(self->context, ssa_get_allocated_type(var->alloca));
+                        ssa_add_phi_operand(p->phi, self->context, value, label);
+                }
+        }
+}
 
-        ssa_merge_parent_defs(context, block, promotable_allocas);
+static void ssa_rename_block(ssa_alloca_promoter* self, ssa_cfg_node* node)
+{
+        for (int i = self->first_phi[node->index]; i != -1; i = self->phis.items[i].next)
+                ssa_set_var_value(self, self->vars.items + self->phis.items[i].var,
+                        ssa_get_instr_var(self->phis.items[i].phi));
 
-        SSA_FOREACH_BLOCK_INSTR_SAFE(block, instr, next)
+        SSA_FOREACH_BLOCK_INSTR_SAFE(node->block, instr, next)
         {
                 ssa_instr_kind k = ssa_get_instr_kind(instr);
                 if (k == SIK_LOAD)
-                        ssa_promote_load(block, instr, context, promotable_allocas);
+                {
+                        ssa_promoted_var* var = ssa_get_promoted_var(self, ssa_get_instr_operand_value(instr, 0));
+                        if (!var)
+                                continue;
+
+                        ssa_replace_value_with(ssa_get_instr_var(instr), ssa_get_var_value(self, var));
+                        ssa_remove_instr(instr);
+                }
                 else if (k == SIK_STORE)
                 {
-                        ssa_value* dest = ssa_get_instr_operand_value(instr, 1);
-                        ssa_id dest_id = ssa_get_value_id(dest);
-                        if (!ssa_scope_has(promotable_allocas, dest_id))
+                        ssa_promoted_var* var = ssa_get_promoted_var(self, ssa_get_instr_operand_value(instr, 1));
+                        if (!var)
                                 continue;
 
-                        ssa_scope_update(&md->defs, dest_id, ssa_get_instr_operand_value(instr, 0));
+                        ssa_set_var_value(self, var, ssa_get_instr_operand_value(instr, 0));
                         ssa_remove_instr(instr);
                 }
         }
+
+        ssa_add_successor_phi_operands(self, node->block, true);
 }
 
-static void ssa_update_phi_operands(ssa_context* context, ssa_block* block)
+typedef struct
 {
-        ssa_value* label = ssa_get_block_label(block);
-        ssa_block_metadata* md = ssa_get_value_metadata(label);
+        ssa_cfg_node* node;
+        // size of the saved values when the node was entered, or -1 if it was not
+        size_t num_saved_values;
+} ssa_rename_frame;
 
-        ssa_instr* terminator = ssa_get_block_terminator(block);
-        SSA_FOREACH_TERMINATOR_SUCCESSOR(terminator, it, end)
+#define VEC ssa_rename_stack
+#define VEC_T ssa_rename_frame
+#include "scc/core/vec.inc"
+
+static void ssa_rename_vars(ssa_alloca_promoter* self)
+{
+        struct ssa_rename_stack stack;
+        ssa_rename_stack_init(&stack);
+        ssa_rename_frame entry = { ssa_get_cfg_entry(self->cfg), (size_t)-1 };
+        ssa_rename_stack_push(&stack, entry);
+
+        while (stack.size)
         {
-                ssa_value* child_label = ssa_get_value_use_value(it);
-                ssa_block_metadata* child_md = ssa_get_value_metadata(child_label);
+                ssa_rename_frame* frame = ssa_rename_stack_last_ptr(&stack);
+                if (frame->num_saved_values != (size_t)-1)
+                {
+                        while (self->saved_values.size > frame->num_saved_values)
+                        {
+                                ssa_saved_value saved = ssa_saved_value_vec_pop(&self->saved_values);
+                                self->vars.items[saved.var].value = saved.value;
+                        }
+                        ssa_rename_stack_pop(&stack);
+                        continue;
+                }
+
+                ssa_cfg_node* node = frame->node;
+                frame->num_saved_values = self->saved_values.size;
+                ssa_rename_block(self, node);
 
-                assert(child_md);
-                SSA_SCOPE_FOREACH(&child_md->phis, it)
+                SSA_FOREACH_CFG_NODE_CHILD(node, it, end)
                 {
-                        ssa_instr* instr = ssa_get_var_instr(it.pos->value);
-                        assert(ssa_get_instr_kind(instr) == SIK_PHI);
-                        struct ssa_scope_entry* e = ssa_scope_lookup(&md->defs, it.pos->key);
-                        ssa_value* operand = e
-                                ? e->value
-                                : ssa_new_undef(context, ssa_get_value_type(it.pos->value));
-                        ssa_add_phi_operand(instr, context, operand, label);
+                        ssa_rename_frame child = { *it, (size_t)-1 };
+                        ssa_rename_stack_push(&stack, child);
                 }
         }
+        ssa_rename_stack_drop(&stack);
 }
 
-static void ssa_eliminate_unused_allocas_and_trivial_phis(ssa_block* block)
+// unreachable blocks are not renamed, but can still access the variables and jump to phis
+static void ssa_promote_unreachable_blocks(ssa_alloca_promoter* self)
 {
-        SSA_FOREACH_BLOCK_INSTR_SAFE(block, instr, next)
+        SSA_FOREACH_FUNCTION_BLOCK(self->function, block)
         {
-                ssa_instr_kind k = ssa_get_instr_kind(instr);
-                if ((k == SIK_ALLOCA || k == SIK_PHI) && !ssa_value_is_used(ssa_get_instr_var(instr)))
-                {
-                        ssa_remove_instr(instr);
+                if (ssa_get_cfg_node(self->cfg, block))
                         continue;
+
+                SSA_FOREACH_BLOCK_INSTR_SAFE(block, instr, next)
+                {
+                        ssa_instr_kind k = ssa_get_instr_kind(instr);
+                        if (k == SIK_LOAD)
+                        {
+                                ssa_value* var = ssa_get_instr_var(instr);
+                                if (!ssa_get_promoted_var(self, ssa_get_instr_operand_value(instr, 0)))
+                                        continue;
+
+                                ssa_replace_value_with(var, ssa_new_undef(self->context, ssa_get_value_type(var)));
+                                ssa_remove_instr(instr);
+                        }
+                        else if (k == SIK_STORE)
+                        {
+                                if (ssa_get_promoted_var(self, ssa_get_instr_operand_value(instr, 1)))
+                                        ssa_remove_instr(instr);
+                        }
                 }
-                else if (k != SIK_PHI)
-                        continue;
 
-                bool all_same = true;
-                ssa_value* operand = NULL;
-                SSA_FOREACH_INSTR_OPERAND(instr, it, end) 
+                ssa_add_successor_phi_operands(self, block, false);
+        }
+}
+
+// removes phis which merge a single value and phis which are not used
+static void ssa_remove_trivial_phis(ssa_alloca_promoter* self)
+{
+        bool changed = true;
+        while (changed)
+        {
+                changed = false;
+                for (size_t i = 0; i < self->phis.size; i++)
                 {
-                        if (!operand)
-                                operand = it->value;
-                        else if (it->value != operand)
+                        ssa_promoted_phi* p = self->phis.items + i;
+                        if (!p->phi)
+                                continue;
+
+                        ssa_value* var = ssa_get_instr_var(p->phi);
+                        ssa_value* value = NULL;
+                        bool trivial = true;
+                        for (size_t j = 0; j < ssa_get_instr_operands_size(p->phi); j += 2)
                         {
-                                all_same = false;
-                                break;
+                                ssa_value* operand = ssa_get_instr_operand_value(p->phi, j);
+                                if (operand == var || operand == value)
+                                        continue;
+                                if (value)
+                                {
+                                        trivial = false;
+                                        break;
+                                }
+                                value = operand;
                         }
-                        it++;
+                        if (!trivial && ssa_value_is_used(var))
+                                continue;
+
+                        if (ssa_value_is_used(var))
+                                ssa_replace_value_with(var, value
+                                        ? value : ssa_new_undef(self->context, ssa_get_value_type(var)));
+                        ssa_remove_instr(p->phi);
+                        p->phi = NULL;
+                        changed = true;
                 }
-                if (!all_same)
-                        continue;
-                ssa_replace_value_with(ssa_get_instr_var(instr), operand);
-                ssa_remove_instr(instr);
         }
 }
 
@@ -245,27 +546,46 @@ extern void ssa_promote_allocas(const ssa_pass* pass)
         if (!ssa_function_has_body(pass->function))
                 return;
 
-        struct ssa_scope promotable_allocas;
-        ssa_scope_init(&promotable_allocas);
-
+        struct vec allocas;
+        vec_init(&allocas);
         SSA_FOREACH_FUNCTION_BLOCK(pass->function, block)
-                ssa_find_promotable_allocas(pass->context, block, &promotable_allocas);
+                SSA_FOREACH_BLOCK_INSTR(block, instr)
+                        if (ssa_get_instr_kind(instr) == SIK_ALLOCA)
+                                vec_push(&allocas, instr);
 
-        SSA_FOREACH_FUNCTION_BLOCK(pass->function, block)
-                ssa_promote_allocas_in_block(pass->context, block, &promotable_allocas);
-
-        SSA_FOREACH_FUNCTION_BLOCK(pass->function, block)
-                ssa_update_phi_operands(pass->context, block);
-
-        SSA_FOREACH_FUNCTION_BLOCK(pass->function, block)
+        // allocas of the fields are appended to the list and may be split further
+        bool split = false;
+        for (size_t i = 0; i < allocas.size; i++)
         {
-                ssa_eliminate_unused_allocas_and_trivial_phis(block);
+                ssa_instr* alloca = allocas.items[i];
+                if (!ssa_alloca_is_splittable(alloca))
+                        continue;
 
-                ssa_block_metadata* md = ssa_remove_value_metadata(ssa_get_block_label(block));
-                ssa_scope_drop(&md->defs);
-                ssa_scope_drop(&md->phis);
-                dealloc(md);
+                ssa_split_alloca(pass->context, alloca, &allocas);
+                allocas.items[i] = NULL;
+                split = true;
         }
-
-        ssa_scope_drop(&promotable_allocas);
+        // promoted variables are looked up by the ids of their allocas
+        if (split)
+                ssa_number_function_values(pass->function);
+
+        ssa_alloca_promoter promoter;
+        ssa_init_alloca_promoter(&promoter, pass->context, pass->function);
+        ssa_add_promoted_vars(&promoter, &allocas);
+        vec_drop(&allocas);
+
+        ssa_collect_var_blocks(&promoter);
+        struct vec worklist;
+        vec_init(&worklist);
+        for (unsigned i = 0; i < promoter.vars.size; i++)
+                ssa_place_phis(&promoter, i, &worklist);
+        vec_drop(&worklist);
+
+        ssa_rename_vars(&promoter);
+        ssa_promote_unreachable_blocks(&promoter);
+        ssa_remove_trivial_phis(&promoter);
+
+        for (size_t i = 0; i < promoter.vars.size; i++)
+                ssa_remove_instr(promoter.vars.items[i].alloca);
+        ssa_dispose_alloca_promoter(&promoter);
 }
@@ -1,3 +1,4 @@
+#include "constant-fold.h"
 #include "scc/core/num.h"
 #include "scc/ssa-optimize/optimize.h"
 #include "scc/ssa/block.h"
@@ -39,30 +40,27 @@ static op_result ssa_eval_binop(ssa_binop_kind opcode, struct num* l, struct num
         }
 }
 
-static ssa_value* ssa_constant_fold_binop(ssa_context* context, ssa_instr* instr)
+extern ssa_value* ssa_fold_binop(ssa_context* context,
+        const ssa_instr* instr, const ssa_value* lhs, const ssa_value* rhs)
 {
-        ssa_value* lhs = ssa_get_instr_operand_value(instr, 0);
-        ssa_value* rhs = ssa_get_instr_operand_value(instr, 1);
+        struct num l = *ssa_get_constant_cvalue(lhs);
+        struct num r = *ssa_get_constant_cvalue(rhs);
+        ssa_binop_kind k = ssa_get_binop_kind(instr);
+        // shifting by the width of the type or more gives no value
+        if ((k == SBIK_SHL || k == SBIK_SHR) && num_is_integral(&r) && num_as_u64(&r) >= l.num_bits)
+                return NULL;
 
-        if (ssa_get_value_kind(lhs) != SVK_CONSTANT
-                || ssa_get_value_kind(rhs) != SVK_CONSTANT)
-        {
+        // overflows wrap around
+        op_result result = ssa_eval_binop(k, &l, &r);
+        if (result == OR_DIV_BY_ZERO || result == OR_INVALID)
                 return NULL;
-        }
 
-        struct num l = *ssa_get_constant_cvalue(lhs);
-        struct num r = *ssa_get_constant_cvalue(rhs);
-        ssa_eval_binop(ssa_get_binop_kind(instr), &l, &r);
         return ssa_new_constant(context,
                 ssa_get_value_type(ssa_get_instr_cvar(instr)), &l);
 }
 
-static ssa_value* ssa_constant_fold_cast(ssa_context* context, ssa_instr* instr)
+extern ssa_value* ssa_fold_cast(ssa_context* context, const ssa_instr* instr, const ssa_value* operand)
 {
-        ssa_value* operand = ssa_get_instr_operand_value(instr, 0);
-        if (ssa_get_value_kind(operand) != SVK_CONSTANT)
-                return NULL;
-
         struct num v = *ssa_get_constant_cvalue(operand);
         tree_type* to = ssa_get_value_type(ssa_get_instr_cvar(instr));
         const tree_target_info* target = ssa_get_target(context);
@@ -84,6 +82,29 @@ static ssa_value* ssa_constant_fold_cast(ssa_context* context, ssa_instr* instr)
         return ssa_new_constant(context, to, &v);
 }
 
+static ssa_value* ssa_constant_fold_binop(ssa_context* context, ssa_instr* instr)
+{
+        ssa_value* lhs = ssa_get_instr_operand_value(instr, 0);
+        ssa_value* rhs = ssa_get_instr_operand_value(instr, 1);
+
+        if (ssa_get_value_kind(lhs) != SVK_CONSTANT
+                || ssa_get_value_kind(rhs) != SVK_CONSTANT)
+        {
+                return NULL;
+        }
+
+        return ssa_fold_binop(context, instr, lhs, rhs);
+}
+
+static ssa_value* ssa_constant_fold_cast(ssa_context* context, ssa_instr* instr)
+{
+        ssa_value* operand = ssa_get_instr_operand_value(instr, 0);
+        if (ssa_get_value_kind(operand) != SVK_CONSTANT)
+                return NULL;
+
+        return ssa_fold_cast(context, instr, operand);
+}
+
 static void ssa_constant_fold_instr(ssa_context* context, ssa_instr* instr)
 {
         ssa_value* constant = NULL;
@@ -0,0 +1,12 @@
+#ifndef SSA_CONSTANT_FOLD_H
+#define SSA_CONSTANT_FOLD_H
+
+#include "scc/ssa/instr.h"
+
+// Return the constant the instruction evaluates to with the given constant operands,
+// or NULL if it cannot be evaluated.
+extern ssa_value* ssa_fold_binop(ssa_context* context,
+        const ssa_instr* instr, const ssa_value* lhs, const ssa_value* rhs);
+extern ssa_value* ssa_fold_cast(ssa_context* context, const ssa_instr* instr, const ssa_value* operand);
+
+#endif
@@ -0,0 +1,252 @@
+#include "scc/core/hash.h"
+#include "scc/core/num.h"
+#include "scc/ssa-optimize/optimize.h"
+#include "scc/ssa/block.h"
+#include "scc/ssa/cfg.h"
+#include "scc/tree/type.h"
+
+// Dominator-based value numbering.
+// Briggs, Cooper, Simpson. Value Numbering.
+// Blocks are visited in the preorder of the dominator tree and each binary instruction,
+// cast, field address and load is looked up in a table of instructions computing the same
+// value. A match whose block dominates the instruction replaces it. Otherwise the instruction
+// becomes the one the following blocks are matched against, since the preorder never comes
+// back to the subtree of the previous one.
+// Loads also match only if they see the same memory, which is identified by the last
+// instruction that may write it (kept in the metadata of the load).
+
+static bool ssa_binop_is_commutative(ssa_binop_kind k)
+{
+        return k == SBIK_MUL || k == SBIK_ADD || k == SBIK_AND || k == SBIK_OR
+                || k == SBIK_XOR || k == SBIK_EQ || k == SBIK_NEQ;
+}
+
+// the builder creates a new constant for each use, so integer constants are compared by value
+static bool ssa_constant_is_numbered(const ssa_value* value)
+{
+        return ssa_get_value_kind(value) == SVK_CONSTANT
+                && num_is_integral(ssa_get_constant_cvalue(value));
+}
+
+static uint32_t ssa_hash_value(const ssa_value* value)
+{
+        return ssa_constant_is_numbered(value)
+                ? mix32((uint32_t)num_as_u64(ssa_get_constant_cvalue(value)))
+                : mix32((uint32_t)(size_t)value);
+}
+
+static bool ssa_values_are_equal(const ssa_value* a, const ssa_value* b)
+{
+        if (a == b)
+                return true;
+        if (!ssa_constant_is_numbered(a) || !ssa_constant_is_numbered(b))
+                return false;
+
+        const struct num* l = ssa_get_constant_cvalue(a);
+        const struct num* r = ssa_get_constant_cvalue(b);
+        return l->kind == r->kind
+                && l->num_bits == r->num_bits
+                && num_cmp(l, r) == 0
+                && tree_compare_types(ssa_get_value_type(a), ssa_get_value_type(b)) == TTEK_EQ;
+}
+
+static unsigned ssa_hash_instr(const ssa_instr* instr)
+{
+        ssa_instr_kind k = ssa_get_instr_kind(instr);
+        uint32_t h = mix32((uint32_t)k);
+        uint32_t ops = 0;
+        for (size_t i = 0; i < ssa_get_instr_operands_size(instr); i++)
+                ops += ssa_hash_value(ssa_get_instr_operand_value(instr, i));
+
+        if (k == SIK_BINARY)
+                h ^= mix32((uint32_t)ssa_get_binop_kind(instr));
+        else if (k == SIK_GETFIELDADDR)
+                h ^= mix32(ssa_get_getfieldaddr_index(instr));
+        else if (k == SIK_LOAD)
+                h ^= mix32((uint32_t)(size_t)ssa_get_value_metadata(ssa_get_instr_cvar(instr)));
+
+        // operands are summed up, so swapped operands of commutative instructions match
+        return (unsigned)(h ^ mix32(ops));
+}
+
+static bool ssa_instrs_are_equal(const ssa_instr* a, const ssa_instr* b)
+{
+        ssa_instr_kind k = ssa_get_instr_kind(a);
+        if (k != ssa_get_instr_kind(b)
+                || ssa_get_instr_operands_size(a) != ssa_get_instr_operands_size(b))
+        {
+                return false;
+        }
+
+        const ssa_value* var_a = ssa_get_instr_cvar(a);
+        const ssa_value* var_b = ssa_get_instr_cvar(b);
+        if (k == SIK_GETFIELDADDR && ssa_get_getfieldaddr_index(a) != ssa_get_getfieldaddr_index(b))
+                return false;
+        if (k == SIK_LOAD && ssa_get_value_metadata(var_a) != ssa_get_value_metadata(var_b))
+                return false;
+        if (tree_compare_types(ssa_get_value_type(var_a), ssa_get_value_type(var_b)) != TTEK_EQ)
+                return false;
+
+        bool same = true;
+        for (size_t i = 0; i < ssa_get_instr_operands_size(a); i++)
+                if (!ssa_values_are_equal(ssa_get_instr_operand_value(a, i), ssa_get_instr_operand_value(b, i)))
+                        same = false;
+
+        if (k != SIK_BINARY)
+                return same;
+
+        ssa_binop_kind binop = ssa_get_binop_kind(a);
+        if (binop != ssa_get_binop_kind(b))
+                return false;
+
+        return same || (ssa_binop_is_commutative(binop)
+                && ssa_values_are_equal(ssa_get_instr_operand_value(a, 0), ssa_get_instr_operand_value(b, 1))
+                && ssa_values_are_equal(ssa_get_instr_operand_value(a, 1), ssa_get_instr_operand_value(b, 0)));
+}
+
+#define HTAB ssa_value_table
+#define HTAB_K const ssa_instr*
+#define HTAB_K_EMPTY (const ssa_instr*)0
+#define HTAB_K_DEL (const ssa_instr*)1
+#define HTAB_K_TO_U32(K) ssa_hash_instr(K)
+#define HTAB_EQ(K1, K2) ((K1) == (K2) \
+        || ((size_t)(K1) > 1 && (size_t)(K2) > 1 && ssa_instrs_are_equal(K1, K2)))
+#include "scc/core/htab.inc"
+
+// matches the loads which are printed as volatile
+static bool ssa_address_is_volatile(ssa_value* addr)
+{
+        const tree_type* type = tree_desugar_type_c(ssa_get_value_type(addr));
+        return tree_type_is(type, TTK_POINTER)
+                && (tree_get_type_quals(tree_get_pointer_target(type)) & TTQ_VOLATILE);
+}
+
+static bool ssa_instr_may_write_memory(ssa_instr* instr)
+{
+        switch (ssa_get_instr_kind(instr))
+        {
+                case SIK_ALLOCA:
+                case SIK_CAST:
+                case SIK_BINARY:
+                case SIK_GETFIELDADDR:
+                case SIK_PHI:
+                case SIK_TERMINATOR:
+                        return false;
+                case SIK_LOAD:
+                        // accesses of volatile objects are kept in order
+                        return ssa_address_is_volatile(ssa_get_instr_operand_value(instr, 0));
+                default:
+                        return true;
+        }
+}
+
+typedef struct
+{
+        ssa_cfg* cfg;
+        struct ssa_value_table table;
+        // loads which got the memory they see in their metadata
+        struct vec loads;
+} ssa_value_numbering;
+
+// returns the instruction computing the same value in a dominating block, or NULL
+static ssa_instr* ssa_find_leader(ssa_value_numbering* self, ssa_cfg_node* node, ssa_instr* instr)
+{
+        struct ssa_value_table_entry* e = ssa_value_table_lookup(&self->table, instr);
+        if (!e)
+        {
+                ssa_value_table_insert(&self->table, instr);
+                return NULL;
+        }
+
+        ssa_instr* leader = (ssa_instr*)e->key;
+        ssa_block* leader_block = ssa_get_instr_block(leader);
+        if (leader_block == node->block
+                || ssa_cfg_node_dominates(ssa_get_cfg_node(self->cfg, leader_block), node))
+        {
+                return leader;
+        }
+
+        e->key = instr;
+        return NULL;
+}
+
+// Returns the memory seen by the block when it starts: a block entered only from its
+// immediate dominator sees the memory its dominator ends with.
+static void* ssa_get_block_memory(ssa_cfg_node* node, void** memory)
+{
+        if (node->preds.size == 1 && node->idom == vec_last(&node->preds)
+                && ssa_block_is_atomic(node->block) == ssa_block_is_atomic(node->idom->block))
+        {
+                return memory[node->idom->index];
+        }
+        return ssa_get_block_label(node->block);
+}
+
+static bool ssa_instr_is_numbered(ssa_instr* instr)
+{
+        ssa_instr_kind k = ssa_get_instr_kind(instr);
+        if (k == SIK_LOAD)
+                return !ssa_block_is_atomic(ssa_get_instr_block(instr))
+                        && !ssa_address_is_volatile(ssa_get_instr_operand_value(instr, 0));
+        return k == SIK_BINARY || k == SIK_CAST || k == SIK_GETFIELDADDR;
+}
+
+static void ssa_number_block_values(ssa_value_numbering* self, ssa_cfg_node* node, void** memory)
+{
+        void* block_memory = ssa_get_block_memory(node, memory);
+        SSA_FOREACH_BLOCK_INSTR_SAFE(node->block, instr, next)
+        {
+                if (ssa_instr_may_write_memory(instr))
+                        block_memory = instr;
+                if (!ssa_instr_is_numbered(instr))
+                        continue;
+
+                ssa_value* var = ssa_get_instr_var(instr);
+                bool is_load = ssa_get_instr_kind(instr) == SIK_LOAD;
+                if (is_load)
+                        ssa_set_value_metadata(var, block_memory);
+
+                ssa_instr* leader = ssa_find_leader(self, node, instr);
+                if (!leader)
+                {
+                        if (is_load)
+                                vec_push(&self->loads, var);
+                        continue;
+                }
+
+                if (is_load)
+                        ssa_set_value_metadata(var, NULL);
+                ssa_replace_value_with(var, ssa_get_instr_var(leader));
+                ssa_remove_instr(instr);
+        }
+        memory[node->index] = block_memory;
+}
+
+extern void ssa_eliminate_common_subexpressions(const ssa_pass* pass)
+{
+        if (!ssa_function_has_body(pass->function))
+                return;
+
+        ssa_value_numbering vn;
+        vn.cfg = ssa_get_function_cfg(pass->function);
+        ssa_value_table_init(&vn.table);
+        vec_init(&vn.loads);
+
+        size_t num_nodes = vn.cfg->num_nodes;
+        ssa_cfg_node** preorder = alloc(sizeof(ssa_cfg_node*) * num_nodes);
+        void** memory = alloc(sizeof(void*) * num_nodes);
+        SSA_FOREACH_CFG_NODE(vn.cfg, node)
+                preorder[node->dom_begin] = node;
+
+        // unreachable blocks are left as they are
+        for (size_t i = 0; i < num_nodes; i++)
+                ssa_number_block_values(&vn, preorder[i], memory);
+
+        VEC_FOREACH(&vn.loads, it, end)
+                ssa_set_value_metadata(*it, NULL);
+
+        dealloc(preorder);
+        dealloc(memory);
+        vec_drop(&vn.loads);
+        ssa_value_table_drop(&vn.table);
+}
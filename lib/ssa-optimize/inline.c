@@ -1,6 +1,271 @@
 #include "scc/ssa-optimize/optimize.h"
+#include "scc/ssa/block.h"
+#include "scc/ssa/context.h"
+#include "scc/ssa/module.h"
+#include "scc/tree/type.h"
+#include <limits.h>
 
+// calls of functions which cost more than this are not inlined
+#define SSA_INLINE_THRESHOLD 40
+// inlining does not grow a function past this number of instructions
+#define SSA_INLINE_MAX_FUNCTION_SIZE 4000
+
+static bool ssa_call_is_inlinable(const ssa_instr* call, ssa_value* callee)
+{
+        if (!ssa_function_has_body(callee))
+                return false;
+
+        tree_type* func_type = tree_get_pointer_target(ssa_get_value_type(callee));
+        if (tree_func_type_is_vararg(func_type))
+                return false;
+
+        // arguments of a call without a prototype may not match the parameters
+        size_t num_params = ssa_get_function_params_end(callee) - ssa_get_function_params_begin(callee);
+        if (ssa_get_instr_operands_size(call) != num_params + 1)
+                return false;
+
+        ssa_value** param = ssa_get_function_params_begin(callee);
+        for (size_t i = 1; i < ssa_get_instr_operands_size(call); i++, param++)
+        {
+                tree_type* arg_type = ssa_get_value_type(ssa_get_instr_operand_value(call, i));
+                if (tree_compare_types(arg_type, ssa_get_value_type(*param)) == TTEK_NEQ)
+                        return false;
+        }
+        return true;
+}
+
+// Returns the number of instructions the call adds to the caller when inlined,
+// or INT_MAX if the callee cannot be inlined.
+static int ssa_get_inline_cost(const ssa_instr* call, ssa_value* callee)
+{
+        if (!ssa_call_is_inlinable(call, callee))
+                return INT_MAX;
+
+        // the call and passing of its arguments go away
+        int cost = -(int)ssa_get_instr_operands_size(call);
+        SSA_FOREACH_FUNCTION_BLOCK(callee, block)
+        {
+                // instrumentation of transactions is done after the optimization
+                if (ssa_block_is_atomic(block))
+                        return INT_MAX;
+
+                SSA_FOREACH_BLOCK_INSTR(block, instr)
+                {
+                        ssa_instr_kind k = ssa_get_instr_kind(instr);
+                        if (k == SIK_CALL)
+                        {
+                                // intrinsics refer to the frame of the function calling them
+                                ssa_value* func = ssa_get_called_func(instr);
+                                if (ssa_get_value_kind(func) == SVK_FUNCTION
+                                        && ssa_get_function_intrin_kind(func) != SSA_INTRIN_NONE)
+                                {
+                                        return INT_MAX;
+                                }
+                        }
+
+                        // allocas are merged into the entry block of the caller
+                        if (k != SIK_ALLOCA && ++cost > SSA_INLINE_THRESHOLD)
+                                return INT_MAX;
+                }
+        }
+        return cost;
+}
+
+// Values of the callee are mapped to their copies through metadata.
+static ssa_value* ssa_get_inlined_value(ssa_value* value)
+{
+        ssa_value_kind k = ssa_get_value_kind(value);
+        if (k != SVK_LOCAL_VAR && k != SVK_LABEL && k != SVK_PARAM)
+                return value;
+
+        ssa_value* copy = ssa_get_value_metadata(value);
+        assert(copy);
+        return copy;
+}
+
+static void ssa_clear_inlined_values(ssa_value* callee)
+{
+        SSA_FOREACH_FUNCTION_PARAM(callee, it)
+                ssa_set_value_metadata(*it, NULL);
+        SSA_FOREACH_FUNCTION_BLOCK(callee, block)
+        {
+                ssa_set_value_metadata(ssa_get_block_label(block), NULL);
+                SSA_FOREACH_BLOCK_INSTR(block, instr)
+                        ssa_set_value_metadata(ssa_get_instr_var(instr), NULL);
+        }
+}
+
+// moves the instructions after the call to a new block, which is returned
+static ssa_block* ssa_split_block_after(ssa_context* context, ssa_instr* call)
+{
+        ssa_block* block = ssa_get_instr_block(call);
+        ssa_block* rest = ssa_new_block(context, ssa_block_is_atomic(block));
+        ssa_add_block_after(rest, block);
+
+        ssa_instr* end = ssa_get_block_instrs_end(block);
+        for (ssa_instr* it = ssa_get_next_instr(call), *next; it != end; it = next)
+        {
+                next = ssa_get_next_instr(it);
+                ssa_move_instr(it, ssa_get_block_instrs_end(rest), false);
+        }
+
+        // successors are now reached from the new block
+        ssa_value* label = ssa_get_block_label(block);
+        ssa_instr* terminator = ssa_get_block_terminator(rest);
+        SSA_FOREACH_TERMINATOR_SUCCESSOR(terminator, succ, succ_end)
+        {
+                ssa_block* succ_block = ssa_get_label_block(ssa_get_value_use_value(succ));
+                SSA_FOREACH_BLOCK_INSTR(succ_block, instr)
+                {
+                        if (ssa_get_instr_kind(instr) != SIK_PHI)
+                                continue;
+
+                        for (size_t i = 1; i < ssa_get_instr_operands_size(instr); i += 2)
+                                if (ssa_get_instr_operand_value(instr, i) == label)
+                                        ssa_set_instr_operand_value(instr, i, ssa_get_block_label(rest));
+                }
+        }
+        return rest;
+}
+
+// Copies the blocks of the callee after the block of the call, the returns of the callee
+// become jumps to the rest of the block and their values are merged by a phi.
+static void ssa_inline_call(ssa_context* context, ssa_value* caller, ssa_instr* call, ssa_value* callee)
+{
+        ssa_block* block = ssa_get_instr_block(call);
+        ssa_block* rest = ssa_split_block_after(context, call);
+        ssa_value* rest_label = ssa_get_block_label(rest);
+
+        ssa_value** param = ssa_get_function_params_begin(callee);
+        for (size_t i = 1; i < ssa_get_instr_operands_size(call); i++)
+                ssa_set_value_metadata(*param++, ssa_get_instr_operand_value(call, i));
+
+        // instructions are created first, since operands may refer to the following ones
+        ssa_block* pos = block;
+        SSA_FOREACH_FUNCTION_BLOCK(callee, it)
+        {
+                ssa_block* copy = ssa_new_block(context, false);
+                ssa_set_value_metadata(ssa_get_block_label(it), ssa_get_block_label(copy));
+                ssa_add_block_after(copy, pos);
+                pos = copy;
+
+                SSA_FOREACH_BLOCK_INSTR(it, instr)
+                {
+                        ssa_instr* instr_copy = ssa_get_instr_kind(instr) == SIK_TERMINATOR
+                                && ssa_get_terminator_instr_kind(instr) == STIK_RETURN
+                                ? ssa_new_inderect_jump(context, rest_label)
+                                : ssa_clone_instr(context, instr);
+                        ssa_add_instr_before(instr_copy, ssa_get_block_instrs_end(copy));
+                        ssa_set_value_metadata(ssa_get_instr_var(instr), ssa_get_instr_var(instr_copy));
+                }
+        }
+
+        bool has_result = ssa_instr_has_var(call);
+        ssa_value* result = ssa_get_instr_var(call);
+        ssa_instr* phi = NULL;
+        if (has_result)
+        {
+                phi = ssa_new_phi(context, ssa_get_value_type(result));
+                ssa_add_instr_before(phi, ssa_get_block_instrs_begin(rest));
+        }
+
+        SSA_FOREACH_FUNCTION_BLOCK(callee, it)
+        {
+                ssa_value* label = ssa_get_value_metadata(ssa_get_block_label(it));
+                SSA_FOREACH_BLOCK_INSTR(it, instr)
+                {
+                        ssa_instr* instr_copy = ssa_get_var_instr(ssa_get_value_metadata(ssa_get_instr_var(instr)));
+                        if (ssa_get_instr_kind(instr) == SIK_TERMINATOR
+                                && ssa_get_terminator_instr_kind(instr) == STIK_RETURN)
+                        {
+                                if (!has_result)
+                                        continue;
+
+                                // return without a value from a function which has one
+                                ssa_value* value = ssa_get_instr_operands_size(instr)
+                                        ? ssa_get_inlined_value(ssa_get_instr_operand_value(instr, 0))
+                                        : ssa_new_undef(context, ssa_get_value_type(result));
+                                ssa_add_phi_operand(phi, context, value, label);
+                                continue;
+                        }
+
+                        SSA_FOREACH_INSTR_OPERAND(instr, op, end)
+                                ssa_add_instr_operand(instr_copy, context,
+                                        ssa_get_inlined_value(ssa_get_value_use_value(op)));
+                }
+        }
+
+        ssa_block* caller_entry = ssa_get_function_blocks_begin(caller);
+        ssa_instr* entry_begin = ssa_get_block_instrs_begin(caller_entry);
+        ssa_value* callee_entry = ssa_get_value_metadata(
+                ssa_get_block_label(ssa_get_function_blocks_begin(callee)));
+        ssa_clear_inlined_values(callee);
+
+        // locals of the callee are allocated once in the caller's frame, even if the call is in a loop
+        for (ssa_block* it = ssa_get_next_block(block); it != rest; it = ssa_get_next_block(it))
+                SSA_FOREACH_BLOCK_INSTR_SAFE(it, instr, next)
+                        if (ssa_get_instr_kind(instr) == SIK_ALLOCA)
+                                ssa_move_instr(instr, entry_begin, false);
+
+        if (has_result)
+        {
+                ssa_value* phi_var = ssa_get_instr_var(phi);
+                size_t num_returns = ssa_get_instr_operands_size(phi) / 2;
+                // a single return does not need a phi, a callee which never returns leaves the result undefined
+                ssa_value* value = num_returns == 1
+                        ? ssa_get_instr_operand_value(phi, 0)
+                        : num_returns ? phi_var : ssa_new_undef(context, ssa_get_value_type(result));
+                ssa_replace_value_with(result, value);
+                if (value != phi_var)
+                        ssa_remove_instr(phi);
+        }
+
+        ssa_remove_instr(call);
+        ssa_add_instr_before(ssa_new_inderect_jump(context, callee_entry), ssa_get_block_instrs_end(block));
+}
+
+static void ssa_inline_calls(ssa_context* context, ssa_value* func)
+{
+        struct vec calls;
+        vec_init(&calls);
+        size_t size = 0;
+        SSA_FOREACH_FUNCTION_BLOCK(func, block)
+                SSA_FOREACH_BLOCK_INSTR(block, instr)
+                {
+                        size++;
+                        // calls in transactions are instrumented after the optimization
+                        if (ssa_get_instr_kind(instr) == SIK_CALL && !ssa_block_is_atomic(block))
+                                vec_push(&calls, instr);
+                }
+
+        bool inlined = false;
+        VEC_FOREACH(&calls, it, end)
+        {
+                ssa_instr* call = *it;
+                ssa_value* callee = ssa_get_called_func(call);
+                if (ssa_get_value_kind(callee) != SVK_FUNCTION || callee == func)
+                        continue;
+
+                int cost = ssa_get_inline_cost(call, callee);
+                if (cost == INT_MAX || (int)size + cost > SSA_INLINE_MAX_FUNCTION_SIZE)
+                        continue;
+
+                ssa_inline_call(context, func, call, callee);
+                size += cost;
+                inlined = true;
+        }
+        vec_drop(&calls);
+
+        // the following passes identify values by their numbers
+        if (inlined)
+                ssa_number_function_values(func);
+}
+
+// Functions are visited in the module order, so a callee defined before its caller
+// is inlined together with the calls that were inlined into it.
 extern void ssa_inline_functions(const ssa_pass* pass)
 {
-        // todo
-}
\ No newline at end of file
+        SSA_FOREACH_MODULE_GLOBAL(pass->module, it, end)
+                if (ssa_get_value_kind(*it) == SVK_FUNCTION && ssa_function_has_body(*it))
+                        ssa_inline_calls(pass->context, *it);
+}
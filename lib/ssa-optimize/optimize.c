@@ -6,27 +6,46 @@ extern void ssa_reset_optimizer_opts(ssa_optimizer_opts* self)
         self->fold_constants = false;
         self->eliminate_dead_code = false;
         self->promote_allocas = false;
+        self->inline_functions = false;
+        self->propagate_constants = false;
+        self->eliminate_common_subexpressions = false;
 }
 
 extern void ssa_optimize(ssa_context* context,
         ssa_module* module, const ssa_optimizer_opts* opts)
 {
+        ssa_pass inl;
+        ssa_init_pass(&inl, SPK_MODULE, &ssa_inline_functions);
         ssa_pass cf;
         ssa_init_pass(&cf, SPK_FUNCTION, &ssa_fold_constants);
+        cf.preserves_cfg = true;
         ssa_pass dce;
         ssa_init_pass(&dce, SPK_FUNCTION, &ssa_eliminate_dead_code);
         ssa_pass pa;
         ssa_init_pass(&pa, SPK_FUNCTION, &ssa_promote_allocas);
+        pa.preserves_cfg = true;
+        ssa_pass sccp;
+        ssa_init_pass(&sccp, SPK_FUNCTION, &ssa_propagate_constants);
+        ssa_pass gvn;
+        ssa_init_pass(&gvn, SPK_FUNCTION, &ssa_eliminate_common_subexpressions);
+        gvn.preserves_cfg = true;
 
         ssa_pass_manager pm;
         ssa_init_pass_manager(&pm);
 
+        if (opts->inline_functions)
+                ssa_pass_manager_add_pass(&pm, &inl);
         if (opts->fold_constants)
                 ssa_pass_manager_add_pass(&pm, &cf);
         if (opts->eliminate_dead_code || opts->promote_allocas)
                 ssa_pass_manager_add_pass(&pm, &dce);
         if (opts->promote_allocas)
                 ssa_pass_manager_add_pass(&pm, &pa);
+        // removes the branches and blocks it proves dead, so it does not need dce after it
+        if (opts->propagate_constants)
+                ssa_pass_manager_add_pass(&pm, &sccp);
+        if (opts->eliminate_common_subexpressions)
+                ssa_pass_manager_add_pass(&pm, &gvn);
 
         ssa_pass_manager_run(&pm, context, module);
         ssa_number_module_values(module);
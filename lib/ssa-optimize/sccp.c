@@ -0,0 +1,478 @@
+#include "constant-fold.h"
+#include "scc/core/num.h"
+#include "scc/ssa-optimize/optimize.h"
+#include "scc/ssa/block.h"
+#include "scc/ssa/context.h"
+
+// Sparse conditional constant propagation.
+// Wegman, Zadeck. Constant Propagation with Conditional Branches.
+// Values start unknown and are lowered to a constant and then to overdefined,
+// blocks become executable when a feasible edge reaches them. Values whose lattice
+// changed are propagated to their users through the use lists.
+
+typedef enum
+{
+        SLK_UNKNOWN,
+        SLK_CONSTANT,
+        SLK_OVERDEFINED,
+} ssa_lattice_kind;
+
+typedef struct
+{
+        ssa_lattice_kind kind;
+        ssa_value* constant;
+} ssa_lattice_value;
+
+typedef struct
+{
+        ssa_context* context;
+        ssa_value* function;
+        // lattice values and executable flags of blocks, indexed by the id of the value or label
+        ssa_lattice_value* values;
+        bool* executable;
+        size_t num_ids;
+        struct vec block_worklist;
+        struct vec value_worklist;
+} ssa_sccp;
+
+static void ssa_init_sccp(ssa_sccp* self, ssa_context* context, ssa_value* func)
+{
+        self->context = context;
+        self->function = func;
+        vec_init(&self->block_worklist);
+        vec_init(&self->value_worklist);
+
+        // values are identified by their ids
+        ssa_number_function_values(func);
+        ssa_id max_id = 0;
+        SSA_FOREACH_FUNCTION_BLOCK(func, block)
+        {
+                ssa_id id = ssa_get_value_id(ssa_get_block_label(block));
+                if (id > max_id)
+                        max_id = id;
+                SSA_FOREACH_BLOCK_INSTR(block, instr)
+                        if (ssa_instr_has_var(instr) && ssa_get_value_id(ssa_get_instr_var(instr)) > max_id)
+                                max_id = ssa_get_value_id(ssa_get_instr_var(instr));
+        }
+
+        self->num_ids = max_id + 1;
+        self->values = alloc(sizeof(ssa_lattice_value) * self->num_ids);
+        self->executable = alloc(sizeof(bool) * self->num_ids);
+        for (size_t i = 0; i < self->num_ids; i++)
+        {
+                self->values[i].kind = SLK_UNKNOWN;
+                self->values[i].constant = NULL;
+                self->executable[i] = false;
+        }
+}
+
+static void ssa_dispose_sccp(ssa_sccp* self)
+{
+        vec_drop(&self->block_worklist);
+        vec_drop(&self->value_worklist);
+        dealloc(self->values);
+        dealloc(self->executable);
+}
+
+static bool ssa_block_is_executable(const ssa_sccp* self, ssa_block* block)
+{
+        return self->executable[ssa_get_value_id(ssa_get_block_label(block))];
+}
+
+static ssa_lattice_value ssa_get_lattice_value(const ssa_sccp* self, ssa_value* value)
+{
+        ssa_lattice_value v = { SLK_OVERDEFINED, NULL };
+        ssa_value_kind k = ssa_get_value_kind(value);
+        if (k == SVK_CONSTANT)
+        {
+                v.kind = SLK_CONSTANT;
+                v.constant = value;
+        }
+        else if (k == SVK_LOCAL_VAR)
+                v = self->values[ssa_get_value_id(value)];
+
+        // parameters, globals and undefined values are overdefined
+        return v;
+}
+
+static bool ssa_constants_are_equal(const ssa_value* a, const ssa_value* b)
+{
+        if (a == b)
+                return true;
+
+        const struct num* l = ssa_get_constant_cvalue(a);
+        const struct num* r = ssa_get_constant_cvalue(b);
+        // floating point constants are merged only if they are the same value, because of -0 and NaN
+        return l->kind == r->kind
+                && l->num_bits == r->num_bits
+                && l->kind != NUM_FLOAT
+                && num_cmp(l, r) == 0;
+}
+
+static ssa_lattice_value ssa_meet(ssa_lattice_value a, ssa_lattice_value b)
+{
+        if (a.kind == SLK_UNKNOWN)
+                return b;
+        if (b.kind == SLK_UNKNOWN)
+                return a;
+        if (a.kind == SLK_CONSTANT && b.kind == SLK_CONSTANT
+                && ssa_constants_are_equal(a.constant, b.constant))
+        {
+                return a;
+        }
+
+        ssa_lattice_value overdefined = { SLK_OVERDEFINED, NULL };
+        return overdefined;
+}
+
+static void ssa_set_lattice_value(ssa_sccp* self, ssa_value* var, ssa_lattice_value v)
+{
+        ssa_lattice_value* old = self->values + ssa_get_value_id(var);
+        // a value can only be lowered
+        if (old->kind == v.kind)
+                return;
+
+        assert(old->kind < v.kind);
+        *old = v;
+        vec_push(&self->value_worklist, var);
+}
+
+// returns the successor taken by the terminator, NULL if none is known yet,
+// or the terminator itself if any of them can be taken
+static void* ssa_get_feasible_successor(ssa_sccp* self, ssa_instr* terminator)
+{
+        ssa_terminator_instr_kind k = ssa_get_terminator_instr_kind(terminator);
+        if (k == STIK_INDERECT_JUMP)
+                return ssa_get_instr_operand_value(terminator, 0);
+        if (k != STIK_CONDITIONAL_JUMP && k != STIK_SWITCH)
+                return terminator;
+
+        ssa_lattice_value cond = ssa_get_lattice_value(self, ssa_get_instr_operand_value(terminator, 0));
+        if (cond.kind == SLK_UNKNOWN)
+                return NULL;
+        if (cond.kind == SLK_OVERDEFINED)
+                return terminator;
+
+        const struct num* cond_val = ssa_get_constant_cvalue(cond.constant);
+        if (k == STIK_CONDITIONAL_JUMP)
+                return ssa_get_instr_operand_value(terminator, num_is_zero(cond_val) ? 2 : 1);
+
+        for (size_t i = 2; i < ssa_get_instr_operands_size(terminator); i += 2)
+        {
+                const struct num* case_val = ssa_get_constant_cvalue(ssa_get_instr_operand_value(terminator, i));
+                if (case_val->kind == cond_val->kind && num_cmp(case_val, cond_val) == 0)
+                        return ssa_get_instr_operand_value(terminator, i + 1);
+        }
+        return ssa_get_instr_operand_value(terminator, 1);
+}
+
+static bool ssa_edge_is_feasible(ssa_sccp* self, ssa_block* from, ssa_value* to)
+{
+        if (!ssa_block_is_executable(self, from))
+                return false;
+
+        ssa_instr* terminator = ssa_get_block_terminator(from);
+        void* succ = ssa_get_feasible_successor(self, terminator);
+        return succ == terminator || succ == to;
+}
+
+static void ssa_visit_phi(ssa_sccp* self, ssa_instr* phi)
+{
+        ssa_value* label = ssa_get_block_label(ssa_get_instr_block(phi));
+        ssa_lattice_value v = { SLK_UNKNOWN, NULL };
+        for (size_t i = 0; i < ssa_get_instr_operands_size(phi); i += 2)
+        {
+                ssa_block* pred = ssa_get_label_block(ssa_get_instr_operand_value(phi, i + 1));
+                if (!ssa_edge_is_feasible(self, pred, label))
+                        continue;
+
+                v = ssa_meet(v, ssa_get_lattice_value(self, ssa_get_instr_operand_value(phi, i)));
+                if (v.kind == SLK_OVERDEFINED)
+                        break;
+        }
+        ssa_set_lattice_value(self, ssa_get_instr_var(phi), v);
+}
+
+static void ssa_visit_successor(ssa_sccp* self, ssa_value* label)
+{
+        ssa_block* block = ssa_get_label_block(label);
+        if (!ssa_block_is_executable(self, block))
+        {
+                self->executable[ssa_get_value_id(label)] = true;
+                vec_push(&self->block_worklist, block);
+                return;
+        }
+
+        // the new edge may add an operand to phis
+        SSA_FOREACH_BLOCK_INSTR(block, instr)
+                if (ssa_get_instr_kind(instr) == SIK_PHI)
+                        ssa_visit_phi(self, instr);
+}
+
+static void ssa_visit_terminator(ssa_sccp* self, ssa_instr* terminator)
+{
+        void* succ = ssa_get_feasible_successor(self, terminator);
+        if (!succ)
+                return;
+        if (succ != terminator)
+        {
+                ssa_visit_successor(self, succ);
+                return;
+        }
+
+        SSA_FOREACH_TERMINATOR_SUCCESSOR(terminator, it, end)
+                ssa_visit_successor(self, ssa_get_value_use_value(it));
+}
+
+static ssa_lattice_value ssa_evaluate_instr(ssa_sccp* self, ssa_instr* instr)
+{
+        ssa_lattice_value v = { SLK_OVERDEFINED, NULL };
+        ssa_instr_kind k = ssa_get_instr_kind(instr);
+        if (k != SIK_BINARY && k != SIK_CAST)
+                return v;
+
+        ssa_lattice_value ops[2];
+        for (size_t i = 0; i < ssa_get_instr_operands_size(instr); i++)
+        {
+                ops[i] = ssa_get_lattice_value(self, ssa_get_instr_operand_value(instr, i));
+                if (ops[i].kind == SLK_OVERDEFINED)
+                        return ops[i];
+                if (ops[i].kind == SLK_UNKNOWN)
+                        v.kind = SLK_UNKNOWN;
+        }
+        if (v.kind == SLK_UNKNOWN)
+                return v;
+
+        v.constant = k == SIK_BINARY
+                ? ssa_fold_binop(self->context, instr, ops[0].constant, ops[1].constant)
+                : ssa_fold_cast(self->context, instr, ops[0].constant);
+        if (v.constant)
+                v.kind = SLK_CONSTANT;
+        return v;
+}
+
+static void ssa_visit_instr(ssa_sccp* self, ssa_instr* instr)
+{
+        ssa_instr_kind k = ssa_get_instr_kind(instr);
+        if (k == SIK_TERMINATOR)
+                ssa_visit_terminator(self, instr);
+        else if (k == SIK_PHI)
+                ssa_visit_phi(self, instr);
+        else if (ssa_instr_has_var(instr))
+                ssa_set_lattice_value(self, ssa_get_instr_var(instr), ssa_evaluate_instr(self, instr));
+}
+
+static void ssa_sccp_solve(ssa_sccp* self)
+{
+        while (self->block_worklist.size || self->value_worklist.size)
+        {
+                while (self->value_worklist.size)
+                {
+                        ssa_value* value = vec_pop(&self->value_worklist);
+                        SSA_FOREACH_VALUE_USE(value, use, end)
+                        {
+                                ssa_instr* instr = ssa_get_value_use_instr(use);
+                                if (ssa_block_is_executable(self, ssa_get_instr_block(instr)))
+                                        ssa_visit_instr(self, instr);
+                        }
+                }
+
+                if (self->block_worklist.size)
+                {
+                        ssa_block* block = vec_pop(&self->block_worklist);
+                        SSA_FOREACH_BLOCK_INSTR(block, instr)
+                                ssa_visit_instr(self, instr);
+                }
+        }
+}
+
+// A branch on a value which stays unknown (e.g. a phi of itself) has no feasible successors,
+// such conditions are made overdefined until every executable block has somewhere to go.
+static bool ssa_resolve_unknown_branches(ssa_sccp* self)
+{
+        bool resolved = false;
+        SSA_FOREACH_FUNCTION_BLOCK(self->function, block)
+        {
+                if (!ssa_block_is_executable(self, block))
+                        continue;
+
+                ssa_instr* terminator = ssa_get_block_terminator(block);
+                if (ssa_get_feasible_successor(self, terminator))
+                        continue;
+
+                ssa_lattice_value overdefined = { SLK_OVERDEFINED, NULL };
+                ssa_set_lattice_value(self, ssa_get_instr_operand_value(terminator, 0), overdefined);
+                resolved = true;
+        }
+        return resolved;
+}
+
+static void ssa_replace_constants(ssa_sccp* self)
+{
+        SSA_FOREACH_FUNCTION_BLOCK(self->function, block)
+        {
+                if (!ssa_block_is_executable(self, block))
+                        continue;
+
+                SSA_FOREACH_BLOCK_INSTR_SAFE(block, instr, next)
+                {
+                        ssa_instr_kind k = ssa_get_instr_kind(instr);
+                        if (k != SIK_BINARY && k != SIK_CAST && k != SIK_PHI)
+                                continue;
+
+                        ssa_value* var = ssa_get_instr_var(instr);
+                        ssa_lattice_value v = ssa_get_lattice_value(self, var);
+                        if (v.kind != SLK_CONSTANT)
+                                continue;
+
+                        ssa_replace_value_with(var, v.constant);
+                        ssa_remove_instr(instr);
+                }
+        }
+}
+
+// the phis of the successors which lose an edge are updated later
+static void ssa_mark_successors(ssa_instr* terminator, struct vec* blocks)
+{
+        SSA_FOREACH_TERMINATOR_SUCCESSOR(terminator, it, end)
+                vec_push(blocks, ssa_get_label_block(ssa_get_value_use_value(it)));
+}
+
+static void ssa_replace_constant_branches(ssa_sccp* self, struct vec* changed_blocks)
+{
+        SSA_FOREACH_FUNCTION_BLOCK(self->function, block)
+        {
+                if (!ssa_block_is_executable(self, block))
+                        continue;
+
+                ssa_instr* terminator = ssa_get_block_terminator(block);
+                void* succ = ssa_get_feasible_successor(self, terminator);
+                ssa_terminator_instr_kind k = ssa_get_terminator_instr_kind(terminator);
+                if (succ == terminator || k == STIK_INDERECT_JUMP)
+                        continue;
+
+                ssa_mark_successors(terminator, changed_blocks);
+                ssa_add_instr_after(ssa_new_inderect_jump(self->context, succ), terminator);
+                ssa_remove_instr(terminator);
+        }
+}
+
+static void ssa_remove_unexecutable_blocks(ssa_sccp* self, struct vec* changed_blocks)
+{
+        SSA_FOREACH_FUNCTION_BLOCK(self->function, block)
+        {
+                if (ssa_block_is_executable(self, block))
+                        continue;
+
+                ssa_mark_successors(ssa_get_block_terminator(block), changed_blocks);
+                SSA_FOREACH_BLOCK_INSTR(block, instr)
+                {
+                        if (!ssa_instr_has_var(instr))
+                                continue;
+
+                        ssa_value* var = ssa_get_instr_var(instr);
+                        if (ssa_value_is_used(var))
+                                ssa_replace_value_with(var, ssa_new_undef(self->context, ssa_get_value_type(var)));
+                }
+        }
+
+        SSA_FOREACH_FUNCTION_BLOCK(self->function, block)
+                if (!ssa_block_is_executable(self, block))
+                        SSA_FOREACH_BLOCK_INSTR_SAFE(block, instr, next)
+                                ssa_remove_instr(instr);
+}
+
+// Leaves an operand in the phis of the block for each edge still coming to it.
+// Numbers of edges from the predecessors are counted in the metadata of their labels.
+static void ssa_update_phis(ssa_sccp* self, ssa_block* block)
+{
+        ssa_value* label = ssa_get_block_label(block);
+        SSA_FOREACH_BLOCK_INSTR_SAFE(block, phi, next)
+        {
+                if (ssa_get_instr_kind(phi) != SIK_PHI)
+                        break;
+
+                SSA_FOREACH_VALUE_USE(label, use, end)
+                {
+                        ssa_instr* instr = ssa_get_value_use_instr(use);
+                        if (ssa_get_instr_kind(instr) != SIK_TERMINATOR)
+                                continue;
+
+                        ssa_value* pred = ssa_get_block_label(ssa_get_instr_block(instr));
+                        ssa_set_value_metadata(pred, (void*)((size_t)ssa_get_value_metadata(pred) + 1));
+                }
+
+                ssa_value* var = ssa_get_instr_var(phi);
+                ssa_instr* updated = ssa_new_phi(self->context, ssa_get_value_type(var));
+                for (size_t i = 0; i < ssa_get_instr_operands_size(phi); i += 2)
+                {
+                        ssa_value* pred = ssa_get_instr_operand_value(phi, i + 1);
+                        size_t num_edges = (size_t)ssa_get_value_metadata(pred);
+                        if (!num_edges)
+                                continue;
+
+                        ssa_set_value_metadata(pred, (void*)(num_edges - 1));
+                        ssa_add_phi_operand(updated, self->context, ssa_get_instr_operand_value(phi, i), pred);
+                }
+
+                SSA_FOREACH_VALUE_USE(label, use, end)
+                {
+                        ssa_instr* instr = ssa_get_value_use_instr(use);
+                        if (ssa_get_instr_kind(instr) == SIK_TERMINATOR)
+                                ssa_set_value_metadata(ssa_get_block_label(ssa_get_instr_block(instr)), NULL);
+                }
+
+                // a phi with one operand is the operand itself
+                ssa_value* value = ssa_get_instr_var(updated);
+                if (ssa_get_instr_operands_size(updated) == 2)
+                        value = ssa_get_instr_operand_value(updated, 0);
+                else
+                        ssa_add_instr_before(updated, phi);
+
+                ssa_replace_value_with(var, value);
+                ssa_remove_instr(phi);
+                if (value != ssa_get_instr_var(updated))
+                        ssa_remove_instr(updated);
+        }
+}
+
+extern void ssa_propagate_constants(const ssa_pass* pass)
+{
+        if (!ssa_function_has_body(pass->function))
+                return;
+
+        ssa_sccp sccp;
+        ssa_init_sccp(&sccp, pass->context, pass->function);
+
+        ssa_block* entry = ssa_get_function_blocks_begin(pass->function);
+        sccp.executable[ssa_get_value_id(ssa_get_block_label(entry))] = true;
+        vec_push(&sccp.block_worklist, entry);
+        do
+                ssa_sccp_solve(&sccp);
+        while (ssa_resolve_unknown_branches(&sccp));
+
+        struct vec changed_blocks;
+        vec_init(&changed_blocks);
+        ssa_replace_constants(&sccp);
+        ssa_replace_constant_branches(&sccp, &changed_blocks);
+        ssa_remove_unexecutable_blocks(&sccp, &changed_blocks);
+
+        VEC_FOREACH(&changed_blocks, it, end)
+        {
+                ssa_block* block = *it;
+                if (ssa_block_is_executable(&sccp, block))
+                        ssa_update_phis(&sccp, block);
+        }
+        vec_drop(&changed_blocks);
+
+        SSA_FOREACH_FUNCTION_BLOCK(pass->function, block)
+        {
+                ssa_block* prev = ssa_get_prev_block(block);
+                if (!ssa_block_is_executable(&sccp, block))
+                {
+                        ssa_remove_block(block);
+                        block = prev;
+                }
+        }
+        ssa_dispose_sccp(&sccp);
+}
@@ -135,7 +135,7 @@ static inline ssa_value* ssa_build_cmp_binop(
         assert(tree_type_is_scalar(lt) && tree_type_is_scalar(rt));
 
         return ssa_build_binop(self, opcode,
-                tree_new_builtin_type(ssa_get_tree(self->context), TBTK_INT32), lhs, rhs);
+                tree_get_builtin_type(ssa_get_tree(self->context), TBTK_INT32), lhs, rhs);
 }
 
 extern ssa_value* ssa_build_le(ssa_builder* self, ssa_value* lhs, ssa_value* rhs)
@@ -197,8 +197,8 @@ extern ssa_value* ssa_build_cast_ex(ssa_builder* self, ssa_instr* pos, tree_type
 
 extern ssa_value* ssa_build_cast_to_pvoid(ssa_builder* self, ssa_value* operand)
 {
-        tree_type* pvoid = tree_new_pointer_type(self->context->tree,
-                tree_new_builtin_type(self->context->tree, TBTK_VOID));
+        tree_type* pvoid = tree_get_pointer_type(self->context->tree,
+                tree_get_builtin_type(self->context->tree, TBTK_VOID));
         return ssa_build_cast(self, pvoid, operand);
 }
 
@@ -266,7 +266,7 @@ extern ssa_value* ssa_build_alloca(ssa_builder* self, tree_type* type, unsigned
 extern ssa_value* ssa_build_alloca_ex(
         ssa_builder* self, ssa_instr* pos, tree_type* type, unsigned align, bool insert_after)
 {
-        tree_type* p = tree_new_pointer_type(ssa_get_tree(self->context), type);
+        tree_type* p = tree_get_pointer_type(ssa_get_tree(self->context), type);
         if (!p)
                 return NULL;
 
@@ -314,7 +314,7 @@ extern ssa_value* ssa_build_getfieldaddr(
                         tree_get_pointer_target(ssa_get_value_type(record)))));
         assert(!tree_record_is_union(record_decl));
   
-        tree_type* field_ptr = tree_new_pointer_type(
+        tree_type* field_ptr = tree_get_pointer_type(
                 ssa_get_tree(self->context), tree_get_decl_type(field));
 
         ssa_instr* i = ssa_new_getfieldaddr(
@@ -354,7 +354,7 @@ extern ssa_value* ssa_build_int_constant(ssa_builder* self, tree_type* type, uin
 
 extern ssa_value* ssa_build_i32_constant(ssa_builder* self, int val)
 {
-        tree_type* i32 = tree_new_builtin_type(ssa_get_tree(self->context), TBTK_INT32);
+        tree_type* i32 = tree_get_builtin_type(ssa_get_tree(self->context), TBTK_INT32);
         if (!i32)
                 return NULL;
 
@@ -363,7 +363,7 @@ extern ssa_value* ssa_build_i32_constant(ssa_builder* self, int val)
 
 extern ssa_value* ssa_build_u32_constant(ssa_builder* self, unsigned val)
 {
-        tree_type* u32 = tree_new_builtin_type(ssa_get_tree(self->context), TBTK_UINT32);
+        tree_type* u32 = tree_get_builtin_type(ssa_get_tree(self->context), TBTK_UINT32);
         if (!u32)
                 return NULL;
 
@@ -0,0 +1,321 @@
+#include "scc/ssa/cfg.h"
+#include "scc/ssa/block.h"
+#include "scc/ssa/instr.h"
+#include "scc/ssa/value.h"
+
+static ssa_value_use* ssa_get_block_successors_begin(ssa_block* block)
+{
+        ssa_instr* terminator = ssa_get_block_terminator(block);
+        return terminator && ssa_get_instr_kind(terminator) == SIK_TERMINATOR
+                ? ssa_get_terminator_instr_successors_begin(terminator)
+                : NULL;
+}
+
+// returns blocks reachable from the entry in the postorder
+static void ssa_cfg_collect_blocks(ssa_cfg* self, struct vec* postorder)
+{
+        struct vec blocks;
+        struct vec succs;
+        vec_init(&blocks);
+        vec_init(&succs);
+
+        ssa_block* entry = ssa_get_function_blocks_begin(self->function);
+        ssa_cfg_node_map_insert(&self->map, entry, NULL);
+        vec_push(&blocks, entry);
+        vec_push(&succs, ssa_get_block_successors_begin(entry));
+        while (blocks.size)
+        {
+                ssa_block* block = vec_last(&blocks);
+                ssa_value_use** succ = (ssa_value_use**)vec_last_ptr(&succs);
+                ssa_instr* terminator = ssa_get_block_terminator(block);
+                if (!*succ || *succ >= ssa_get_instr_operands_end(terminator))
+                {
+                        vec_pop(&blocks);
+                        vec_pop(&succs);
+                        vec_push(postorder, block);
+                        continue;
+                }
+
+                ssa_block* succ_block = ssa_get_label_block(ssa_get_value_use_value(*succ));
+                *succ = ssa_get_next_terminator_successor(terminator, *succ);
+                if (ssa_cfg_node_map_has(&self->map, succ_block))
+                        continue;
+
+                ssa_cfg_node_map_insert(&self->map, succ_block, NULL);
+                vec_push(&blocks, succ_block);
+                vec_push(&succs, ssa_get_block_successors_begin(succ_block));
+        }
+
+        vec_drop(&blocks);
+        vec_drop(&succs);
+}
+
+static void ssa_cfg_build_nodes(ssa_cfg* self)
+{
+        struct vec postorder;
+        vec_init(&postorder);
+        ssa_cfg_collect_blocks(self, &postorder);
+
+        self->num_nodes = postorder.size;
+        self->nodes = alloc(sizeof(ssa_cfg_node) * self->num_nodes);
+        for (size_t i = 0; i < self->num_nodes; i++)
+        {
+                ssa_cfg_node* node = self->nodes + i;
+                node->block = postorder.items[self->num_nodes - i - 1];
+                node->index = (unsigned)i;
+                node->idom = NULL;
+                node->dom_begin = 0;
+                node->dom_end = 0;
+                node->loop = NULL;
+                vec_init(&node->preds);
+                vec_init(&node->succs);
+                vec_init(&node->children);
+                vec_init(&node->frontier);
+                ssa_cfg_node_map_update(&self->map, node->block, node);
+        }
+        vec_drop(&postorder);
+
+        SSA_FOREACH_CFG_NODE(self, node)
+        {
+                ssa_value_use* begin = ssa_get_block_successors_begin(node->block);
+                if (!begin)
+                        continue;
+
+                ssa_instr* terminator = ssa_get_block_terminator(node->block);
+                for (ssa_value_use* it = begin; it < ssa_get_instr_operands_end(terminator);
+                        it = ssa_get_next_terminator_successor(terminator, it))
+                {
+                        ssa_cfg_node* succ = ssa_get_cfg_node(self,
+                                ssa_get_label_block(ssa_get_value_use_value(it)));
+                        // several successors of a switch may be the same block
+                        if (succ->preds.size && vec_last(&succ->preds) == node)
+                                continue;
+
+                        vec_push(&node->succs, succ);
+                        vec_push(&succ->preds, node);
+                }
+        }
+}
+
+static ssa_cfg_node* ssa_intersect_dominators(ssa_cfg_node* a, ssa_cfg_node* b)
+{
+        while (a != b)
+        {
+                while (a->index > b->index)
+                        a = a->idom;
+                while (b->index > a->index)
+                        b = b->idom;
+        }
+        return a;
+}
+
+// Cooper, Harvey, Kennedy. A Simple, Fast Dominance Algorithm.
+static void ssa_cfg_build_dominators(ssa_cfg* self)
+{
+        ssa_cfg_node* entry = ssa_get_cfg_entry(self);
+        entry->idom = entry;
+
+        bool changed = true;
+        while (changed)
+        {
+                changed = false;
+                for (ssa_cfg_node* node = entry + 1; node != ssa_get_cfg_nodes_end(self); node++)
+                {
+                        ssa_cfg_node* idom = NULL;
+                        SSA_FOREACH_CFG_NODE_PRED(node, it, end)
+                        {
+                                if (!(*it)->idom)
+                                        continue;
+                                idom = idom ? ssa_intersect_dominators(*it, idom) : *it;
+                        }
+
+                        assert(idom);
+                        if (node->idom != idom)
+                        {
+                                node->idom = idom;
+                                changed = true;
+                        }
+                }
+        }
+        entry->idom = NULL;
+
+        for (ssa_cfg_node* node = entry + 1; node != ssa_get_cfg_nodes_end(self); node++)
+                vec_push(&node->idom->children, node);
+
+        // a node follows its dominators in the reverse postorder, so sizes of the subtrees
+        // are summed up backwards, then each node gives consecutive ranges to its children
+        SSA_FOREACH_CFG_NODE_REVERSE(self, node)
+        {
+                node->dom_end++;
+                if (node->idom)
+                        node->idom->dom_end += node->dom_end;
+        }
+        SSA_FOREACH_CFG_NODE(self, node)
+        {
+                unsigned pos = node->dom_begin + 1;
+                node->dom_end += node->dom_begin;
+                SSA_FOREACH_CFG_NODE_CHILD(node, it, end)
+                {
+                        (*it)->dom_begin = pos;
+                        pos += (*it)->dom_end;
+                }
+        }
+}
+
+static void ssa_cfg_build_frontiers(ssa_cfg* self)
+{
+        SSA_FOREACH_CFG_NODE(self, node)
+        {
+                if (node->preds.size < 2)
+                        continue;
+
+                SSA_FOREACH_CFG_NODE_PRED(node, it, end)
+                        for (ssa_cfg_node* runner = *it; runner != node->idom; runner = runner->idom)
+                        {
+                                if (runner->frontier.size && vec_last(&runner->frontier) == node)
+                                        break;
+                                vec_push(&runner->frontier, node);
+                        }
+        }
+}
+
+static ssa_loop* ssa_get_outermost_loop(ssa_loop* loop)
+{
+        while (loop->parent)
+                loop = loop->parent;
+        return loop;
+}
+
+// Inner loops have headers later in the reverse postorder, so they are found first
+// and the walk over the body of an outer loop jumps over them through their headers.
+static void ssa_cfg_build_loops(ssa_cfg* self)
+{
+        struct vec worklist;
+        vec_init(&worklist);
+
+        SSA_FOREACH_CFG_NODE_REVERSE(self, header)
+        {
+                SSA_FOREACH_CFG_NODE_PRED(header, it, end)
+                        if (ssa_cfg_node_dominates(header, *it))
+                                vec_push(&worklist, *it);
+                if (!worklist.size)
+                        continue;
+
+                ssa_loop* loop = alloc(sizeof(ssa_loop));
+                loop->header = header;
+                loop->parent = NULL;
+                loop->depth = 0;
+                vec_push(&self->loops, loop);
+                header->loop = loop;
+
+                while (worklist.size)
+                {
+                        ssa_cfg_node* node = vec_pop(&worklist);
+                        if (node->loop == loop)
+                                continue;
+
+                        if (node->loop)
+                        {
+                                ssa_loop* inner = ssa_get_outermost_loop(node->loop);
+                                if (inner == loop)
+                                        continue;
+
+                                inner->parent = loop;
+                                node = inner->header;
+                        }
+                        else
+                                node->loop = loop;
+
+                        SSA_FOREACH_CFG_NODE_PRED(node, it, end)
+                                vec_push(&worklist, *it);
+                }
+        }
+
+        VEC_FOREACH(&self->loops, it, end)
+        {
+                ssa_loop* loop = *it;
+                for (ssa_loop* l = loop; l; l = l->parent)
+                        loop->depth++;
+        }
+        vec_drop(&worklist);
+}
+
+extern ssa_cfg* ssa_new_cfg(ssa_value* function)
+{
+        assert(ssa_function_has_body(function));
+        ssa_cfg* self = alloc(sizeof(ssa_cfg));
+        self->function = function;
+        self->nodes = NULL;
+        self->num_nodes = 0;
+        vec_init(&self->loops);
+        ssa_cfg_node_map_init(&self->map);
+
+        ssa_cfg_build_nodes(self);
+        ssa_cfg_build_dominators(self);
+        ssa_cfg_build_frontiers(self);
+        ssa_cfg_build_loops(self);
+        return self;
+}
+
+extern void ssa_delete_cfg(ssa_cfg* self)
+{
+        SSA_FOREACH_CFG_NODE(self, node)
+        {
+                vec_drop(&node->preds);
+                vec_drop(&node->succs);
+                vec_drop(&node->children);
+                vec_drop(&node->frontier);
+        }
+        VEC_FOREACH(&self->loops, it, end)
+                dealloc(*it);
+
+        vec_drop(&self->loops);
+        ssa_cfg_node_map_drop(&self->map);
+        dealloc(self->nodes);
+        dealloc(self);
+}
+
+extern ssa_cfg_node* ssa_get_cfg_node(const ssa_cfg* self, const ssa_block* block)
+{
+        struct ssa_cfg_node_map_entry* e = ssa_cfg_node_map_lookup(&self->map, block);
+        return e ? e->value : NULL;
+}
+
+extern bool ssa_cfg_node_dominates(const ssa_cfg_node* self, const ssa_cfg_node* other)
+{
+        return self->dom_begin <= other->dom_begin && other->dom_begin < self->dom_end;
+}
+
+extern bool ssa_block_dominates(const ssa_cfg* self, const ssa_block* block, const ssa_block* other)
+{
+        ssa_cfg_node* a = ssa_get_cfg_node(self, block);
+        ssa_cfg_node* b = ssa_get_cfg_node(self, other);
+        // everything dominates an unreachable block
+        return !b || (a && ssa_cfg_node_dominates(a, b));
+}
+
+extern bool ssa_loop_contains(const ssa_loop* self, const ssa_cfg_node* node)
+{
+        for (const ssa_loop* loop = node->loop; loop; loop = loop->parent)
+                if (loop == self)
+                        return true;
+        return false;
+}
+
+extern ssa_cfg* ssa_get_function_cfg(ssa_value* function)
+{
+        struct _ssa_function* f = _ssa_function(function);
+        if (!f->cfg)
+                f->cfg = ssa_new_cfg(function);
+        return f->cfg;
+}
+
+extern void ssa_invalidate_function_cfg(ssa_value* function)
+{
+        struct _ssa_function* f = _ssa_function(function);
+        if (!f->cfg)
+                return;
+
+        ssa_delete_cfg(f->cfg);
+        f->cfg = NULL;
+}
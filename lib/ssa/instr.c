@@ -1,5 +1,6 @@
 #include "scc/ssa/instr.h"
 #include "scc/ssa/context.h"
+#include <string.h>
 
 extern void _ssa_init_instr_node(struct _ssa_instr_node* self, ssa_block* block)
 {
@@ -43,6 +44,8 @@ extern ssa_instr* ssa_new_instr(
 
         ssa_array* ops = &_ssa_instr_base(instr)->operands;
         ssa_init_array(ops);
+        if (EC_FAILED(ssa_reserve_array(context, ops, sizeof(ssa_value_use), reserved_operands)))
+                return NULL;
 
         _ssa_init_instr_node(_ssa_instr_node(instr), NULL);
         return instr;
@@ -91,20 +94,27 @@ extern ssa_value_use* ssa_add_instr_operand(ssa_instr* self, ssa_context* contex
 {
         assert(value);
         ssa_array* ops = &_ssa_instr_base(self)->operands;
-        ssa_array new_ops;
-        ssa_init_array(&new_ops);
-        ssa_resize_array(context, &new_ops, sizeof(ssa_value_use), ops->size + 1);
-        for (size_t i = 0; i < ops->size; i++)
+        if (ops->size == ops->capacity)
         {
-                ssa_value_use* op = (ssa_value_use*)ops->data + i;
-                ssa_value_use* new_op = (ssa_value_use*)new_ops.data + i;
-                *new_op = *op;
-                op->node.prev->next = &new_op->node;
-                op->node.next->prev = &new_op->node;
+                // operands are linked into use lists of their values,
+                // so they have to be relinked when moved
+                ssa_array new_ops;
+                ssa_init_array(&new_ops);
+                ssa_reserve_array(context, &new_ops, sizeof(ssa_value_use), ops->size * 2 + 1);
+                for (size_t i = 0; i < ops->size; i++)
+                {
+                        ssa_value_use* op = (ssa_value_use*)ops->data + i;
+                        ssa_value_use* new_op = (ssa_value_use*)new_ops.data + i;
+                        *new_op = *op;
+                        op->node.prev->next = &new_op->node;
+                        op->node.next->prev = &new_op->node;
+                }
+                new_ops.size = ops->size;
+                ssa_dispose_array(context, ops);
+                *ops = new_ops;
         }
-        ssa_dispose_array(context, ops);
-        *ops = new_ops;
-        
+        ops->size++;
+
         ssa_value_use* last = (ssa_value_use*)ops->data + ops->size - 1;
         ssa_init_value_use(last, self);
         _ssa_add_value_use(value, last);
@@ -197,6 +207,43 @@ extern void ssa_set_instr_operand_value(ssa_instr* self, size_t i, ssa_value* va
         ssa_set_value_use_value(ssa_get_instr_operand(self, i), val);
 }
 
+static size_t ssa_get_instr_size(ssa_instr_kind kind)
+{
+        switch (kind)
+        {
+                case SIK_ALLOCA: return sizeof(struct _ssa_alloca);
+                case SIK_LOAD: return sizeof(struct _ssa_load);
+                case SIK_CAST: return sizeof(struct _ssa_cast);
+                case SIK_BINARY: return sizeof(struct _ssa_binop);
+                case SIK_STORE: return sizeof(struct _ssa_store);
+                case SIK_GETFIELDADDR: return sizeof(struct _ssa_getfieldaddr);
+                case SIK_CALL: return sizeof(struct _ssa_call);
+                case SIK_PHI: return sizeof(struct _ssa_phi);
+                case SIK_TERMINATOR: return sizeof(struct _ssa_terminator_instr);
+                case SIK_ATOMIC_RMW: return sizeof(struct _ssa_atomic_rmw_instr);
+                case SIK_FENCE: return sizeof(struct _ssa_fence_instr);
+                case SIK_ATOMIC_CMPXCHG: return sizeof(struct _ssa_atomic_cmpxchg_instr);
+                default:
+                        UNREACHABLE();
+                        return 0;
+        }
+}
+
+extern ssa_instr* ssa_clone_instr(ssa_context* context, const ssa_instr* self)
+{
+        ssa_instr_kind kind = ssa_get_instr_kind(self);
+        size_t size = ssa_get_instr_size(kind);
+        ssa_instr* clone = ssa_new_instr(context, kind,
+                ssa_get_value_type(ssa_get_instr_cvar(self)), ssa_get_instr_operands_size(self), size);
+        if (!clone)
+                return NULL;
+
+        // copy the fields of the particular kind, which follow the base
+        size_t base = sizeof(struct _ssa_instr_base);
+        memcpy((char*)clone + base, (const char*)self + base, size - base);
+        return clone;
+}
+
 extern ssa_instr* ssa_new_alloca(ssa_context* context, tree_type* type, unsigned align)
 {
         ssa_instr* i = ssa_new_instr(context, SIK_ALLOCA, type, 0, sizeof(struct _ssa_alloca));
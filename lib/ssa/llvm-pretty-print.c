@@ -46,6 +46,39 @@ static void ssa_print_func_type_params(ssa_printer* self, const tree_type* type)
         ssa_printc(self, ')');
 }
 
+// Records are printed as packed structs with explicit padding members,
+// so the index of a field in the printed type can differ from its index in the record.
+static uint ssa_get_llvm_field_index(ssa_printer* self, const tree_type* rec_ptr, uint index)
+{
+        const tree_decl* rec = tree_get_decl_type_entity(
+                tree_desugar_type_c(tree_get_pointer_target(rec_ptr)));
+        if (tree_record_is_union(rec))
+                return index;
+
+        struct ssa_fieldmap_entry* e = ssa_fieldmap_lookup(&self->llvm.field_indices, rec);
+        if (e)
+                return e->value[index];
+
+        const tree_target_info* target = self->context->target;
+        uint* indices = alloc(sizeof(uint) * (tree_count_record_fields(rec) + 1));
+        uint i = 0;
+        uint llvm_index = 0;
+        size_t end = 0;
+        TREE_FOREACH_DECL_IN_SCOPE(tree_get_record_cfields(rec), field)
+        {
+                if (!tree_decl_is(field, TDK_FIELD))
+                        continue;
+
+                size_t offset = tree_get_offsetof(target, field);
+                if (offset > end)
+                        llvm_index++;
+                indices[i++] = llvm_index++;
+                end = offset + tree_get_sizeof(target, tree_get_decl_type(field));
+        }
+        ssa_fieldmap_insert(&self->llvm.field_indices, rec, indices);
+        return indices[index];
+}
+
 static void ssa_print_record_name(ssa_printer* self, const tree_decl* rec)
 {
         ssa_prints(self, "%record.");
@@ -402,7 +435,8 @@ static void ssa_print_getfieldaddr_instr(ssa_printer* self, const ssa_instr* ins
         ssa_print_type(self, tree_get_pointer_target(ssa_get_value_type(rec)));
         ssa_prints(self, ", ");
         ssa_print_value(self, rec, true);
-        ssa_printf(self, ", i32 0, i32 %u", ssa_get_getfieldaddr_index(instr));
+        ssa_printf(self, ", i32 0, i32 %u", ssa_get_llvm_field_index(self,
+                ssa_get_value_type(rec), ssa_get_getfieldaddr_index(instr)));
 }
 
 
@@ -667,21 +701,42 @@ extern void ssa_print_block(ssa_printer* self, const ssa_block* block)
         }
 }
 
+static void ssa_print_padding(ssa_printer* self, size_t size, bool first)
+{
+        if (!first)
+                ssa_prints(self, ", ");
+        ssa_printf(self, "[%u x i8]", (uint)size);
+}
+
 static void ssa_print_struct_fields(ssa_printer* self, const tree_decl* rec)
 {
+        const tree_target_info* target = self->context->target;
         const tree_decl_scope* fields = tree_get_record_cfields(rec);
         bool first = true;
+        size_t end = 0;
         TREE_FOREACH_DECL_IN_SCOPE(fields, field)
         {
                 if (!tree_decl_is(field, TDK_FIELD))
                         continue;
 
+                size_t offset = tree_get_offsetof(target, field);
+                if (offset > end)
+                {
+                        ssa_print_padding(self, offset - end, first);
+                        first = false;
+                }
                 if (!first)
                         ssa_prints(self, ", ");
                 first = false;
 
-                ssa_print_type(self, tree_get_decl_type(field));
+                tree_type* field_type = tree_get_decl_type(field);
+                ssa_print_type(self, field_type);
+                end = offset + tree_get_sizeof(target, field_type);
         }
+
+        size_t size = tree_get_record_layout(target, rec)->size;
+        if (size > end)
+                ssa_print_padding(self, size - end, first);
 }
 
 static void ssa_print_union_fields(ssa_printer* self, const tree_decl* rec)
@@ -703,6 +758,10 @@ static void ssa_print_union_fields(ssa_printer* self, const tree_decl* rec)
         }
 
         ssa_print_type(self, largest_type);
+        size_t largest_size = tree_get_sizeof(self->context->target, largest_type);
+        size_t size = tree_get_record_layout(self->context->target, rec)->size;
+        if (size > largest_size)
+                ssa_print_padding(self, size - largest_size, false);
 }
 
 static void ssa_print_record_fields(ssa_printer* self, const tree_decl* rec)
@@ -803,6 +862,41 @@ static void ssa_print_function(ssa_printer* self, const ssa_value* val)
         ssa_prints(self, "\n}");
 }
 
+static void ssa_print_const(ssa_printer* self, ssa_const* cst, bool print_type);
+
+static void ssa_print_record_const_list(ssa_printer* self, const tree_decl* rec, struct vec* list)
+{
+        const tree_target_info* target = self->context->target;
+        size_t end = 0;
+        int i = 0;
+        ssa_prints(self, "<{ ");
+        TREE_FOREACH_DECL_IN_SCOPE(tree_get_record_cfields(rec), field)
+        {
+                if (!tree_decl_is(field, TDK_FIELD) || i == list->size)
+                        continue;
+
+                size_t offset = tree_get_offsetof(target, field);
+                if (offset > end)
+                {
+                        ssa_print_padding(self, offset - end, i == 0);
+                        ssa_prints(self, " zeroinitializer");
+                }
+                if (i)
+                        ssa_prints(self, ", ");
+
+                ssa_print_const(self, list->items[i++], true);
+                end = offset + tree_get_sizeof(target, tree_get_decl_type(field));
+        }
+
+        size_t size = tree_get_record_layout(target, rec)->size;
+        if (size > end)
+        {
+                ssa_print_padding(self, size - end, i == 0);
+                ssa_prints(self, " zeroinitializer");
+        }
+        ssa_prints(self, " }> ");
+}
+
 static void ssa_print_const(ssa_printer* self, ssa_const* cst, bool print_type)
 {
         ssa_const_kind kind = ssa_get_const_kind(cst);
@@ -824,7 +918,11 @@ static void ssa_print_const(ssa_printer* self, ssa_const* cst, bool print_type)
                 {
                         struct vec* list = ssa_get_const_list(cst);
                         if (tree_type_is_record(t))
-                                ssa_prints(self, "<{ ");
+                        {
+                                ssa_print_record_const_list(self,
+                                        tree_get_decl_type_entity(tree_desugar_type(t)), list);
+                                break;
+                        }
                         else if (tree_type_is_array(t))
                                 ssa_prints(self, "[ ");
                         for (int i = 0; i < list->size; i++)
@@ -833,9 +931,7 @@ static void ssa_print_const(ssa_printer* self, ssa_const* cst, bool print_type)
                                 if (i + 1 < list->size)
                                         ssa_prints(self, ", ");
                         }
-                        if (tree_type_is_record(t))
-                                ssa_prints(self, " }> ");
-                        else if (tree_type_is_array(t))
+                        if (tree_type_is_array(t))
                                 ssa_prints(self, " ] ");
                         break;
                 }
@@ -874,7 +970,8 @@ static void ssa_print_const(ssa_printer* self, ssa_const* cst, bool print_type)
                 {
                         ssa_const* var = ssa_get_const_field_addr_var(cst);
                         tree_type* rec_ptr = ssa_get_const_type(var);
-                        unsigned index = ssa_get_const_field_addr_index(cst);
+                        unsigned index = ssa_get_llvm_field_index(self,
+                                rec_ptr, ssa_get_const_field_addr_index(cst));
                         ssa_prints(self, "getelementptr inbounds(");
                         ssa_print_type(self, tree_get_pointer_target(rec_ptr));
                         ssa_prints(self, ", ");
@@ -1,6 +1,7 @@
 #include "scc/ssa/pass.h"
 #include "scc/ssa/module.h"
 #include "scc/ssa/instr.h"
+#include "scc/ssa/cfg.h"
 
 extern void ssa_init_pass(ssa_pass* self, ssa_pass_kind kind, void(*run)(const ssa_pass*))
 {
@@ -10,6 +11,7 @@ extern void ssa_init_pass(ssa_pass* self, ssa_pass_kind kind, void(*run)(const s
         self->function = NULL;
         self->entry = run;
         self->context = NULL;
+        self->preserves_cfg = false;
 }
 
 extern void ssa_init_pass_manager(ssa_pass_manager* self)
@@ -22,6 +24,13 @@ extern void ssa_pass_manager_add_pass(ssa_pass_manager* self, ssa_pass* pass)
         list_push(&self->passes, &pass->node);
 }
 
+static void ssa_invalidate_module_cfgs(ssa_module* module)
+{
+        SSA_FOREACH_MODULE_GLOBAL(module, it, end)
+                if (ssa_get_value_kind(*it) == SVK_FUNCTION && ssa_function_has_body(*it))
+                        ssa_invalidate_function_cfg(*it);
+}
+
 extern void ssa_pass_manager_run(ssa_pass_manager* self, ssa_context* context, ssa_module* module)
 {
         LIST_FOREACH(&self->passes, ssa_pass*, pass)
@@ -32,13 +41,22 @@ extern void ssa_pass_manager_run(ssa_pass_manager* self, ssa_context* context, s
                 pass->context = context;
                 pass->module = module;
                 if (pass->kind == SPK_MODULE)
+                {
                         pass->entry(pass);
+                        if (!pass->preserves_cfg)
+                                ssa_invalidate_module_cfgs(module);
+                }
                 else if (pass->kind == SPK_FUNCTION)
                         SSA_FOREACH_MODULE_GLOBAL(module, it, end)
                                 if (ssa_get_value_kind(*it) == SVK_FUNCTION)
                                 {
                                         pass->function = *it;
                                         pass->entry(pass);
+                                        if (!pass->preserves_cfg && ssa_function_has_body(*it))
+                                                ssa_invalidate_function_cfg(*it);
                                 }
         }
+
+        // the graphs are not kept up to date outside of the pass manager
+        ssa_invalidate_module_cfgs(module);
 }
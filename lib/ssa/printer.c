@@ -13,12 +13,19 @@ extern void ssa_init_printer(ssa_printer* self, ssa_context* context, FILE* fout
         self->llvm.tmp_id = 0;
         self->llvm.rec_id = 0;
         ssa_recmap_init(&self->llvm.rec_to_id);
+        ssa_fieldmap_init(&self->llvm.field_indices);
 }
 
 extern void ssa_dispose_printer(ssa_printer* self)
 {
         drop_buf_writer(&self->buf);
         ssa_recmap_drop(&self->llvm.rec_to_id);
+        for (struct ssa_fieldmap_iter it = ssa_fieldmap_begin(&self->llvm.field_indices);
+                it.pos != it.end; ssa_fieldmap_next(&it))
+        {
+                dealloc(it.pos->value);
+        }
+        ssa_fieldmap_drop(&self->llvm.field_indices);
 }
 
 extern void ssa_prints(ssa_printer* self, const char* s)
@@ -16,6 +16,14 @@ typedef struct _ssa_context ssa_context;
 #define HTAB_V uint
 #include "scc/core/htab.inc"
 
+#define HTAB ssa_fieldmap
+#define HTAB_K const void*
+#define HTAB_K_EMPTY (const void *)0
+#define HTAB_K_DEL (const void *)1
+#define HTAB_K_TO_U32(K) (unsigned)(size_t)(K)
+#define HTAB_V uint*
+#include "scc/core/htab.inc"
+
 typedef struct
 {
         struct buf_writer buf;
@@ -26,6 +34,8 @@ typedef struct
                 uint tmp_id;
                 uint rec_id;
                 struct ssa_recmap rec_to_id;
+                // record -> indices of its fields in the printed type
+                struct ssa_fieldmap field_indices;
         } llvm;
 } ssa_printer;
 
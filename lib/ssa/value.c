@@ -77,7 +77,7 @@ extern ssa_value* ssa_new_global_var(
 {
         assert(var);
         tree_type* t = tree_desugar_type(tree_get_decl_type(var));
-        t = tree_new_pointer_type(context->tree, t);
+        t = tree_get_pointer_type(context->tree, t);
         ssa_value* v = ssa_new_value(context, SVK_GLOBAL_VAR, t, sizeof(struct _ssa_global_var));
         if (!v)
                 return NULL;
@@ -125,7 +125,7 @@ extern ssa_value* ssa_new_function(
         assert(func);
         tree_type* t = tree_desugar_type(tree_get_decl_type(func));
         if (tree_type_is(t, TTK_FUNCTION))
-                t = tree_new_pointer_type(context->tree, t);
+                t = tree_get_pointer_type(context->tree, t);
 
         ssa_value* val = ssa_new_value(context, SVK_FUNCTION, t, sizeof(struct _ssa_function));
         if (!val)
@@ -136,6 +136,7 @@ extern ssa_value* ssa_new_function(
         f->intrin_kind = intrin_kind;
         init_list(&f->blocks);
         ssa_init_array(&f->params);
+        f->cfg = NULL;
 
         return val;
 }
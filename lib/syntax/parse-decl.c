@@ -275,7 +275,7 @@ extern bool c_parse_decl_specs(c_parser* self, c_decl_specs* result)
         }
 
         c_decl_specs_set_loc_end(result, c_parser_get_loc(self));
-        tree_set_type_quals(result->typespec, quals);
+        result->typespec = c_sema_get_qualified_type(self->sema, result->typespec, quals);
         return true;
 }
 
@@ -366,8 +366,8 @@ extern tree_type* c_parse_specifier_qualifier_list(c_parser* self)
         if (!typespec)
                 return NULL;
 
-        tree_set_type_quals(typespec, quals | c_parse_type_qualifier_list_opt(self));
-        return typespec;
+        quals |= c_parse_type_qualifier_list_opt(self);
+        return c_sema_get_qualified_type(self->sema, typespec, quals);
 }
 
 static const c_token_kind ctk_semicolon_or_comma[] =
@@ -224,8 +224,12 @@ extern tree_module* c_parse_source(
         c_parser_init(&parser, context, &lexer, &sema);
         
         c_source* s = c_source_get_from_file(&context->source_manager, source);
-        if (!source || EC_FAILED(c_lexer_enter_source_file(&lexer, s)))
+        if (!source
+                || EC_FAILED(c_lexer_enter_source_file(&lexer, s))
+                || EC_FAILED(c_lexer_enter_pch(&lexer)))
+        {
                 goto cleanup;
+        }
 
         jmp_buf on_parser_error;
         if (setjmp(on_parser_error))
@@ -2,18 +2,30 @@
 #include "scc/core/allocator.h"
 #include "scc/core/strpool.h"
 #include "scc/tree/target.h"
+#include "scc/tree/decl.h"
+
+#define TREE_NUM_QUALIFIED_VARIANTS ((TTQ_CONST | TTQ_VOLATILE | TTQ_RESTRICT) + 1)
+#define TREE_TRANSACTION_SAFE_VARIANT TREE_NUM_QUALIFIED_VARIANTS
 
 extern void tree_init(tree_context* self, tree_target_info* target)
 {
         self->target = target;
         init_stack_alloc(&self->nodes);
         init_strpool(&self->strings);
+        tree_type_map_init(&self->pointer_types);
+        tree_type_map_init(&self->qualified_types);
+        tree_type_map_init(&self->canonical_types);
+        tree_type_strhtab_init(&self->derived_types);
         for (tree_builtin_type_kind i = TBTK_INVALID; i < TBTK_SIZE; i++)
                 tree_init_builtin_type(tree_get_builtin_type(self, i), i);
 }
 
 extern void tree_dispose(tree_context* self)
 {
+        tree_type_map_drop(&self->pointer_types);
+        tree_type_map_drop(&self->qualified_types);
+        tree_type_map_drop(&self->canonical_types);
+        tree_type_strhtab_drop(&self->derived_types);
         drop_strpool(&self->strings);
         drop_stack_alloc(&self->nodes);
 }
@@ -35,3 +47,237 @@ extern tree_type* tree_get_ptrdiff_type(tree_context* self)
         return tree_get_builtin_type(self,
                 tree_target_is(self->target, TTAK_X86_32) ? TBTK_INT32 : TBTK_INT64);
 }
+
+extern tree_type* tree_get_pointer_type(tree_context* self, tree_type* target)
+{
+        struct tree_type_map_entry* e = tree_type_map_lookup(&self->pointer_types, target);
+        if (e)
+                return e->value;
+
+        tree_type* t = tree_new_pointer_type(self, target);
+        tree_type_map_insert(&self->pointer_types, target, t);
+        return t;
+}
+
+static tree_type* tree_get_type_variant(
+        tree_context* self, tree_type* type, tree_type_quals quals, bool transaction_safe)
+{
+        type = tree_get_modified_type(type);
+        tree_type** variants;
+        struct tree_type_map_entry* e = tree_type_map_lookup(&self->qualified_types, type);
+        if (e)
+                variants = e->value;
+        else
+        {
+                size_t size = sizeof(tree_type*) * TREE_NUM_QUALIFIED_VARIANTS * 2;
+                variants = tree_allocate_node(self, size);
+                memset(variants, 0, size);
+                tree_type_map_insert(&self->qualified_types, type, variants);
+        }
+
+        size_t i = quals + (transaction_safe ? TREE_TRANSACTION_SAFE_VARIANT : 0);
+        if (!variants[i])
+        {
+                variants[i] = tree_new_qualified_type(self, type, quals);
+                if (transaction_safe)
+                        tree_set_func_type_transaction_safe(variants[i], true);
+        }
+        return variants[i];
+}
+
+extern tree_type* tree_get_qualified_type(
+        tree_context* self, tree_type* type, tree_type_quals quals)
+{
+        return tree_get_type_variant(self, type, quals, false);
+}
+
+// Returns the type stored under the signature or NULL. The signature is copied
+// when a type is stored, so it can be a temporary buffer.
+static tree_type* tree_lookup_derived_type(tree_context* self, const void* signature, size_t size)
+{
+        struct tree_type_strhtab_entry* e = tree_type_strhtab_lookup(
+                &self->derived_types, signature, (unsigned)size);
+        return e ? e->value : NULL;
+}
+
+static void tree_add_derived_type(
+        tree_context* self, const void* signature, size_t size, tree_type* type)
+{
+        char* key = tree_allocate_node(self, size);
+        memcpy(key, signature, size);
+        tree_type_strhtab_insert(&self->derived_types, key, (unsigned)size, type);
+}
+
+static tree_type* tree_canonicalize(tree_context* self, const tree_type* type, bool* cacheable);
+
+static tree_type* tree_get_canonical_tag_type(tree_context* self, tree_decl* entity)
+{
+        const char kind = 'T';
+        char signature[sizeof(kind) + sizeof(entity)];
+        memcpy(signature, &kind, sizeof(kind));
+        memcpy(signature + sizeof(kind), &entity, sizeof(entity));
+
+        tree_type* t = tree_lookup_derived_type(self, signature, sizeof(signature));
+        if (!t)
+        {
+                t = tree_new_decl_type(self, entity, true);
+                tree_add_derived_type(self, signature, sizeof(signature), t);
+        }
+        return t;
+}
+
+static tree_type* tree_get_canonical_array_type(
+        tree_context* self, const tree_type* type, bool* cacheable)
+{
+        tree_type* eltype = tree_canonicalize(self, tree_get_array_eltype(type), cacheable);
+        if (!eltype)
+                return NULL;
+
+        // an incomplete array of a declaration gets its size from the initializer
+        tree_array_kind kind = tree_get_array_kind(type);
+        if (kind == TAK_INCOMPLETE)
+                *cacheable = false;
+
+        const char k = 'A';
+        uint64_t size = kind == TAK_CONSTANT ? tree_get_array_size(type) : 0;
+        char signature[sizeof(k) + sizeof(char) + sizeof(size) + sizeof(eltype)];
+        char* pos = signature;
+        memcpy(pos, &k, sizeof(k));
+        pos += sizeof(k);
+        *pos++ = (char)kind;
+        memcpy(pos, &size, sizeof(size));
+        pos += sizeof(size);
+        memcpy(pos, &eltype, sizeof(eltype));
+
+        tree_type* t = tree_lookup_derived_type(self, signature, sizeof(signature));
+        if (t)
+                return t;
+
+        t = kind == TAK_CONSTANT
+                ? tree_new_constant_array_type(self, eltype, NULL, tree_get_array_size_value_c(type))
+                : tree_new_incomplete_array_type(self, eltype);
+        tree_add_derived_type(self, signature, sizeof(signature), t);
+        return t;
+}
+
+static tree_type* tree_get_canonical_func_type(
+        tree_context* self, const tree_type* type, bool* cacheable)
+{
+        tree_type* restype = tree_canonicalize(self, tree_get_func_type_result(type), cacheable);
+        if (!restype)
+                return NULL;
+
+        // 'F', vararg, calling convention, result and parameter types
+        size_t num_params = tree_get_func_type_params_size(type);
+        size_t size = 3 + sizeof(tree_type*) * (num_params + 1);
+        char* signature = alloc(size);
+        signature[0] = 'F';
+        signature[1] = (char)tree_func_type_is_vararg(type);
+        signature[2] = (char)tree_get_func_type_cc(type);
+        memcpy(signature + 3, &restype, sizeof(restype));
+        char* params = signature + 3 + sizeof(restype);
+
+        tree_type* t = NULL;
+        for (size_t i = 0; i < num_params; i++)
+        {
+                tree_type* param = tree_canonicalize(self, tree_get_func_type_param(type, i), cacheable);
+                if (!param)
+                        goto cleanup;
+                memcpy(params + i * sizeof(param), &param, sizeof(param));
+        }
+
+        if ((t = tree_lookup_derived_type(self, signature, size)))
+                goto cleanup;
+
+        t = tree_new_func_type(self, restype);
+        tree_set_func_type_vararg(t, tree_func_type_is_vararg(type));
+        tree_set_func_type_cc(t, tree_get_func_type_cc(type));
+        tree_reserve_array(self, &_tree_func_type(t)->params, sizeof(tree_type*), num_params);
+        for (size_t i = 0; i < num_params; i++)
+        {
+                tree_type* param;
+                memcpy(&param, params + i * sizeof(param), sizeof(param));
+                tree_add_func_type_param(t, self, param);
+        }
+        tree_add_derived_type(self, signature, size, t);
+cleanup:
+        dealloc(signature);
+        return t;
+}
+
+static tree_type* tree_build_canonical_type(tree_context* self, const tree_type* type, bool* cacheable)
+{
+        tree_type_quals quals = tree_get_type_quals(type);
+        bool transaction_safe = tree_type_is(type, TTK_FUNCTION)
+                && tree_func_type_is_transaction_safe(type);
+
+        tree_type* t = NULL;
+        switch (tree_get_type_kind(type))
+        {
+                case TTK_BUILTIN:
+                        t = tree_get_builtin_type(self, tree_get_builtin_type_kind(type));
+                        break;
+                case TTK_POINTER:
+                        if ((t = tree_canonicalize(self, tree_get_pointer_target(type), cacheable)))
+                                t = tree_get_pointer_type(self, t);
+                        break;
+                case TTK_ARRAY:
+                        t = tree_get_canonical_array_type(self, type, cacheable);
+                        break;
+                case TTK_FUNCTION:
+                        t = tree_get_canonical_func_type(self, type, cacheable);
+                        break;
+                case TTK_PAREN:
+                        t = tree_canonicalize(self, tree_get_paren_type(type), cacheable);
+                        break;
+                case TTK_ADJUSTED:
+                        t = tree_canonicalize(self, tree_get_adjusted_type(type), cacheable);
+                        break;
+                case TTK_DECL:
+                {
+                        tree_decl* entity = tree_get_decl_type_entity(type);
+                        t = tree_decl_is(entity, TDK_TYPEDEF)
+                                ? tree_canonicalize(self, tree_get_decl_type(entity), cacheable)
+                                : tree_get_canonical_tag_type(self, entity);
+                        break;
+                }
+                default:
+                        break;
+        }
+        if (!t)
+                return NULL;
+
+        // qualifiers of a typedef are added to the ones it is used with
+        quals |= tree_get_type_quals(t);
+        transaction_safe |= tree_type_is(t, TTK_FUNCTION) && tree_func_type_is_transaction_safe(t);
+        return quals || transaction_safe
+                ? tree_get_type_variant(self, t, quals, transaction_safe)
+                : t;
+}
+
+static tree_type* tree_canonicalize(tree_context* self, const tree_type* type, bool* cacheable)
+{
+        if (!type)
+                return NULL;
+
+        struct tree_type_map_entry* e = tree_type_map_lookup(&self->canonical_types, type);
+        if (e)
+                return e->value;
+
+        bool type_cacheable = true;
+        tree_type* t = tree_build_canonical_type(self, type, &type_cacheable);
+        if (t && type_cacheable)
+        {
+                tree_type_map_insert(&self->canonical_types, type, t);
+                tree_type_map_insert(&self->canonical_types, t, t);
+        }
+        *cacheable &= type_cacheable;
+        return t;
+}
+
+extern tree_type* tree_get_canonical_type(tree_context* self, const tree_type* type)
+{
+        bool cacheable = true;
+        return tree_canonicalize(self, type, &cacheable);
+}
+
@@ -299,6 +299,7 @@ extern tree_decl* tree_new_field_decl(
                 return NULL;
 
         tree_set_field_bit_width(d, bit_width);
+        tree_set_field_offset(d, 0);
         d->field.index = -1;
         return d;
 }
@@ -44,7 +44,6 @@ extern void tree_init_target_info(tree_target_info* self, tree_target_architectu
 
                 self->builtin_align[TBTK_INT64] = 8;
                 self->builtin_align[TBTK_UINT64] = 8;
-                self->builtin_align[TBTK_FLOAT] = 8;
                 self->builtin_align[TBTK_DOUBLE] = 8;
         }
         else
@@ -91,26 +90,73 @@ extern size_t tree_get_builtin_type_align(const tree_target_info* self, tree_bui
         return self->builtin_align[k];
 }
 
-extern size_t tree_get_sizeof_record(const tree_target_info* info, const tree_decl* d)
+static size_t tree_align_offset(size_t offset, size_t align)
 {
-        bool is_union = tree_record_is_union(d);
-        const tree_decl_scope* scope = tree_get_record_cfields(d);
-        size_t total_size = 0;
+        return align ? (offset + align - 1) / align * align : offset;
+}
 
-        // todo: padding?
-        TREE_FOREACH_DECL_IN_SCOPE(scope, member)
+static void tree_compute_record_layout(
+        const tree_target_info* info, tree_decl* record, tree_record_layout* layout)
+{
+        bool is_union = tree_record_is_union(record);
+        size_t size = 0;
+        size_t max_align = 0;
+
+        TREE_FOREACH_DECL_IN_SCOPE(tree_get_record_fields(record), field)
         {
-                if (!tree_decl_is(member, TDK_FIELD))
+                if (!tree_decl_is(field, TDK_FIELD))
                         continue;
 
-                size_t member_size = tree_get_sizeof(info, tree_get_decl_type(member));
-                size_t max_size = total_size > member_size ? total_size : member_size;
-                total_size = is_union
-                        ? max_size
-                        : total_size + member_size;
+                // bit-fields occupy the whole storage of their type, as they do in the emitted code
+                const tree_type* t = tree_get_decl_type(field);
+                size_t field_size = tree_get_sizeof(info, t);
+                size_t field_align = tree_get_alignof(info, t);
+                if (field_align > max_align)
+                        max_align = field_align;
+
+                if (is_union)
+                {
+                        tree_set_field_offset(field, 0);
+                        if (field_size > size)
+                                size = field_size;
+                }
+                else
+                {
+                        size = tree_align_offset(size, field_align);
+                        tree_set_field_offset(field, size);
+                        size += field_size;
+                }
+        }
+
+        // _Aligned(N) can only increase the alignment, the size is rounded up to the result
+        tree_expr* alignment = tree_get_record_alignment(record);
+        if (alignment)
+        {
+                tree_eval_result er;
+                bool ok = tree_eval_expr_as_integer(info, alignment, &er);
+                assert(ok);
+                size_t explicit_align = num_as_u64(&er.value);
+                if (explicit_align > max_align)
+                        max_align = explicit_align;
         }
 
-        return total_size;
+        layout->size = tree_align_offset(size, max_align);
+        layout->align = max_align;
+}
+
+extern const tree_record_layout* tree_get_record_layout(
+        const tree_target_info* info, const tree_decl* record)
+{
+        assert(tree_decl_is(record, TDK_RECORD));
+        tree_decl* r = (tree_decl*)record;
+        tree_record_layout* layout = tree_get_record_layout_cache(r);
+        if (layout->computed)
+                return layout;
+
+        tree_compute_record_layout(info, r, layout);
+        // fields can be added until the record is complete
+        layout->computed = tree_tag_decl_is_complete(r);
+        return layout;
 }
 
 extern size_t tree_get_sizeof(const tree_target_info* info, const tree_type* t)
@@ -130,7 +176,7 @@ extern size_t tree_get_sizeof(const tree_target_info* info, const tree_type* t)
                 if (dk == TDK_ENUM)
                         return tree_get_builtin_type_size(info, TBTK_INT32);
                 else if (dk == TDK_RECORD)
-                        return tree_get_sizeof_record(info, entity);
+                        return tree_get_record_layout(info, entity)->size;
         }
         else if (tree_type_is(t, TTK_ARRAY) && tree_array_is(t, TAK_CONSTANT))
                 return tree_get_array_size(t) * tree_get_sizeof(info, tree_get_array_eltype(t));
@@ -139,33 +185,6 @@ extern size_t tree_get_sizeof(const tree_target_info* info, const tree_type* t)
         return 0;
 }
 
-extern size_t tree_get_alignof_record(const tree_target_info* info, const tree_decl* d)
-{
-        tree_expr* alignment = tree_get_record_alignment(d);
-        if (alignment)
-        {
-                tree_eval_result er;
-                bool ok = tree_eval_expr_as_integer(info, alignment, &er);
-                assert(ok);
-                return num_as_u64(&er.value);
-        }
-
-        bool is_union = tree_record_is_union(d);
-        const tree_decl_scope* scope = tree_get_record_cfields(d);
-        size_t max_align = 0;
-
-        TREE_FOREACH_DECL_IN_SCOPE(scope, member)
-        {
-                if (!tree_decl_is(member, TDK_FIELD))
-                        continue;
-                size_t member_align = tree_get_alignof(info, tree_get_decl_type(member));
-                if (member_align > max_align)
-                        max_align = member_align;
-        }
-
-        return max_align;
-}
-
 extern size_t tree_get_alignof(const tree_target_info* info, const tree_type* t)
 {
         assert(t);
@@ -183,7 +202,7 @@ extern size_t tree_get_alignof(const tree_target_info* info, const tree_type* t)
                 if (dk == TDK_ENUM)
                         return tree_get_builtin_type_align(info, TBTK_INT32);
                 else if (dk == TDK_RECORD)
-                        return tree_get_alignof_record(info, entity);
+                        return tree_get_record_layout(info, entity)->align;
         }
         else if (tree_type_is(t, TTK_ARRAY))
                 return tree_get_alignof(info, tree_get_array_eltype(t));
@@ -195,22 +214,8 @@ extern size_t tree_get_alignof(const tree_target_info* info, const tree_type* t)
 static size_t tree_get_offsetof_field(const tree_target_info* info, const tree_decl* field)
 {
         assert(tree_decl_is(field, TDK_FIELD));
-        tree_decl* record = tree_get_field_record(field);
-        if (tree_record_is_union(record))
-                return 0;
-
-        size_t offset = 0;
-        const tree_decl_scope* scope = tree_get_record_cfields(record);
-        TREE_FOREACH_DECL_IN_SCOPE(scope, it)
-        {
-                if (!tree_decl_is(it, TDK_FIELD))
-                        continue;
-                if (it == field)
-                        break;
-                offset += tree_get_sizeof(info, tree_get_decl_type(it));
-        }
-
-        return offset;
+        tree_get_record_layout(info, tree_get_field_record(field));
+        return tree_get_field_offset(field);
 }
 
 extern size_t tree_get_offsetof(const tree_target_info* info, const tree_decl* field)
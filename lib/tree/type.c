@@ -580,7 +580,7 @@ extern tree_type_equality_kind tree_compare_types(const tree_type* a, const tree
         while (1)
         {
                 if (a == b)
-                        return TTEK_EQ;
+                        return cmp_result(same_quals, same_attrs);
 
                 same_quals &= tree_get_type_quals(a) == tree_get_type_quals(b);
                 a = tree_desugar_type_c(a);
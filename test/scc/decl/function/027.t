@@ -0,0 +1,5 @@
+typedef int T;
+typedef const T CT;
+
+extern int (*f)(int, const int*);
+extern T (*f)(T, CT*);
\ No newline at end of file
@@ -0,0 +1,2 @@
+extern void foo(int a);
+extern void foo(int a) _Stdcall;
\ No newline at end of file
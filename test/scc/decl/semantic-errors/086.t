@@ -0,0 +1,2 @@
+extern int* p;
+extern const int* p;
\ No newline at end of file
@@ -0,0 +1,3 @@
+typedef const int CI;
+extern int a;
+extern CI a;
\ No newline at end of file
@@ -2,4 +2,6 @@ add_subdirectory('expr')
 add_subdirectory('stdlib')
 add_subdirectory('stmt')
 add_subdirectory('intrin')
-add_subdirectory('other')
\ No newline at end of file
+add_subdirectory('other')
+add_subdirectory('pipe')
+add_subdirectory('pipelined')
\ No newline at end of file
@@ -7,5 +7,5 @@ struct A
 
 int main()
 {
-	return __offsetof(struct A, b) - 10;
+	return __offsetof(struct A, b) - 12;
 }
\ No newline at end of file
@@ -0,0 +1,5 @@
+int main()
+{
+	int a = 3;
+	return a - 3;
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+static int sum(int n)
+{
+	int s = 0;
+	for (int i = 1; i <= n; i++)
+		s += i;
+	return s;
+}
+
+int main()
+{
+	return sum(10) != 55;
+}
\ No newline at end of file
@@ -0,0 +1,2 @@
+def run(test):
+	presets.compile_and_run(test, ex_args=['-nostdlib', '-pipe'])
\ No newline at end of file
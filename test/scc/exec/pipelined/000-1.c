@@ -0,0 +1,4 @@
+int g(int a)
+{
+	return a + 1;
+}
\ No newline at end of file
@@ -0,0 +1,4 @@
+int f(int a)
+{
+	return a * 2;
+}
\ No newline at end of file
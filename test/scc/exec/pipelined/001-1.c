@@ -0,0 +1,4 @@
+int b(void)
+{
+	return 2;
+}
\ No newline at end of file
@@ -0,0 +1,4 @@
+int c(int x)
+{
+	return x + a;
+}
\ No newline at end of file
@@ -0,0 +1,4 @@
+int d(void)
+{
+	return 3;
+}
\ No newline at end of file
@@ -0,0 +1,2 @@
+def run(test):
+	presets.compile_jobs(test, ['-c', '-m32'], ['-pipe'])
\ No newline at end of file
@@ -0,0 +1,12 @@
+struct A
+{
+	char a;
+	int b;
+	char c;
+};
+
+void test()
+{
+	__offsetof(struct A, b); // 4U
+	sizeof(struct A); // 12U
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+struct A
+{
+	char a;
+	double b;
+	int c;
+};
+
+void test()
+{
+	__offsetof(struct A, c); // 16ULL
+	sizeof(struct A); // 24ULL
+}
\ No newline at end of file
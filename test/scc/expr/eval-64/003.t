@@ -0,0 +1,19 @@
+struct _Aligned(16) A
+{
+	int a;
+};
+
+struct B
+{
+	char c;
+	struct A a[3];
+	int d;
+};
+
+void test()
+{
+	sizeof(struct A); // 16ULL
+	__offsetof(struct B, a); // 16ULL
+	__offsetof(struct B, d); // 64ULL
+	sizeof(struct B); // 80ULL
+}
\ No newline at end of file
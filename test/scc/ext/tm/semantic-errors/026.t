@@ -0,0 +1,2 @@
+void foo(int a);
+void foo(int a) _Transaction_safe;
\ No newline at end of file
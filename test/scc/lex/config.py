@@ -5,3 +5,4 @@ add_subdirectory('num')
 add_subdirectory('string')
 add_subdirectory('errors')
 add_subdirectory('line-concat')
+add_subdirectory('line-markers')
\ No newline at end of file
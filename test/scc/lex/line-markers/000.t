@@ -0,0 +1,8 @@
+# 1 "a.c"
+int a;
+
+# 20 "b.h" 1
+int b
+;
+# 3 "a.c" 2
+char c;
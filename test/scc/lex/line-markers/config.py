@@ -0,0 +1,2 @@
+def run(test):
+	presets.lex(test)
\ No newline at end of file
@@ -1,4 +1,10 @@
 add_subdirectory('include')
 add_subdirectory('define')
 add_subdirectory('conditional')
-add_subdirectory('errors')
\ No newline at end of file
+add_subdirectory('errors')
+add_subdirectory('pch')
+add_subdirectory('pch-errors')
+add_subdirectory('pch-dirs')
+add_subdirectory('pch-broken')
+add_subdirectory('preprocessed')
+add_subdirectory('memory')
@@ -0,0 +1,9 @@
+#define CAT(a, b) a ## b
+#define CAT3(a, b, c) a ## b ## c
+#define M(a, b) a ## b + 1
+CAT(, y)
+CAT3(, , r)
+CAT(x, )
+CAT3(p, , q)
+CAT3(, s, )
+M(x, ) M(, 2) CAT(, )
\ No newline at end of file
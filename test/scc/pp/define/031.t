@@ -0,0 +1,7 @@
+/* a block comment
+   spanning
+   three lines */ __LINE__
+/*
+*/
+__LINE__ /* x
+*/ __LINE__
@@ -0,0 +1,5 @@
+
+
+__LINE__
+#define L __LINE__
+L
@@ -0,0 +1,2 @@
+#pragma once
+int
\ No newline at end of file
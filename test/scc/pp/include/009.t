@@ -0,0 +1,2 @@
+#include "009.h"
+#include "009.h"
\ No newline at end of file
@@ -0,0 +1,5 @@
+#ifndef B
+#define B
+int
+#endif
+char
\ No newline at end of file
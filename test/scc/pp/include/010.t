@@ -0,0 +1,2 @@
+#include "010.h"
+#include "010.h"
\ No newline at end of file
@@ -0,0 +1,4 @@
+#ifndef C
+#define C
+int
+#endif
\ No newline at end of file
@@ -0,0 +1,3 @@
+#include "011.h"
+#undef C
+#include "011.h"
\ No newline at end of file
@@ -0,0 +1,137 @@
+// each #if expands E13 to 8192 ones and 8191 additions which are dropped after
+// the evaluation, they have to be recycled instead of kept until the end of the file
+#define E0 1
+#define E1 (E0 + E0)
+#define E2 (E1 + E1)
+#define E3 (E2 + E2)
+#define E4 (E3 + E3)
+#define E5 (E4 + E4)
+#define E6 (E5 + E5)
+#define E7 (E6 + E6)
+#define E8 (E7 + E7)
+#define E9 (E8 + E8)
+#define E10 (E9 + E9)
+#define E11 (E10 + E10)
+#define E12 (E11 + E11)
+#define E13 (E12 + E12)
+
+#if E13 == 8192
+int a0;
+#endif
+#if E13 == 8192
+int a1;
+#endif
+#if E13 == 8192
+int a2;
+#endif
+#if E13 == 8192
+int a3;
+#endif
+#if E13 == 8192
+int a4;
+#endif
+#if E13 == 8192
+int a5;
+#endif
+#if E13 == 8192
+int a6;
+#endif
+#if E13 == 8192
+int a7;
+#endif
+#if E13 == 8192
+int a8;
+#endif
+#if E13 == 8192
+int a9;
+#endif
+#if E13 == 8192
+int a10;
+#endif
+#if E13 == 8192
+int a11;
+#endif
+#if E13 == 8192
+int a12;
+#endif
+#if E13 == 8192
+int a13;
+#endif
+#if E13 == 8192
+int a14;
+#endif
+#if E13 == 8192
+int a15;
+#endif
+#if E13 == 8192
+int a16;
+#endif
+#if E13 == 8192
+int a17;
+#endif
+#if E13 == 8192
+int a18;
+#endif
+#if E13 == 8192
+int a19;
+#endif
+#if E13 == 8192
+int a20;
+#endif
+#if E13 == 8192
+int a21;
+#endif
+#if E13 == 8192
+int a22;
+#endif
+#if E13 == 8192
+int a23;
+#endif
+#if E13 == 8192
+int a24;
+#endif
+#if E13 == 8192
+int a25;
+#endif
+#if E13 == 8192
+int a26;
+#endif
+#if E13 == 8192
+int a27;
+#endif
+#if E13 == 8192
+int a28;
+#endif
+#if E13 == 8192
+int a29;
+#endif
+#if E13 == 8192
+int a30;
+#endif
+#if E13 == 8192
+int a31;
+#endif
+#if E13 == 8192
+int a32;
+#endif
+#if E13 == 8192
+int a33;
+#endif
+#if E13 == 8192
+int a34;
+#endif
+#if E13 == 8192
+int a35;
+#endif
+#if E13 == 8192
+int a36;
+#endif
+#if E13 == 8192
+int a37;
+#endif
+#if E13 == 8192
+int a38;
+#endif
+#if E13 == 8192
+int a39;
+#endif
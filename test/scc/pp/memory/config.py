@@ -0,0 +1,2 @@
+def run(test):
+	presets.check_peak_memory(test, 40000)
\ No newline at end of file
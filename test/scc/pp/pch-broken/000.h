@@ -0,0 +1,3 @@
+int a;
+#error broken header
+int b;
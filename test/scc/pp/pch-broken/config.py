@@ -0,0 +1,2 @@
+def run(test):
+	presets.reject_broken_pch(test)
\ No newline at end of file
@@ -0,0 +1,2 @@
+def run(test):
+	presets.reject_pch(test, ['-I', test.cd])
\ No newline at end of file
@@ -0,0 +1,2 @@
+def run(test):
+	presets.reject_pch(test, ['-m64'])
\ No newline at end of file
@@ -0,0 +1,4 @@
+#define N 3
+#ifdef N
+int a[N];
+#endif
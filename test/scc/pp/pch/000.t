@@ -0,0 +1 @@
+int b = N;
\ No newline at end of file
@@ -0,0 +1,7 @@
+#ifndef H
+#define H
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define STR(x) #x
+typedef int T;
+#pragma link "m.lib"
+#endif
@@ -0,0 +1,6 @@
+#include "001.h"
+T m = MAX(1, 2);
+const char* s = STR(H);
+#ifndef H
+int error;
+#endif
\ No newline at end of file
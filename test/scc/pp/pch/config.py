@@ -0,0 +1,2 @@
+def run(test):
+	presets.lex_with_pch(test)
\ No newline at end of file
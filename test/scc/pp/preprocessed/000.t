@@ -0,0 +1,6 @@
+#define ONE 1
+#define INC(x) x + ONE
+#define TWICE(x) INC(INC(x))
+int a = INC(2) * TWICE(3);
+int b = ONE; int c = INC(
+	4);
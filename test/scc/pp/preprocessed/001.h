@@ -0,0 +1,2 @@
+int in_header;
+#define H 2
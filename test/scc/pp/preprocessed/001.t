@@ -0,0 +1,3 @@
+int before;
+#include "001.h"
+int after = H;
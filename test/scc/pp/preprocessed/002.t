@@ -0,0 +1,15 @@
+int a;
+
+
+
+int b;
+
+
+
+
+
+
+
+
+
+int c;
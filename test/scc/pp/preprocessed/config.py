@@ -0,0 +1,2 @@
+def run(test):
+	presets.preprocess(test, ['-I', test.cd])
\ No newline at end of file
@@ -1,4 +1,4 @@
-import os, subprocess
+import os, sys, shutil, subprocess
 
 def exec_ext(file):
 	return file + '.exe' if os.name == 'nt' else file
@@ -17,6 +17,57 @@ def scc_run(args, stdout=None):
 def lex(test, ex_args=[]):
 	test.exit_code = scc_run([test.input, '-dump-tokens', '-o', test.output] + ex_args)
 
+# precompiles <name>.h of the test with pch_args and lexes the test with it
+def lex_with_pch(test, pch_args=[], ex_args=[]):
+	pch = os.path.join(test.output_dir, 'test.pch')
+	if scc_run([os.path.splitext(test.input)[0] + '.h', '-emit-pch', '-o', pch] + pch_args) != 0:
+		test.exit_code = 533
+		return
+	lex(test, ['-include-pch', pch] + ex_args)
+
+# passes if the header precompiled with pch_args cannot be included with ex_args
+def reject_pch(test, pch_args=[], ex_args=[]):
+	test.ignore = True
+	lex_with_pch(test, pch_args, ex_args)
+	test.exit_code = 0 if test.exit_code not in (0, 533) else 1
+
+# passes if <name>.h of the test cannot be precompiled and no precompiled header is left
+def reject_broken_pch(test, ex_args=[]):
+	test.ignore = True
+	pch = os.path.join(test.output_dir, 'test.pch')
+	if os.path.exists(pch):
+		os.remove(pch)
+	code = scc_run([os.path.splitext(test.input)[0] + '.h', '-emit-pch', '-o', pch] + ex_args)
+	test.exit_code = 0 if code != 0 and not os.path.exists(pch) else 1
+
+# file names in the line markers are written relative to the directory of the test
+def preprocess(test, ex_args=[]):
+	test.exit_code = scc_run([test.input, '-E', '-o', test.output] + ex_args)
+	if test.exit_code != 0:
+		return
+
+	dir = os.path.join(test.cd, '')
+	text = open(test.output).read()
+	text = text.replace(dir.replace('\\', '\\\\'), '').replace(dir, '')
+	open(test.output, 'w').write(text)
+
+# Passes if scc -fsyntax-only on the test succeeds within limit_kb of peak resident memory.
+# The peak is read from the rusage of that process alone, only the exit code is checked
+# where it is not available.
+def check_peak_memory(test, limit_kb, ex_args=[]):
+	test.ignore = True
+	args = [scc()] + scc_builtin_args + [test.input, '-fsyntax-only'] + ex_args
+	if not hasattr(os, 'wait4'):
+		test.exit_code = subprocess.call(args)
+		return
+
+	_, status, usage = os.wait4(os.spawnv(os.P_NOWAIT, args[0], args), 0)
+	# KB on Linux, bytes on macOS
+	peak_kb = usage.ru_maxrss // 1024 if sys.platform == 'darwin' else usage.ru_maxrss
+	if peak_kb > limit_kb:
+		print('peak memory {} KB exceeds {} KB'.format(peak_kb, limit_kb))
+	test.exit_code = 0 if status == 0 and peak_kb <= limit_kb else 1
+
 def lex_errors(test, ex_args=[]):
 	test.ignore_exit_code = True
 	scc_run([test.input, '-dump-tokens', '-log', test.output] + ex_args)
@@ -31,6 +82,86 @@ def parse_errors(test, ex_args=[]):
 def ssaize(test, ex_args=[]):
 	test.exit_code = scc_run([test.input, '-S', '-emit-ssa', '-o', test.output] + ex_args)
 
+# Compiles a copy of the test with -cache-dir three times: the first run misses and stores
+# the output, the second one hits and gets the stored output (which is marked to tell
+# it from a compiled one) and the third one misses since the source is changed.
+def ssaize_cached(test, ex_args=[]):
+	source = os.path.join(test.output_dir, 'cached.c')
+	output = os.path.join(test.output_dir, 'cached.ssa')
+	cache = os.path.join(test.output_dir, 'cache')
+	shutil.copyfile(test.input, source)
+	shutil.rmtree(cache, ignore_errors=True)
+	os.makedirs(cache)
+	args = [source, '-S', '-emit-ssa', '-cache-dir', cache] + ex_args
+
+	if scc_run(args) != 0 or len(os.listdir(cache)) != 1:
+		test.exit_code = 1
+		return
+	with open(os.path.join(cache, os.listdir(cache)[0]), 'a') as f:
+		f.write('; cached\n')
+
+	os.remove(output)
+	test.exit_code = scc_run(args)
+	if test.exit_code == 0:
+		shutil.copyfile(output, test.output)
+
+	with open(source, 'a') as f:
+		f.write('\nint changed;\n')
+	if scc_run(args) != 0 or len(os.listdir(cache)) != 2:
+		test.exit_code = 1
+
+# Compiles a copy of the test with args, then with -cache-dir, which misses and compiles
+# the preprocessed text of the test instead. The diagnostics and the output have to be the
+# ones of the run without the cache, the diagnostics are also compared with the answer.
+def compile_cached(test, args):
+	dir = os.path.join(test.output_dir, 'cached')
+	cache = os.path.join(dir, 'cache')
+	shutil.rmtree(dir, ignore_errors=True)
+	os.makedirs(cache)
+	source = os.path.join(dir, 'cached.c')
+	shutil.copyfile(test.input, source)
+
+	logs = [os.path.join(dir, 'uncached.log'), os.path.join(dir, 'cached.log')]
+	inputs = set(map(os.path.basename, [cache, source] + logs))
+	outputs = []
+	for log, ex_args in zip(logs, [[], ['-cache-dir', cache]]):
+		scc_run([source, '-log', log] + args + ex_args)
+		files = set(os.listdir(dir)) - inputs
+		outputs.append({file: open(os.path.join(dir, file)).read() for file in files})
+		for file in files:
+			os.remove(os.path.join(dir, file))
+
+	expected, got = (open(log).read() for log in logs)
+	test.exit_code = 0 if got == expected and outputs[0] == outputs[1] else 1
+	shutil.copyfile(logs[1], test.output)
+
+# Compiles a copy of the test together with its other sources (<name>-*.c) with args and
+# ex_args. The diagnostics and the output files have to be the ones of a run with one job,
+# the diagnostics are also compared with the answer.
+def compile_jobs(test, args, ex_args):
+	dir = os.path.join(test.output_dir, 'jobs')
+	shutil.rmtree(dir, ignore_errors=True)
+	os.makedirs(dir)
+	name = os.path.splitext(os.path.basename(test.input))[0]
+	sources = [os.path.join(dir, name + '.c')]
+	shutil.copyfile(test.input, sources[0])
+	for file in sorted(os.listdir(test.cd)):
+		if file.startswith(name + '-') and file.endswith('.c'):
+			sources.append(os.path.join(dir, file))
+			shutil.copyfile(os.path.join(test.cd, file), sources[-1])
+
+	logs = [os.path.join(dir, 'sequential.log'), os.path.join(dir, 'jobs.log')]
+	scc_run(sources + args + ['-j', '1', '-log', logs[0]])
+	outputs = set(os.listdir(dir)) - set(map(os.path.basename, sources + logs))
+	for file in outputs:
+		os.remove(os.path.join(dir, file))
+
+	scc_run(sources + args + ex_args + ['-log', logs[1]])
+	expected, got = (open(log).read() for log in logs)
+	same_outputs = outputs == set(os.listdir(dir)) - set(map(os.path.basename, sources + logs))
+	test.exit_code = 0 if got == expected and same_outputs else 1
+	shutil.copyfile(logs[1], test.output)
+
 def compile_and_run(test, check_exit_code_only=True, ex_args=[]):
 	test.ignore = check_exit_code_only
 	exe = os.path.join(test.output_dir, exec_ext('out'))
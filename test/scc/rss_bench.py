@@ -0,0 +1,39 @@
+import presets, os, sys, argparse, tempfile
+
+try:
+	import resource
+except ImportError:
+	resource = None
+
+# Measures the peak memory of scc -fsyntax-only on a generated source which consists of
+# functions that use nested function-like macros and of a large #if 0 block, so most of the
+# tokens never reach the parser. Run it from this directory, like runtests.py.
+
+def generate(path, num_functions, num_skipped_lines):
+	with open(path, 'w') as f:
+		f.write('#define ADD(a, b) ((a) + (b))\n')
+		f.write('#define ADD4(a, b, c, d) ADD(ADD(a, b), ADD(c, d))\n')
+		f.write('#define SUM(x) ADD4(ADD4(x, x, x, x), ADD4(x, x, x, x), x, x)\n')
+		f.write('#if 0\n')
+		for i in range(num_skipped_lines):
+			f.write('int skipped{0} = SUM({0});\n'.format(i))
+		f.write('#endif\n')
+		for i in range(num_functions):
+			f.write('int f{0}(int x)\n{{\n\treturn SUM(x) + SUM({0});\n}}\n'.format(i))
+
+if __name__ == '__main__':
+	parser = argparse.ArgumentParser(description='Measure peak memory of scc')
+	parser.add_argument('--functions', type=int, default=7500, help='Number of generated functions')
+	parser.add_argument('--skipped', type=int, default=20000, help='Number of lines in the #if 0 block')
+	args = parser.parse_args()
+	if not resource:
+		sys.exit('peak memory of child processes is not available on this platform')
+
+	with tempfile.TemporaryDirectory() as dir:
+		source = os.path.join(dir, 'bench.c')
+		generate(source, args.functions, args.skipped)
+		if presets.scc_run([source, '-fsyntax-only']) != 0:
+			sys.exit('scc failed')
+
+	# KB on Linux, bytes on macOS
+	print('Peak memory {}.'.format(resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss))
@@ -0,0 +1,8 @@
+#define SQ(x)   ((x) * (x))
+#define TWICE(x) SQ(x) + SQ(x)
+
+int f(int a)
+{
+	int   b = TWICE(a);
+	return   b + SQ(undeclared);
+}
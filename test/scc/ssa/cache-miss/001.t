@@ -0,0 +1,12 @@
+#define NEG -1
+#define PLUS +
+#define P +
+
+int a, b;
+
+int f(void)
+{
+	a=-NEG;
+	b=a P+b;
+	return a-NEG+b PLUS-a;
+}
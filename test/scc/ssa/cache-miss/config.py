@@ -0,0 +1,2 @@
+def run(test):
+	presets.compile_cached(test, ['-S', '-emit-ssa'])
\ No newline at end of file
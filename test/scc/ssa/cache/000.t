@@ -0,0 +1,4 @@
+int f(int a)
+{
+	return a + 1;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#pragma link "m.lib"
+
+int x;
+
+int main()
+{
+	x = 2;
+	return x;
+}
\ No newline at end of file
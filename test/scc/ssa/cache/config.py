@@ -0,0 +1,2 @@
+def run(test):
+	presets.ssaize_cached(test, ['-m32'])
\ No newline at end of file
@@ -4,3 +4,6 @@ add_subdirectory('stmt')
 add_subdirectory('opt')
 add_subdirectory('other')
 add_subdirectory('intrin')
+add_subdirectory('cache')
+add_subdirectory('cache-miss')
+add_subdirectory('jobs')
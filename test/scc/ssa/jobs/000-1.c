@@ -0,0 +1,4 @@
+int g(void)
+{
+	return undeclared;
+}
\ No newline at end of file
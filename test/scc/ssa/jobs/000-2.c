@@ -0,0 +1,6 @@
+int h(void)
+{
+	return;
+}
+
+int k = h(1, 2);
\ No newline at end of file
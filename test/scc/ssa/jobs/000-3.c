@@ -0,0 +1,4 @@
+int m(void)
+{
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1 @@
+int b = 2;
\ No newline at end of file
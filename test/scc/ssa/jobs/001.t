@@ -0,0 +1 @@
+int a = 1;
\ No newline at end of file
@@ -0,0 +1,2 @@
+def run(test):
+	presets.compile_jobs(test, ['-S', '-emit-ssa'], ['-j', '2'])
\ No newline at end of file
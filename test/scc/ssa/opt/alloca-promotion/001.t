@@ -0,0 +1,21 @@
+struct point
+{
+	int x;
+	int y;
+	struct
+	{
+		int w;
+		int h;
+	} size;
+};
+
+int test(int n)
+{
+	struct point p;
+	p.x = n;
+	p.y = 2;
+	p.size.w = 3;
+	while (p.x > 0)
+		p.x -= p.size.w;
+	return p.x + p.y;
+}
@@ -0,0 +1,12 @@
+void use(int* p);
+
+int test(int n)
+{
+	struct { int a; int b; } r;
+	volatile int v = n;
+	int escaped = n;
+	r.a = v;
+	use(&r.b);
+	use(&escaped);
+	return r.a + escaped;
+}
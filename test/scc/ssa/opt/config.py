@@ -1,2 +1,6 @@
+add_subdirectory('alloca-promotion')
 add_subdirectory('constant-folding')
 add_subdirectory('dead-code-elimination')
+add_subdirectory('gvn')
+add_subdirectory('inline')
+add_subdirectory('sccp')
\ No newline at end of file
@@ -0,0 +1,12 @@
+struct in { int b; int c; };
+struct out { struct in a; int d; };
+
+int test(struct out* p, int x, int y)
+{
+	int r = p->a.b + p->a.c;
+	r += x * y + y * x;
+	if (x > 0)
+		r += p->a.b + x * y;
+	p->d = 3;
+	return r + p->a.b;
+}
@@ -0,0 +1,10 @@
+int test(int* p, int n)
+{
+	int s = 0;
+	for (int i = 0; i < n; i++)
+	{
+		s += p[i] * (n + 1);
+		s += p[i] * (n + 1);
+	}
+	return s + (n + 1);
+}
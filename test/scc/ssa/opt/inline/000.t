@@ -0,0 +1,18 @@
+static int sq(int x)
+{
+	if (x < 0)
+		return -x * x;
+	return x * x;
+}
+
+static void clear(int* p)
+{
+	*p = 0;
+}
+
+int test(int n)
+{
+	int r = sq(n);
+	clear(&n);
+	return r + n;
+}
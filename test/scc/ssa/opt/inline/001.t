@@ -0,0 +1,9 @@
+static int fact(int n)
+{
+	return n ? n * fact(n - 1) : 1;
+}
+
+int test(int n, ...)
+{
+	return fact(n);
+}
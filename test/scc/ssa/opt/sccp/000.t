@@ -0,0 +1,14 @@
+int test(int n)
+{
+	int x = 1;
+	int y = 0;
+	while (n > 0)
+	{
+		if (x == 1)
+			y = y + 2;
+		else
+			y = 7;
+		n = n - 1;
+	}
+	return y + x;
+}
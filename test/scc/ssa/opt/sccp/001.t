@@ -0,0 +1,14 @@
+int test(int c)
+{
+	int k = 5;
+	int r = 3;
+	switch (k)
+	{
+		case 1: r = c; break;
+		case 5: r = r * 4; break;
+		default: r = 2;
+	}
+	if (r > 10)
+		return r;
+	return c;
+}
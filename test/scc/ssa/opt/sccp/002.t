@@ -0,0 +1,11 @@
+int test(void)
+{
+	signed char c = 200;
+	short s = 40000;
+	int i = -5;
+	long long l = i;
+	char n = 0x80;
+	if (n < 0 && l < 0)
+		return c + s;
+	return 0;
+}
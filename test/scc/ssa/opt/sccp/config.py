@@ -0,0 +1,2 @@
+def run(test):
+	presets.ssaize(test, ['-m32', '-fpa', '-fsccp'])
\ No newline at end of file
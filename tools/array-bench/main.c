@@ -0,0 +1,123 @@
+// Measures compilation of a generated source with an initializer list, a parameter list
+// and a call argument list of n elements each, for n doubling up to the given number.
+// Time per element stays flat as long as tree and ssa arrays grow in amortized O(1).
+// usage: array-bench [max number of elements] [number of sizes] [number of rounds]
+
+#include "scc/cc/cc.h"
+#include "scc/core/alloc.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct
+{
+        char* data;
+        size_t size;
+        size_t capacity;
+} bench_buffer;
+
+static void bench_buffer_init(bench_buffer* self)
+{
+        self->capacity = 1 << 16;
+        self->data = alloc(self->capacity);
+        self->size = 0;
+        self->data[0] = '\0';
+}
+
+static void bench_buffer_printf(bench_buffer* self, const char* format, ...)
+{
+        char line[1024];
+        va_list args;
+        va_start(args, format);
+        size_t n = (size_t)vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+
+        if (self->size + n + 1 > self->capacity)
+        {
+                size_t capacity = self->capacity * 2 + n;
+                char* data = alloc(capacity);
+                memcpy(data, self->data, self->size + 1);
+                dealloc(self->data);
+                self->data = data;
+                self->capacity = capacity;
+        }
+        memcpy(self->data + self->size, line, n + 1);
+        self->size += n;
+}
+
+static void bench_generate(bench_buffer* b, unsigned n)
+{
+        bench_buffer_printf(b, "int values[] = {");
+        for (unsigned i = 0; i < n; i++)
+                bench_buffer_printf(b, "%s%u", i ? ", " : " ", i);
+        bench_buffer_printf(b, " };\n\n");
+
+        bench_buffer_printf(b, "int f(");
+        for (unsigned i = 0; i < n; i++)
+                bench_buffer_printf(b, "%sint p%u", i ? ", " : "", i);
+        bench_buffer_printf(b, ");\n\n");
+
+        bench_buffer_printf(b, "int g(void)\n{\n        return f(");
+        for (unsigned i = 0; i < n; i++)
+                bench_buffer_printf(b, "%s%u", i ? ", " : "", i);
+        bench_buffer_printf(b, ");\n}\n");
+}
+
+// returns the best time of compiling the source to the given output or a negative number on failure
+static double bench_run(const bench_buffer* source, cc_output_kind kind, unsigned rounds)
+{
+        double best = -1;
+        for (unsigned i = 0; i < rounds; i++)
+        {
+                cc_instance cc;
+                cc_init(&cc, stderr);
+                cc.output.kind = kind;
+                // the output is discarded, cc_dispose closes it
+                FILE* out = tmpfile();
+                if (out)
+                        cc_set_output_stream(&cc, out);
+                if (!out || EC_FAILED(cc_emulate_source_file(&cc, "array-bench.c", source->data, false, true)))
+                {
+                        cc_dispose(&cc);
+                        return -1;
+                }
+
+                clock_t start = clock();
+                errcode result = cc_run(&cc);
+                double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+                cc_dispose(&cc);
+                if (EC_FAILED(result))
+                        return -1;
+
+                if (best < 0 || elapsed < best)
+                        best = elapsed;
+        }
+        return best;
+}
+
+int main(int argc, const char** argv)
+{
+        unsigned max_elements = argc > 1 ? (unsigned)atoi(argv[1]) : 200000;
+        unsigned num_sizes = argc > 2 ? (unsigned)atoi(argv[2]) : 4;
+        unsigned rounds = argc > 3 ? (unsigned)atoi(argv[3]) : 3;
+
+        printf("%10s %14s %14s %16s\n", "elements", "syntax", "ssa", "ssa per element");
+        for (unsigned i = num_sizes; i > 0; i--)
+        {
+                unsigned n = max_elements >> (i - 1);
+                bench_buffer source;
+                bench_buffer_init(&source);
+                bench_generate(&source, n);
+
+                double syntax = bench_run(&source, COK_NONE, rounds);
+                double ssa = bench_run(&source, COK_SSA, rounds);
+                dealloc(source.data);
+                if (syntax < 0 || ssa < 0)
+                        return EXIT_FAILURE;
+
+                printf("%10u %13.3fs %13.3fs %14.3fus\n", n, syntax, ssa, ssa * 1e6 / n);
+        }
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+// Measures preprocessing of a generated source which consists of functions that use
+// heavily nested function-like macros, similar to logging and container macros.
+// usage: macro-bench [number of functions] [nesting depth] [number of rounds]
+
+#include "scc/cc/cc.h"
+#include "scc/core/alloc.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct
+{
+        char* data;
+        size_t size;
+        size_t capacity;
+} bench_buffer;
+
+static void bench_buffer_init(bench_buffer* self)
+{
+        self->capacity = 1 << 16;
+        self->data = alloc(self->capacity);
+        self->size = 0;
+        self->data[0] = '\0';
+}
+
+static void bench_buffer_printf(bench_buffer* self, const char* format, ...)
+{
+        char line[1024];
+        va_list args;
+        va_start(args, format);
+        size_t n = (size_t)vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+
+        if (self->size + n + 1 > self->capacity)
+        {
+                size_t capacity = self->capacity * 2 + n;
+                char* data = alloc(capacity);
+                memcpy(data, self->data, self->size + 1);
+                dealloc(self->data);
+                self->data = data;
+                self->capacity = capacity;
+        }
+        memcpy(self->data + self->size, line, n + 1);
+        self->size += n;
+}
+
+static void bench_generate(bench_buffer* b, unsigned num_functions, unsigned depth)
+{
+        bench_buffer_printf(b, "void log_write(int level, int line, const char* fmt, ...);\n");
+        bench_buffer_printf(b, "struct vec { int* items; unsigned size; };\n");
+        bench_buffer_printf(b, "#define STR(x) #x\n");
+        bench_buffer_printf(b, "#define ID(x) x\n");
+        bench_buffer_printf(b, "#define MAX(a, b) ((a) > (b) ? (a) : (b))\n");
+        bench_buffer_printf(b, "#define MIN(a, b) ((a) < (b) ? (a) : (b))\n");
+        bench_buffer_printf(b, "#define CLAMP(x, lo, hi) MAX(lo, MIN(x, hi))\n");
+        bench_buffer_printf(b, "#define VEC_AT(v, i) ((v)->items[CLAMP(i, 0, (int)(v)->size - 1)])\n");
+        bench_buffer_printf(b, "#define LOG_IMPL(level, fmt, a, b) "
+                "log_write(level, __LINE__, fmt \" \" STR(a) \" \" STR(b), a, b)\n");
+        bench_buffer_printf(b, "#define LOG(fmt, a, b) LOG_IMPL(1, fmt, a, b)\n");
+        bench_buffer_printf(b, "#define NEST0(x) CLAMP(x, 0, 100)\n");
+        for (unsigned i = 1; i <= depth; i++)
+                bench_buffer_printf(b, "#define NEST%u(x) NEST%u(ID(x) + %u)\n", i, i - 1, i);
+
+        for (unsigned i = 0; i < num_functions; i++)
+        {
+                bench_buffer_printf(b, "int f%u(struct vec* v, int i)\n{\n", i);
+                bench_buffer_printf(b, "        LOG(\"f%u\", VEC_AT(v, i), NEST%u(i));\n", i, depth);
+                bench_buffer_printf(b, "        return NEST%u(VEC_AT(v, i + %u));\n}\n", depth, i);
+        }
+}
+
+int main(int argc, const char** argv)
+{
+        unsigned num_functions = argc > 1 ? (unsigned)atoi(argv[1]) : 2000;
+        unsigned depth = argc > 2 ? (unsigned)atoi(argv[2]) : 16;
+        unsigned rounds = argc > 3 ? (unsigned)atoi(argv[3]) : 5;
+
+        bench_buffer source;
+        bench_buffer_init(&source);
+        bench_generate(&source, num_functions, depth);
+        printf("%u functions, nesting depth %u, %u bytes of source\n",
+                num_functions, depth, (unsigned)source.size);
+
+        double best = 0;
+        for (unsigned i = 0; i < rounds; i++)
+        {
+                cc_instance cc;
+                cc_init(&cc, stderr);
+                cc.output.kind = COK_NONE;
+                if (EC_FAILED(cc_emulate_source_file(&cc, "macro-bench.c", source.data, false, true)))
+                        return EXIT_FAILURE;
+
+                clock_t start = clock();
+                errcode result = cc_run(&cc);
+                double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+                cc_dispose(&cc);
+                if (EC_FAILED(result))
+                        return EXIT_FAILURE;
+
+                if (!i || elapsed < best)
+                        best = elapsed;
+        }
+
+        printf("syntax analysis: %.3fs (best of %u)\n", best, rounds);
+        dealloc(source.data);
+        return EXIT_SUCCESS;
+}
@@ -1,9 +1,17 @@
 #include "scc.h"
 
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
 int main(int argc, const char** argv)
 {
         errcode result = EC_ERROR;
         scc_env env;
+#ifndef _WIN32
+        // a tool which exits before reading the piped module is reported by its exit code
+        signal(SIGPIPE, SIG_IGN);
+#endif
         scc_init(&env);
 
         if (EC_SUCCEEDED(scc_setup(&env, argc, argv)))
@@ -89,6 +89,12 @@ static void scc_dump_tokens(struct parser* p)
         p->env->mode = SRM_OTHER;
 }
 
+static void scc_E(struct parser* p)
+{
+        p->env->cc.output.kind = COK_PREPROCESSED;
+        p->env->mode = SRM_OTHER;
+}
+
 static void scc_dump_tree(struct parser* p)
 {
         p->env->cc.output.kind = COK_C;
@@ -162,6 +168,24 @@ static void scc_emit_llvm(struct parser* p)
         p->env->cc.output.kind = COK_LLVM_IR;
 }
 
+static void scc_emit_pch(struct parser* p)
+{
+        p->env->cc.output.kind = COK_PCH;
+        p->env->mode = SRM_OTHER;
+}
+
+static void scc_include_pch(struct parser* p)
+{
+        const char* file = arg_parser_next_str(&p->p);
+        if (!file)
+        {
+                scc_missing_argument(p->env, "-include-pch");
+                return;
+        }
+
+        cc_set_pch(&p->env->cc, file);
+}
+
 static void scc_I(struct parser* p)
 {
         const char* dir = arg_parser_next_str(&p->p);
@@ -171,7 +195,7 @@ static void scc_I(struct parser* p)
                 return;
         }
 
-        cc_add_source_dir(&p->env->cc, dir);
+        cc_add_include_dir(&p->env->cc, dir);
 }
 
 static void scc_l(struct parser* p)
@@ -185,6 +209,26 @@ static void scc_l(struct parser* p)
         cc_add_lib(&p->env->cc, lib, false);
 }
 
+static void scc_llc(struct parser* p)
+{
+        // -llc<name> links a library whose name starts with "lc"
+        if (p->p.merged_arg)
+        {
+                cc_add_lib(&p->env->cc, p->p.argv[p->p.pos - 1] + 2, false);
+                p->p.merged_arg = NULL;
+                return;
+        }
+
+        const char* path = arg_parser_next_str(&p->p);
+        if (!path)
+        {
+                scc_missing_argument(p->env, "-llc");
+                return;
+        }
+
+        p->env->cc.input.llc_path = path;
+}
+
 static void scc_L(struct parser* p)
 {
         const char* dir = arg_parser_next_str(&p->p);
@@ -219,7 +263,17 @@ static void scc_fpa(struct parser* p)
 
 static void scc_finline(struct parser* p)
 {
-        UNREACHABLE();
+        p->env->cc.opts.optimization.inline_functions = true;
+}
+
+static void scc_fsccp(struct parser* p)
+{
+        p->env->cc.opts.optimization.propagate_constants = true;
+}
+
+static void scc_fgvn(struct parser* p)
+{
+        p->env->cc.opts.optimization.eliminate_common_subexpressions = true;
 }
 
 static void scc_O3(struct parser* p)
@@ -227,9 +281,54 @@ static void scc_O3(struct parser* p)
         p->env->cc.opts.optimization.eliminate_dead_code = true;
         p->env->cc.opts.optimization.promote_allocas = true;
         p->env->cc.opts.optimization.fold_constants = true;
+        p->env->cc.opts.optimization.propagate_constants = true;
+        p->env->cc.opts.optimization.eliminate_common_subexpressions = true;
         p->env->cc.opts.optimization.level = 3;
 }
 
+static void scc_j(struct parser* p)
+{
+        int num_jobs;
+        if (!arg_parser_next_int(&p->p, &num_jobs))
+        {
+                scc_missing_argument(p->env, "-j");
+                return;
+        }
+
+        if (num_jobs < 0)
+        {
+                scc_error(p->env, "invalid number of jobs '%d'", num_jobs);
+                return;
+        }
+
+        // 0 means one job per hardware thread
+        p->env->cc.opts.num_jobs = num_jobs;
+}
+
+// -cache-dir <dir> reuses the outputs of units whose preprocessed text and options did not
+// change since they were compiled. Warnings of a reused unit are not reported.
+static void scc_cache_dir(struct parser* p)
+{
+        const char* dir = arg_parser_next_str(&p->p);
+        if (!dir)
+        {
+                scc_missing_argument(p->env, "-cache-dir");
+                return;
+        }
+        if (!isdir(dir))
+        {
+                scc_error(p->env, "cache directory '%s' does not exist", dir);
+                return;
+        }
+
+        p->env->cc.opts.cache_dir = dir;
+}
+
+static void scc_pipe(struct parser* p)
+{
+        p->env->cc.opts.pipe = true;
+}
+
 static void scc_g(struct parser* p)
 {
         p->env->cc.opts.linker.emit_debug_info = true;
@@ -276,7 +375,10 @@ extern void scc_parse_opts(scc_env* self, int argc, const char** argv)
         struct arg_handler handlers[] =
         {
                 ARG_HANDLER("-S", &scc_S),
+                // before -c, arguments are matched by prefix
+                ARG_HANDLER("-cache-dir", &scc_cache_dir),
                 ARG_HANDLER("-c", &scc_c ),
+                ARG_HANDLER("-E", &scc_E),
                 ARG_HANDLER("-o", &scc_o),
                 ARG_HANDLER("-nostdlib", &scc_nostdlib),
                 ARG_HANDLER("-log", &scc_log),
@@ -294,9 +396,14 @@ extern void scc_parse_opts(scc_env* self, int argc, const char** argv)
                 ARG_HANDLER("-fpa", &scc_fpa),
                 ARG_HANDLER("-ftm", &scc_ftm),
                 ARG_HANDLER("-finline", &scc_finline),
+                ARG_HANDLER("-fsccp", &scc_fsccp),
+                ARG_HANDLER("-fgvn", &scc_fgvn),
                 ARG_HANDLER("-emit-ssa", &scc_emit_ssa),
                 ARG_HANDLER("-emit-llvm", &scc_emit_llvm),
+                ARG_HANDLER("-emit-pch", &scc_emit_pch),
+                ARG_HANDLER("-include-pch", &scc_include_pch),
                 ARG_HANDLER("-I", &scc_I),
+                ARG_HANDLER("-llc", &scc_llc),
                 ARG_HANDLER("-l", &scc_l),
                 ARG_HANDLER("-L", &scc_L),
                 ARG_HANDLER("-D", &scc_D),
@@ -304,6 +411,8 @@ extern void scc_parse_opts(scc_env* self, int argc, const char** argv)
                 ARG_HANDLER("-m64", &scc_m64),
                 ARG_HANDLER("-O3", &scc_O3),
                 ARG_HANDLER("-g", &scc_g),
+                ARG_HANDLER("-j", &scc_j),
+                ARG_HANDLER("-pipe", &scc_pipe),
         };
         struct arg_handler src = ARG_HANDLER("", &scc_file);
         struct parser p;
@@ -11,6 +11,7 @@ extern void scc_init(scc_env* self)
         self->cc.opts.name = "scc";
         self->link_stdlib = true;
         self->mode = SRM_LINK;
+        self->failed = false;
 }
 
 extern void scc_dispose(scc_env* self)
@@ -25,6 +26,7 @@ extern void scc_error(scc_env* self, const char* format, ...)
         va_start(args, format);
         vprintf(format, args);
         printf("\n");
+        self->failed = true;
 }
 
 static void scc_add_cd_dir(scc_env* self)
@@ -71,6 +73,8 @@ extern errcode scc_setup(scc_env* self, int argc, const char** argv)
 {
         extern void scc_parse_opts(scc_env*, int, const char**);
         scc_parse_opts(self, argc, argv);
+        if (self->failed)
+                return EC_ERROR;
 
         self->cc.input.entry = self->link_stdlib ? NULL : "main";
         struct pathbuf exec_dir;
@@ -21,6 +21,8 @@ typedef struct
         cc_instance cc;
         bool link_stdlib;
         scc_run_mode mode;
+        // true if the arguments are invalid
+        bool failed;
 } scc_env;
 
 extern void scc_init(scc_env* self);
@@ -0,0 +1,134 @@
+// Compares string lookups in strhtab.inc against a hashmap keyed by string hashes
+// that resolves collisions by probing with a perturbed hash (how strings were pooled before).
+// usage: strhtab-bench [number of strings] [number of lookup rounds]
+
+#include "scc/core/alloc.h"
+#include "scc/core/hash.h"
+#include "scc/core/hashmap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STRHTAB bench_map
+#define STRHTAB_V unsigned
+#include "scc/core/strhtab.inc"
+
+typedef struct
+{
+        char** strings;
+        unsigned* sizes;
+        unsigned n;
+} bench_strings;
+
+static void bench_strings_init(bench_strings* self, unsigned n, const char* format)
+{
+        self->strings = alloc(sizeof(char*) * n);
+        self->sizes = alloc(sizeof(unsigned) * n);
+        self->n = n;
+        for (unsigned i = 0; i < n; i++)
+        {
+                char buf[128];
+                unsigned size = (unsigned)snprintf(buf, sizeof(buf), format, i, i * 2654435761U) + 1;
+                self->strings[i] = alloc(size);
+                memcpy(self->strings[i], buf, size);
+                self->sizes[i] = size;
+        }
+}
+
+static void bench_strings_drop(bench_strings* self)
+{
+        for (unsigned i = 0; i < self->n; i++)
+                dealloc(self->strings[i]);
+        dealloc(self->strings);
+        dealloc(self->sizes);
+}
+
+static struct hashmap_entry* hashmap_find_string(
+        const struct hashmap* map, const char* s, unsigned size, unsigned* key)
+{
+        unsigned ref = hash(s, size);
+        for (unsigned i = 1; ; i++)
+        {
+                struct hashmap_entry* e = hashmap_lookup(map, ref);
+                if (!e)
+                {
+                        *key = ref;
+                        return NULL;
+                }
+                const char* found = e->value;
+                if (strlen(found) + 1 == size && memcmp(found, s, size) == 0)
+                        return e;
+                ref += i;
+        }
+}
+
+static double seconds_since(clock_t start)
+{
+        return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void bench(const bench_strings* keys, const bench_strings* misses, unsigned rounds)
+{
+        unsigned found = 0;
+        struct hashmap map;
+        hashmap_init(&map);
+        clock_t start = clock();
+        for (unsigned i = 0; i < keys->n; i++)
+        {
+                unsigned key;
+                if (!hashmap_find_string(&map, keys->strings[i], keys->sizes[i], &key))
+                        hashmap_insert(&map, key, keys->strings[i]);
+        }
+        double insert_time = seconds_since(start);
+        start = clock();
+        for (unsigned r = 0; r < rounds; r++)
+                for (unsigned i = 0; i < keys->n; i++)
+                {
+                        unsigned key;
+                        found += hashmap_find_string(&map, keys->strings[i], keys->sizes[i], &key) != NULL;
+                        found += hashmap_find_string(&map, misses->strings[i], misses->sizes[i], &key) != NULL;
+                }
+        printf("hashmap:  insert %.3fs, lookup %.3fs\n", insert_time, seconds_since(start));
+        hashmap_drop(&map);
+
+        struct bench_map tab;
+        bench_map_init(&tab);
+        start = clock();
+        for (unsigned i = 0; i < keys->n; i++)
+                bench_map_insert(&tab, keys->strings[i], keys->sizes[i], i);
+        insert_time = seconds_since(start);
+        start = clock();
+        for (unsigned r = 0; r < rounds; r++)
+                for (unsigned i = 0; i < keys->n; i++)
+                {
+                        found += bench_map_lookup(&tab, keys->strings[i], keys->sizes[i]) != NULL;
+                        found += bench_map_lookup(&tab, misses->strings[i], misses->sizes[i]) != NULL;
+                }
+        printf("strhtab:  insert %.3fs, lookup %.3fs\n", insert_time, seconds_since(start));
+        bench_map_drop(&tab);
+
+        if (found != 2 * rounds * keys->n)
+                printf("error: %u strings found, %u expected\n", found, 2 * rounds * keys->n);
+}
+
+int main(int argc, const char** argv)
+{
+        unsigned n = argc > 1 ? (unsigned)atoi(argv[1]) : 200000;
+        unsigned rounds = argc > 2 ? (unsigned)atoi(argv[2]) : 20;
+
+        bench_strings ids, paths, misses;
+        bench_strings_init(&ids, n, "id_%u");
+        bench_strings_init(&paths, n, "/usr/include/scc/dir%u/file_%x.h");
+        bench_strings_init(&misses, n, "miss_%u_%x");
+
+        printf("%u identifiers, %u rounds\n", n, rounds);
+        bench(&ids, &misses, rounds);
+        printf("%u paths, %u rounds\n", n, rounds);
+        bench(&paths, &misses, rounds);
+
+        bench_strings_drop(&ids);
+        bench_strings_drop(&paths);
+        bench_strings_drop(&misses);
+        return 0;
+}